@@ -33,6 +33,7 @@
 #	include "blocks/temp.h"
 #	include "blocks/cat.h"
 #	include "blocks/disk.h"
+#	include "blocks/powercap.h"
 
 #	include "blocks-struct.h"
 
@@ -46,15 +47,29 @@ static ATTR_MAYBE_UNUSED g_block_ty g_blocks[] = {
 /* Shell script or arg */
 #	if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
 /* { .func = b_write_shell, .arg = "some_arg | other_arg ", .pad_left = "my arg:", .pad_right = " | ", .interval = 0, .signal = SIG_AUDIO }, */
+/* One run of a command for several blocks, e.g., "VPN|10.0.0.2" printed by
+ * vpn_status: its fields, split on SHELL_FIELD_SEP, go to consecutive blocks
+ * with the same interval and signal. */
+/* { .func = b_write_shell_fields, .arg = "vpn_status", .pad_left = "vpn: ", .pad_right = " ", .interval = 30, .signal = 0 }, */
+/* { .func = b_write_shell_field,  .arg = NULL,         .pad_left = "",      .pad_right = " | ", .interval = 30, .signal = 0 }, */
+#		ifdef HAVE_POSIX_SPAWN
+/* Started once: shows each line the script prints, and restarts it if it exits. */
+/* { .func = b_write_shell_persist, .arg = "my_monitor_script", .pad_left = "", .pad_right = " | ", .interval = 0, .signal = 0 }, */
+#		endif
 #	endif
 
 /* Read a file */
 /* { .func = b_write_cat, .arg = "/home/james/.xinitrc ", .pad_left = "my_file:", .pad_right = " | ", .interval = 2, .signal = 0 }, */
+/* Read it again only when it changes. */
+/* { .func = b_write_cat_watch, .arg = "/home/james/.cache/weather", .pad_left = "", .pad_right = " | ", .interval = 0, .signal = 0 }, */
 
 /* Temp file */
 #	ifdef HAVE_SYSFS
-/* If using sysfs, make sure that the path starts with /sys/devices/platform, not /sys/class. */
-/* { .func = b_write_temp, .arg = "/path/to/temp ", .pad_left = "my_temp: ", .pad_right = "° | ", .interval = 2, .signal = 0 }, */
+/* Name a hwmon sensor as chip:label (see the name and temp*_label files in
+ * /sys/class/hwmon/hwmon*), or give the path to a file. */
+/* { .func = b_write_temp, .arg = "nvme:Composite", .pad_left = "my_temp: ", .pad_right = "° | ", .interval = 2, .signal = 0 }, */
+/* Hottest (or average, with b_write_temp_avg) of all sensors of a chip. NULL means the CPU. */
+/* { .func = b_write_temp_max, .arg = "coretemp", .pad_left = "hottest: ", .pad_right = "° | ", .interval = 2, .signal = 0 }, */
 #	endif
 
 /* Webcam */
@@ -73,8 +88,8 @@ static ATTR_MAYBE_UNUSED g_block_ty g_blocks[] = {
 #	endif
 
 /* Audio volume (mic) */
-#	if defined USE_ALSA
-	{ .func = b_write_mic_vol,             .arg = NULL,          .pad_left = "",          .pad_right = "% | ", .interval = 4,    .signal = SIG_MIC    },
+#	if defined B_AUDIO
+	{ .func = b_write_mic_vol,             .arg = NULL,          .pad_left = "",          .pad_right = "% | ", .interval = 0,    .signal = SIG_MIC    },
 #	endif
 
 	/* Date */
@@ -95,18 +110,23 @@ static ATTR_MAYBE_UNUSED g_block_ty g_blocks[] = {
 /* CPU temp, usage */
 #	ifdef HAVE_PROCFS
 /* format: [temp] [usage] */
+/* .arg = NULL guesses the CPU sensor. To choose one, use e.g. "k10temp:Tctl". */
 #		ifdef HAVE_SYSFS
-	{ .func = b_write_cpu_temp,            .arg = TEMP_FILE_CPU, .pad_left = "💻 ",       .pad_right = "° ",   .interval = 2,    .signal = 0          },
+	{ .func = b_write_cpu_temp,            .arg = NULL,          .pad_left = "💻 ",       .pad_right = "° ",   .interval = 2,    .signal = 0          },
 #		endif
 	{ .func = b_write_cpu_usage,           .arg = NULL,          .pad_left = "",          .pad_right = "% ",   .interval = 2,    .signal = 0          },
 #		ifdef HAVE_POWERCAP
 	{ .func = b_write_cpu_usage_power,     .arg = NULL,          .pad_left = "",          .pad_right = "W | ", .interval = 2,    .signal = 0          },
+/* Other RAPL domains: package, core, uncore, dram, psys. */
+/* { .func = b_write_power, .arg = "dram", .pad_left = "RAM ", .pad_right = "W | ", .interval = 2, .signal = 0 }, */
 #		endif
 #	endif
 
 /* GPU temp, usage */
-#	if defined USE_CUDA
+#	if defined B_GPU
 	/* format: [temp] [usage] [vram] */
+	/* .arg = NULL averages the GPUs. To choose, use "max", "all", an index,
+	 * e.g., "0", or a UUID or PCI slot, e.g., "GPU-5f1c" or "0000:03:00.0". */
 	{ .func = b_write_gpu_temp,            .arg = NULL,          .pad_left = "🚀 ",       .pad_right = "° ",   .interval = 2,    .signal = 0          },
 	{ .func = b_write_gpu_usage,           .arg = NULL,          .pad_left = "",          .pad_right = "% ",   .interval = 2,    .signal = 0          },
 	{ .func = b_write_gpu_usage_vram,      .arg = NULL,          .pad_left = "",          .pad_right = "% ",   .interval = 2,    .signal = 0          },
@@ -114,7 +134,7 @@ static ATTR_MAYBE_UNUSED g_block_ty g_blocks[] = {
 #	endif
 
 /* Audio volume (speaker) */
-#	if defined USE_ALSA
+#	if defined B_AUDIO
 	{ .func = b_write_speaker_vol,         .arg = NULL,          .pad_left = "",          .pad_right = "% | ", .interval = 0,    .signal = SIG_AUDIO  },
 #	endif
 
@@ -18,177 +18,387 @@
 
 #include "../config.h"
 
-#ifdef USE_ALSA
+/* USE_PULSE replaces ALSA. */
+#if defined USE_ALSA && !USE_PULSE
 #	include <alsa/asoundlib.h>
 #	include <alsa/asoundef.h>
 
 #	include "../macros.h"
+#	include "defer.h"
+#	include "dl.h"
+#	include "audio-alsa.h"
+
+#	ifdef USE_DLOPEN
+#		include <pthread.h>
+
+/* libasound, resolved by b_audio_alsa_init. */
+static struct {
+	int (*snd_mixer_open)(snd_mixer_t **, int);
+	int (*snd_mixer_close)(snd_mixer_t *);
+	int (*snd_mixer_attach)(snd_mixer_t *, const char *);
+	int (*snd_mixer_selem_register)(snd_mixer_t *, struct snd_mixer_selem_regopt *, snd_mixer_class_t **);
+	int (*snd_mixer_load)(snd_mixer_t *);
+	int (*snd_mixer_selem_id_malloc)(snd_mixer_selem_id_t **);
+	void (*snd_mixer_selem_id_free)(snd_mixer_selem_id_t *);
+	void (*snd_mixer_selem_id_set_index)(snd_mixer_selem_id_t *, unsigned int);
+	void (*snd_mixer_selem_id_set_name)(snd_mixer_selem_id_t *, const char *);
+	snd_mixer_elem_t *(*snd_mixer_find_selem)(snd_mixer_t *, const snd_mixer_selem_id_t *);
+	int (*snd_mixer_selem_get_playback_volume_range)(snd_mixer_elem_t *, long *, long *);
+	int (*snd_mixer_selem_has_playback_switch)(snd_mixer_elem_t *);
+	int (*snd_mixer_selem_get_capture_volume_range)(snd_mixer_elem_t *, long *, long *);
+	int (*snd_mixer_selem_has_capture_switch)(snd_mixer_elem_t *);
+	int (*snd_mixer_handle_events)(snd_mixer_t *);
+	int (*snd_mixer_selem_get_playback_volume)(snd_mixer_elem_t *, snd_mixer_selem_channel_id_t, long *);
+	int (*snd_mixer_selem_get_capture_volume)(snd_mixer_elem_t *, snd_mixer_selem_channel_id_t, long *);
+	int (*snd_mixer_selem_get_playback_switch)(snd_mixer_elem_t *, snd_mixer_selem_channel_id_t, int *);
+	int (*snd_mixer_selem_get_capture_switch)(snd_mixer_elem_t *, snd_mixer_selem_channel_id_t, int *);
+	int (*snd_mixer_poll_descriptors_count)(snd_mixer_t *);
+	int (*snd_mixer_poll_descriptors)(snd_mixer_t *, struct pollfd *, unsigned int);
+	void (*snd_mixer_elem_set_callback)(snd_mixer_elem_t *, snd_mixer_elem_callback_t);
+	void *(*snd_mixer_elem_get_callback_private)(const snd_mixer_elem_t *);
+	void (*snd_mixer_elem_set_callback_private)(snd_mixer_elem_t *, void *);
+	const char *(*snd_strerror)(int);
+} b_alsa;
+#		define B_ALSA(fn) (b_alsa.fn)
+static int b_alsa_loaded;
+
+static void
+b_alsa_load_once(void)
+{
+	void *h = b_dl_open("libasound.so.2");
+	if (h == NULL)
+		return;
+	if (B_DL_SYM(h, b_alsa, snd_mixer_open) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_close) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_attach) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_register) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_load) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_id_malloc) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_id_free) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_id_set_index) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_id_set_name) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_find_selem) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_get_playback_volume_range) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_has_playback_switch) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_get_capture_volume_range) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_has_capture_switch) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_handle_events) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_get_playback_volume) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_get_capture_volume) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_get_playback_switch) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_selem_get_capture_switch) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_poll_descriptors_count) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_poll_descriptors) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_elem_set_callback) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_elem_get_callback_private) == -1
+	    || B_DL_SYM(h, b_alsa, snd_mixer_elem_set_callback_private) == -1
+	    || B_DL_SYM(h, b_alsa, snd_strerror) == -1)
+		return;
+	b_alsa_loaded = 1;
+}
+
+/* The speaker and the mic are opened on concurrent helper threads. */
+static int
+b_alsa_load(void)
+{
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, b_alsa_load_once);
+	return b_alsa_loaded ? 0 : -1;
+}
+#	else
+#		define B_ALSA(fn) (fn)
+#	endif
 
 #	define B_AUDIO_ALSA_PLAYBACK 1
 #	define B_AUDIO_ALSA_CAPTURE  2
 
+/* Poll descriptors of a mixer that are watched. */
+#	define B_AUDIO_ALSA_FDS_MAX 4
+
+/* One mixer per card, shared by the elements on it. */
 typedef struct {
-	const char *card;
-	const char *selem_name;
+	const char *name;
 	snd_mixer_t *handle;
-	snd_mixer_selem_id_t *sid;
-	snd_mixer_elem_t *elem;
-	long min_vol, max_vol, curr_vol;
 	int ret;
-	int init;
+	b_defer_ty defer;
+	int fds[B_AUDIO_ALSA_FDS_MAX];
+	unsigned int fds_len;
+	int watched;
+	/* The card is gone, e.g., an unplugged USB headset. */
+	int removed;
+	/* Without fds, events are handled by the first read of a tick. */
+	unsigned int events_time;
+	int events_handled;
+} b_audio_alsa_card_ty;
+
+typedef struct {
+	b_audio_alsa_card_ty *card;
+	const char *selem_name;
 	int playback_or_capture;
+	snd_mixer_elem_t *elem;
+	long min_vol, max_vol;
 	int has_mute;
-	int last_vol;
-	int last_muted;
+	/* The block refreshed on changes of elem. */
+	g_func_ty func;
+	const char *arg;
+	/* Set by the element callback. */
+	int changed;
 } b_audio_alsa_ty;
-b_audio_alsa_ty b_audio_alsa_speaker = { .card = "default", .selem_name = "Master", .playback_or_capture = B_AUDIO_ALSA_PLAYBACK },
-                b_audio_alsa_mic = { .card = "default", .selem_name = "Capture", .playback_or_capture = B_AUDIO_ALSA_CAPTURE };
 
-void
-b_audio_alsa_cleanup_one(b_audio_alsa_ty *audio_alsa)
+static int
+b_audio_alsa_card_init(void *card);
+
+static b_audio_alsa_card_ty b_audio_alsa_cards[] = {
+	{ .name = "default", .defer = B_DEFER_INIT(b_audio_alsa_card_init, &b_audio_alsa_cards[0], 1) },
+};
+
+enum { B_AUDIO_ALSA_SPEAKER, B_AUDIO_ALSA_MIC, B_AUDIO_ALSA_ELEMS };
+static b_audio_alsa_ty b_audio_alsa_elems[B_AUDIO_ALSA_ELEMS] = {
+	[B_AUDIO_ALSA_SPEAKER] = { .card = &b_audio_alsa_cards[0], .selem_name = "Master", .playback_or_capture = B_AUDIO_ALSA_PLAYBACK },
+	[B_AUDIO_ALSA_MIC] = { .card = &b_audio_alsa_cards[0], .selem_name = "Capture", .playback_or_capture = B_AUDIO_ALSA_CAPTURE },
+};
+
+static void
+b_audio_alsa_card_unwatch(b_audio_alsa_card_ty *card)
 {
-	if (audio_alsa->handle) {
-		snd_mixer_close(audio_alsa->handle);
-		audio_alsa->handle = NULL;
+	for (unsigned int i = 0; i < card->fds_len; ++i)
+		g_watch_del(card->fds[i]);
+	card->fds_len = 0;
+}
+
+static void
+b_audio_alsa_card_cleanup(b_audio_alsa_card_ty *card)
+{
+	/* Only watched from the main thread, once the init is done. */
+	if (card->watched) {
+		b_audio_alsa_card_unwatch(card);
+		card->watched = 0;
+		for (unsigned int i = 0; i < B_AUDIO_ALSA_ELEMS; ++i)
+			if (b_audio_alsa_elems[i].card == card) {
+				b_audio_alsa_elems[i].elem = NULL;
+				b_audio_alsa_elems[i].changed = 0;
+			}
 	}
-	if (audio_alsa->sid) {
-		snd_mixer_selem_id_free(audio_alsa->sid);
-		audio_alsa->sid = NULL;
+	if (card->handle) {
+		B_ALSA(snd_mixer_close)(card->handle);
+		card->handle = NULL;
 	}
-	audio_alsa->init = 0;
+	card->removed = 0;
+	card->events_handled = 0;
 }
 
 void
 b_audio_alsa_cleanup(void)
 {
-	b_audio_alsa_cleanup_one(&b_audio_alsa_speaker);
-	b_audio_alsa_cleanup_one(&b_audio_alsa_mic);
+	for (unsigned int i = 0; i < sizeof(b_audio_alsa_cards) / sizeof(b_audio_alsa_cards[0]); ++i)
+		b_audio_alsa_card_cleanup(&b_audio_alsa_cards[i]);
 }
 
-void
-b_audio_alsa_err(void)
+static void
+b_audio_alsa_err(const b_audio_alsa_ty *audio_alsa)
 {
-	fprintf(stderr, "alsa error (speaker): %s\n", snd_strerror(b_audio_alsa_speaker.ret));
-	fprintf(stderr, "alsa error (mic): %s\n", snd_strerror(b_audio_alsa_mic.ret));
+	fprintf(stderr, "alsa error (%s): %s\n", audio_alsa->selem_name, B_ALSA(snd_strerror)(audio_alsa->card->ret));
 	b_audio_alsa_cleanup();
 }
 
-int
-b_audio_alsa_init_internal(b_audio_alsa_ty *audio_alsa, const char *card, int playback_or_capture)
-{
-	audio_alsa->ret = snd_mixer_open(&audio_alsa->handle, 0);
-	if (unlikely(audio_alsa->ret != 0))
-		DIE_DO(b_audio_alsa_err());
-	audio_alsa->ret = snd_mixer_attach(audio_alsa->handle, card);
-	if (unlikely(audio_alsa->ret != 0))
-		DIE_DO(b_audio_alsa_err());
-	audio_alsa->ret = snd_mixer_selem_register(audio_alsa->handle, NULL, NULL);
-	if (unlikely(audio_alsa->ret != 0))
-		DIE_DO(b_audio_alsa_err());
-	audio_alsa->ret = snd_mixer_load(audio_alsa->handle);
-	if (unlikely(audio_alsa->ret != 0))
-		DIE_DO(b_audio_alsa_err());
-	snd_mixer_selem_id_malloc(&audio_alsa->sid);
-	if (audio_alsa->sid == NULL)
-		DIE(return -1);
-	snd_mixer_selem_id_set_index(audio_alsa->sid, 0);
-	snd_mixer_selem_id_set_name(audio_alsa->sid, audio_alsa->selem_name);
-	audio_alsa->elem = snd_mixer_find_selem(audio_alsa->handle, audio_alsa->sid);
-	if (audio_alsa->elem == NULL) {
-		b_audio_alsa_cleanup_one(audio_alsa);
+/* snd_mixer_load may block on a card that is still being set up, e.g., a
+ * USB headset or PipeWire starting with the session. */
+static int
+b_audio_alsa_card_init(void *data)
+{
+	b_audio_alsa_card_ty *card = (b_audio_alsa_card_ty *)data;
+#	ifdef USE_DLOPEN
+	if (unlikely(b_alsa_load() == -1))
 		return -1;
+#	endif
+	card->ret = B_ALSA(snd_mixer_open)(&card->handle, 0);
+	if (unlikely(card->ret != 0))
+		goto err;
+	card->ret = B_ALSA(snd_mixer_attach)(card->handle, card->name);
+	if (unlikely(card->ret != 0))
+		goto err;
+	card->ret = B_ALSA(snd_mixer_selem_register)(card->handle, NULL, NULL);
+	if (unlikely(card->ret != 0))
+		goto err;
+	card->ret = B_ALSA(snd_mixer_load)(card->handle);
+	if (unlikely(card->ret != 0))
+		goto err;
+	return 0;
+err:
+	b_audio_alsa_card_cleanup(card);
+	return -1;
+}
+
+static int
+b_audio_alsa_elem_changed(snd_mixer_elem_t *elem, unsigned int mask)
+{
+	b_audio_alsa_ty *audio_alsa = (b_audio_alsa_ty *)B_ALSA(snd_mixer_elem_get_callback_private)(elem);
+	if (mask == SND_CTL_EVENT_MASK_REMOVE)
+		audio_alsa->card->removed = 1;
+	else if (mask & SND_CTL_EVENT_MASK_VALUE)
+		audio_alsa->changed = 1;
+	return 0;
+}
+
+/* Called from the main loop when the mixer has events. */
+static int
+b_audio_alsa_event(int fd, void *data)
+{
+	b_audio_alsa_card_ty *card = (b_audio_alsa_card_ty *)data;
+	if (likely(!card->removed)) {
+		card->ret = B_ALSA(snd_mixer_handle_events)(card->handle);
+		if (unlikely(card->ret < 0))
+			card->removed = 1;
 	}
-	if (playback_or_capture == B_AUDIO_ALSA_PLAYBACK) {
-		snd_mixer_selem_get_playback_volume_range(audio_alsa->elem, &audio_alsa->min_vol, &audio_alsa->max_vol);
-		audio_alsa->has_mute = snd_mixer_selem_has_playback_switch(audio_alsa->elem);
-	} else if (audio_alsa->playback_or_capture == B_AUDIO_ALSA_CAPTURE) {
-		snd_mixer_selem_get_capture_volume_range(audio_alsa->elem, &audio_alsa->min_vol, &audio_alsa->max_vol);
-		audio_alsa->has_mute = snd_mixer_selem_has_capture_switch(audio_alsa->elem);
-	} else {
-		DIE(return -1);
+	for (unsigned int i = 0; i < B_AUDIO_ALSA_ELEMS; ++i) {
+		b_audio_alsa_ty *audio_alsa = &b_audio_alsa_elems[i];
+		if (audio_alsa->card != card || audio_alsa->elem == NULL)
+			continue;
+		if (audio_alsa->changed || card->removed) {
+			audio_alsa->changed = 0;
+			g_refresh(audio_alsa->func, audio_alsa->arg);
+		}
+	}
+	/* The fds of a removed card stay readable. Stop watching them until
+	 * the refreshed blocks reopen the mixer. */
+	if (unlikely(card->removed)) {
+		b_audio_alsa_card_unwatch(card);
+		return -1;
 	}
-	audio_alsa->init = 1;
 	return 0;
+	(void)fd;
 }
 
-int
-b_audio_alsa_init(b_audio_alsa_ty *audio_alsa)
+/* Handle the events of the card when its fds are readable, e.g., on changes
+ * from pavucontrol or the volume keys, instead of on every read. */
+static void
+b_audio_alsa_card_watch(b_audio_alsa_card_ty *card)
 {
-	return b_audio_alsa_init_internal(audio_alsa, audio_alsa->card, audio_alsa->playback_or_capture);
+	card->watched = 1;
+	struct pollfd pfds[B_AUDIO_ALSA_FDS_MAX];
+	const int count = B_ALSA(snd_mixer_poll_descriptors_count)(card->handle);
+	/* Otherwise, rely on the signals of the blocks. */
+	if (unlikely(count <= 0 || count > B_AUDIO_ALSA_FDS_MAX))
+		return;
+	const int n = B_ALSA(snd_mixer_poll_descriptors)(card->handle, pfds, (unsigned int)count);
+	for (int i = 0; i < n; ++i)
+		if (likely(g_watch_add(pfds[i].fd, b_audio_alsa_event, card) == 0))
+			card->fds[card->fds_len++] = pfds[i].fd;
 }
 
-int
-b_read_audio_alsa_vol(b_audio_alsa_ty *audio_alsa)
-{
-	if (unlikely(audio_alsa->init == 0))
-		if (unlikely(b_audio_alsa_init(audio_alsa) != 0))
-			return 1;
-	audio_alsa->ret = snd_mixer_handle_events(audio_alsa->handle);
-	if (audio_alsa->ret < 0)
-		DIE_DO(b_audio_alsa_err());
-	if (audio_alsa->playback_or_capture == B_AUDIO_ALSA_PLAYBACK)
-		audio_alsa->ret = snd_mixer_selem_get_playback_volume(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &audio_alsa->curr_vol);
-	else if (audio_alsa->playback_or_capture == B_AUDIO_ALSA_CAPTURE)
-		audio_alsa->ret = snd_mixer_selem_get_capture_volume(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &audio_alsa->curr_vol);
-	else
-		DIE(return 0);
-	if (unlikely(audio_alsa->ret != 0))
-		DIE_DO(b_audio_alsa_err());
-	if (unlikely(audio_alsa->max_vol == audio_alsa->min_vol))
-		return 0;
-	const int percent = (int)((double)100 * ((double)(audio_alsa->curr_vol - audio_alsa->min_vol) / (double)(audio_alsa->max_vol - audio_alsa->min_vol)));
-	return percent;
+/* Find the element on the loaded mixer of its card, and refresh the block
+ * func with arg when it changes. */
+static int
+b_audio_alsa_elem_init(b_audio_alsa_ty *audio_alsa, g_func_ty func, const char *arg)
+{
+	snd_mixer_selem_id_t *sid;
+	if (unlikely(B_ALSA(snd_mixer_selem_id_malloc)(&sid) != 0))
+		return -1;
+	B_ALSA(snd_mixer_selem_id_set_index)(sid, 0);
+	B_ALSA(snd_mixer_selem_id_set_name)(sid, audio_alsa->selem_name);
+	audio_alsa->elem = B_ALSA(snd_mixer_find_selem)(audio_alsa->card->handle, sid);
+	B_ALSA(snd_mixer_selem_id_free)(sid);
+	if (unlikely(audio_alsa->elem == NULL))
+		return -1;
+	if (audio_alsa->playback_or_capture == B_AUDIO_ALSA_PLAYBACK) {
+		B_ALSA(snd_mixer_selem_get_playback_volume_range)(audio_alsa->elem, &audio_alsa->min_vol, &audio_alsa->max_vol);
+		audio_alsa->has_mute = B_ALSA(snd_mixer_selem_has_playback_switch)(audio_alsa->elem);
+	} else {
+		B_ALSA(snd_mixer_selem_get_capture_volume_range)(audio_alsa->elem, &audio_alsa->min_vol, &audio_alsa->max_vol);
+		audio_alsa->has_mute = B_ALSA(snd_mixer_selem_has_capture_switch)(audio_alsa->elem);
+	}
+	audio_alsa->func = func;
+	audio_alsa->arg = arg;
+	B_ALSA(snd_mixer_elem_set_callback_private)(audio_alsa->elem, audio_alsa);
+	B_ALSA(snd_mixer_elem_set_callback)(audio_alsa->elem, b_audio_alsa_elem_changed);
+	return 0;
 }
 
-int
-b_read_audio_alsa_muted(b_audio_alsa_ty *audio_alsa)
-{
-	if (unlikely(audio_alsa->init == 0))
-		if (unlikely(b_audio_alsa_init(audio_alsa) != 0))
-			return -1;
-	if (audio_alsa->has_mute) {
-		audio_alsa->ret = snd_mixer_handle_events(audio_alsa->handle);
-		if (unlikely(audio_alsa->ret < 0))
-			DIE_DO(b_audio_alsa_err());
-		int i = 1;
-		if (audio_alsa->playback_or_capture == B_AUDIO_ALSA_PLAYBACK)
-			audio_alsa->ret = snd_mixer_selem_get_playback_switch(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &i);
-		else if (audio_alsa->playback_or_capture == B_AUDIO_ALSA_CAPTURE)
-			audio_alsa->ret = snd_mixer_selem_get_capture_switch(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &i);
-		else
-			DIE();
-		if (unlikely(audio_alsa->ret != 0))
-			DIE_DO(b_audio_alsa_err());
-		return !i;
+static int
+b_audio_alsa_ready(b_audio_alsa_ty *audio_alsa, g_func_ty func, const char *arg, unsigned short *interval)
+{
+	b_audio_alsa_card_ty *card = audio_alsa->card;
+	/* Reopen the mixer, e.g., when the headset is plugged back in. */
+	if (unlikely(card->removed)) {
+		b_audio_alsa_card_cleanup(card);
+		card->defer.state = B_DEFER_IDLE;
 	}
-	return 0;
+	if (unlikely(!b_defer_ready(&card->defer, func, arg, interval)))
+		return 0;
+	if (unlikely(!card->watched))
+		b_audio_alsa_card_watch(card);
+	if (unlikely(audio_alsa->elem == NULL)) {
+		if (unlikely(b_audio_alsa_elem_init(audio_alsa, func, arg) == -1)) {
+			fprintf(stderr, "dwmblocks-fast: alsa element not found: %s\n", audio_alsa->selem_name);
+			/* Until the card is reopened. */
+			*interval = (unsigned short)-1;
+			return 0;
+		}
+	}
+	return 1;
 }
 
 int
-b_read_mic_vol(void)
+b_speaker_ready(g_func_ty func, const char *arg, unsigned short *interval)
 {
-	return b_read_audio_alsa_vol(&b_audio_alsa_mic);
+	return b_audio_alsa_ready(&b_audio_alsa_elems[B_AUDIO_ALSA_SPEAKER], func, arg, interval);
 }
 
 int
-b_read_speaker_vol(void)
+b_mic_ready(g_func_ty func, const char *arg, unsigned short *interval)
+{
+	return b_audio_alsa_ready(&b_audio_alsa_elems[B_AUDIO_ALSA_MIC], func, arg, interval);
+}
+
+static int
+b_read_audio_alsa(b_audio_alsa_ty *audio_alsa, int *vol, int *muted)
 {
-	return b_read_audio_alsa_vol(&b_audio_alsa_speaker);
+	b_audio_alsa_card_ty *card = audio_alsa->card;
+	if (unlikely(audio_alsa->elem == NULL))
+		return -1;
+	/* Otherwise, b_audio_alsa_event keeps the mixer up to date. */
+	if (card->fds_len == 0 && (card->events_time != g_time || !card->events_handled)) {
+		card->events_time = g_time;
+		card->events_handled = 1;
+		card->ret = B_ALSA(snd_mixer_handle_events)(card->handle);
+		if (unlikely(card->ret < 0))
+			DIE_DO(b_audio_alsa_err(audio_alsa));
+	}
+	long curr_vol;
+	int on = 1;
+	if (audio_alsa->playback_or_capture == B_AUDIO_ALSA_PLAYBACK) {
+		card->ret = B_ALSA(snd_mixer_selem_get_playback_volume)(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &curr_vol);
+		if (likely(card->ret == 0) && audio_alsa->has_mute)
+			card->ret = B_ALSA(snd_mixer_selem_get_playback_switch)(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &on);
+	} else {
+		card->ret = B_ALSA(snd_mixer_selem_get_capture_volume)(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &curr_vol);
+		if (likely(card->ret == 0) && audio_alsa->has_mute)
+			card->ret = B_ALSA(snd_mixer_selem_get_capture_switch)(audio_alsa->elem, SND_MIXER_SCHN_FRONT_LEFT, &on);
+	}
+	if (unlikely(card->ret != 0))
+		DIE_DO(b_audio_alsa_err(audio_alsa));
+	*muted = !on;
+	if (unlikely(audio_alsa->max_vol == audio_alsa->min_vol))
+		*vol = 0;
+	else
+		*vol = (int)((double)100 * ((double)(curr_vol - audio_alsa->min_vol) / (double)(audio_alsa->max_vol - audio_alsa->min_vol)));
+	return 0;
 }
 
 int
-b_read_mic_muted(void)
+b_read_speaker(int *vol, int *muted)
 {
-	return b_read_audio_alsa_muted(&b_audio_alsa_mic);
+	return b_read_audio_alsa(&b_audio_alsa_elems[B_AUDIO_ALSA_SPEAKER], vol, muted);
 }
 
 int
-b_read_speaker_muted(void)
+b_read_mic(int *vol, int *muted)
 {
-	return b_read_audio_alsa_muted(&b_audio_alsa_speaker);
+	return b_read_audio_alsa(&b_audio_alsa_elems[B_AUDIO_ALSA_MIC], vol, muted);
 }
 
 #	undef B_AUDIO_ALSA_PLAYBACK
 #	undef B_AUDIO_ALSA_CAPTURE
+#	undef B_AUDIO_ALSA_FDS_MAX
 
 #endif
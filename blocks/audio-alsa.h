@@ -21,19 +21,26 @@
 
 #	include "../config.h"
 
-#	ifdef USE_ALSA
+#	if defined USE_ALSA && !USE_PULSE
+
+#		include "../dwmblocks-fast.h"
 
 /* ../blocks/audio-alsa.c */
 
+/* Return 1 if the mixer is open. Otherwise, open it on a helper thread,
+ * stop the block func with arg until it is, and return 0. */
 int
-b_read_mic_vol(void);
+b_speaker_ready(g_func_ty func, const char *arg, unsigned short *interval);
 int
-b_read_speaker_vol(void);
+b_mic_ready(g_func_ty func, const char *arg, unsigned short *interval);
+
+/* Read the volume in percent and whether the element is muted together.
+ * Return 0 on success or -1 if the element is not open. */
 int
-b_read_mic_muted(void);
+b_read_speaker(int *vol, int *muted);
 int
-b_read_speaker_muted(void);
+b_read_mic(int *vol, int *muted);
 
-#	endif /* USE_ALSA */
+#	endif /* USE_ALSA && !USE_PULSE */
 
 #endif /* B_AUDIO_ALSA_H */
@@ -0,0 +1,655 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+
+#if USE_PULSE
+#	include <stdint.h>
+#	include <stdio.h>
+#	include <stdlib.h>
+#	include <string.h>
+#	include <unistd.h>
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <limits.h>
+#	include <sys/socket.h>
+#	include <sys/time.h>
+#	include <sys/un.h>
+
+#	include "../macros.h"
+#	include "../utils.h"
+#	include "defer.h"
+#	include "audio-pulse.h"
+
+/* The native protocol of PulseAudio, also served by pipewire-pulse, with
+ * only what it takes to follow the default sink and source. Packets are a
+ * header of five big-endian u32, the first being the length, and a tagged
+ * payload. */
+#	define B_PULSE_VERSION         13
+#	define B_PULSE_HEADER_LEN      20
+#	define B_PULSE_CHANNEL_CONTROL 0xFFFFFFFFU
+#	define B_PULSE_INVALID_INDEX   0xFFFFFFFFU
+#	define B_PULSE_COOKIE_LEN      256
+#	define B_PULSE_VOLUME_NORM     0x10000U
+/* Sink and source infos carry their proplists. */
+#	define B_PULSE_BUF_LEN 65536
+
+enum {
+	B_PULSE_COMMAND_ERROR = 0,
+	B_PULSE_COMMAND_REPLY = 2,
+	B_PULSE_COMMAND_AUTH = 8,
+	B_PULSE_COMMAND_SET_CLIENT_NAME = 9,
+	B_PULSE_COMMAND_GET_SINK_INFO = 21,
+	B_PULSE_COMMAND_GET_SOURCE_INFO = 23,
+	B_PULSE_COMMAND_SUBSCRIBE = 35,
+	B_PULSE_COMMAND_SUBSCRIBE_EVENT = 66
+};
+
+#	define B_PULSE_SUBSCRIPTION_MASK_SINK   0x0001U
+#	define B_PULSE_SUBSCRIPTION_MASK_SOURCE 0x0002U
+#	define B_PULSE_SUBSCRIPTION_MASK_SERVER 0x0080U
+#	define B_PULSE_EVENT_FACILITY_MASK      0x000FU
+#	define B_PULSE_EVENT_SINK               0x0000U
+#	define B_PULSE_EVENT_SOURCE             0x0001U
+#	define B_PULSE_EVENT_SERVER             0x0007U
+
+typedef struct {
+	const unsigned char *p;
+	const unsigned char *end;
+} b_pulse_ts_ty;
+
+/* A packet handler. Return 0 to go on, 1 to stop, or -1 on error. */
+typedef int (*b_pulse_handler_ty)(uint32_t command, uint32_t tag, b_pulse_ts_ty *ts);
+
+typedef struct {
+	const char *name;
+	uint32_t command;
+	uint32_t facility;
+	/* Of the device, to match its events. */
+	uint32_t idx;
+	/* Of the query in flight, or 0. */
+	uint32_t tag;
+	/* Changed again while queried. */
+	int requery;
+	int known;
+	int vol;
+	int muted;
+	/* The block refreshed on changes. */
+	g_func_ty func;
+	const char *arg;
+} b_pulse_dev_ty;
+
+static int
+b_pulse_connect(void *unused);
+
+static struct {
+	int fd;
+	uint32_t tag;
+	int watched;
+	b_defer_ty defer;
+	unsigned int len;
+	unsigned char buf[B_PULSE_BUF_LEN];
+} b_pulse = { .fd = -1, .defer = B_DEFER_INIT(b_pulse_connect, NULL, 1) };
+
+enum { B_PULSE_SPEAKER, B_PULSE_MIC, B_PULSE_DEVS };
+static b_pulse_dev_ty b_pulse_devs[B_PULSE_DEVS] = {
+	[B_PULSE_SPEAKER] = { .name = "@DEFAULT_SINK@", .command = B_PULSE_COMMAND_GET_SINK_INFO, .facility = B_PULSE_EVENT_SINK },
+	[B_PULSE_MIC] = { .name = "@DEFAULT_SOURCE@", .command = B_PULSE_COMMAND_GET_SOURCE_INFO, .facility = B_PULSE_EVENT_SOURCE },
+};
+
+static uint32_t
+b_pulse_be32(const unsigned char *p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static unsigned char *
+b_pulse_put_be32(unsigned char *p, uint32_t v)
+{
+	*p++ = (unsigned char)(v >> 24);
+	*p++ = (unsigned char)(v >> 16);
+	*p++ = (unsigned char)(v >> 8);
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+static unsigned char *
+b_pulse_put_u32(unsigned char *p, uint32_t v)
+{
+	*p++ = 'L';
+	return b_pulse_put_be32(p, v);
+}
+
+/* s_len excludes the nul. */
+static unsigned char *
+b_pulse_put_str(unsigned char *p, const char *s, size_t s_len)
+{
+	*p++ = 't';
+	memcpy(p, s, s_len + 1);
+	return p + s_len + 1;
+}
+
+static unsigned char *
+b_pulse_put_arbitrary(unsigned char *p, const void *data, uint32_t len)
+{
+	*p++ = 'x';
+	p = b_pulse_put_be32(p, len);
+	memcpy(p, data, len);
+	return p + len;
+}
+
+/* Start a packet at pkt and return where its payload goes on. */
+static unsigned char *
+b_pulse_begin(unsigned char *pkt, uint32_t command, uint32_t *tag)
+{
+	*tag = ++b_pulse.tag;
+	/* 0 is for no query in flight. */
+	if (unlikely(*tag == 0))
+		*tag = ++b_pulse.tag;
+	unsigned char *p = b_pulse_put_u32(pkt + B_PULSE_HEADER_LEN, command);
+	return b_pulse_put_u32(p, *tag);
+}
+
+/* Fill in the header of the packet at pkt that ends at end. */
+static unsigned char *
+b_pulse_end(unsigned char *pkt, unsigned char *end)
+{
+	unsigned char *p = b_pulse_put_be32(pkt, (uint32_t)(end - pkt - B_PULSE_HEADER_LEN));
+	p = b_pulse_put_be32(p, B_PULSE_CHANNEL_CONTROL);
+	p = b_pulse_put_be32(p, 0);
+	p = b_pulse_put_be32(p, 0);
+	b_pulse_put_be32(p, 0);
+	return end;
+}
+
+static int
+b_pulse_send(const unsigned char *buf, size_t len)
+{
+	while (len) {
+		const ssize_t n = write(b_pulse.fd, buf, len);
+		if (unlikely(n == -1)) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= (size_t)n;
+	}
+	return 0;
+}
+
+static int
+b_pulse_get_u32(b_pulse_ts_ty *ts, uint32_t *v)
+{
+	if (unlikely(ts->end - ts->p < 5 || *ts->p != 'L'))
+		return -1;
+	*v = b_pulse_be32(ts->p + 1);
+	ts->p += 5;
+	return 0;
+}
+
+static int
+b_pulse_skip_str(b_pulse_ts_ty *ts)
+{
+	if (unlikely(ts->p == ts->end))
+		return -1;
+	/* A null string. */
+	if (*ts->p == 'N') {
+		++ts->p;
+		return 0;
+	}
+	if (unlikely(*ts->p != 't'))
+		return -1;
+	const unsigned char *nul = (const unsigned char *)memchr(ts->p + 1, '\0', (size_t)(ts->end - ts->p - 1));
+	if (unlikely(nul == NULL))
+		return -1;
+	ts->p = nul + 1;
+	return 0;
+}
+
+static int
+b_pulse_get_bool(b_pulse_ts_ty *ts, int *v)
+{
+	if (unlikely(ts->p == ts->end || (*ts->p != '1' && *ts->p != '0')))
+		return -1;
+	*v = *ts->p++ == '1';
+	return 0;
+}
+
+/* Skip a sample spec: format, channels and rate. */
+static int
+b_pulse_skip_sample_spec(b_pulse_ts_ty *ts)
+{
+	if (unlikely(ts->end - ts->p < 7 || *ts->p != 'a'))
+		return -1;
+	ts->p += 7;
+	return 0;
+}
+
+static int
+b_pulse_skip_channel_map(b_pulse_ts_ty *ts)
+{
+	if (unlikely(ts->end - ts->p < 2 || *ts->p != 'm' || ts->end - ts->p < 2 + ts->p[1]))
+		return -1;
+	ts->p += 2 + ts->p[1];
+	return 0;
+}
+
+/* Get the average volume of the channels in percent, like pamixer. */
+static int
+b_pulse_get_cvolume(b_pulse_ts_ty *ts, int *percent)
+{
+	if (unlikely(ts->end - ts->p < 2 || *ts->p != 'v'))
+		return -1;
+	const unsigned int channels = ts->p[1];
+	if (unlikely(channels == 0 || ts->end - ts->p < 2 + 4 * (long)channels))
+		return -1;
+	uint64_t sum = 0;
+	for (unsigned int i = 0; i < channels; ++i)
+		sum += b_pulse_be32(ts->p + 2 + 4 * i);
+	ts->p += 2 + 4 * channels;
+	*percent = (int)((sum / channels * 100 + B_PULSE_VOLUME_NORM / 2) / B_PULSE_VOLUME_NORM);
+	return 0;
+}
+
+/* Read what is available. Return 1 if something was read, 0 if nothing is
+ * available, or -1 on EOF or error. */
+static int
+b_pulse_fill(void)
+{
+	if (unlikely(b_pulse.len == sizeof(b_pulse.buf)))
+		return -1;
+	const ssize_t n = read(b_pulse.fd, b_pulse.buf + b_pulse.len, sizeof(b_pulse.buf) - b_pulse.len);
+	if (likely(n > 0)) {
+		b_pulse.len += (unsigned int)n;
+		return 1;
+	}
+	if (n == -1 && errno == EINTR)
+		return 1;
+	if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return 0;
+	return -1;
+}
+
+/* Call fn on every complete control packet that was read, until it returns
+ * nonzero. Return what it returned last, or -1 on a malformed packet. */
+static int
+b_pulse_dispatch(b_pulse_handler_ty fn)
+{
+	unsigned int off = 0;
+	int ret = 0;
+	while (ret == 0 && b_pulse.len - off >= B_PULSE_HEADER_LEN) {
+		const unsigned char *h = b_pulse.buf + off;
+		const uint32_t len = b_pulse_be32(h);
+		if (unlikely(len > sizeof(b_pulse.buf) - B_PULSE_HEADER_LEN)) {
+			ret = -1;
+			break;
+		}
+		if (b_pulse.len - off - B_PULSE_HEADER_LEN < len)
+			break;
+		off += B_PULSE_HEADER_LEN + len;
+		/* Memory blocks are for streams, which are never created. */
+		if (unlikely(b_pulse_be32(h + 4) != B_PULSE_CHANNEL_CONTROL))
+			continue;
+		b_pulse_ts_ty ts = { h + B_PULSE_HEADER_LEN, h + B_PULSE_HEADER_LEN + len };
+		uint32_t command, tag;
+		if (unlikely(b_pulse_get_u32(&ts, &command) == -1 || b_pulse_get_u32(&ts, &tag) == -1)) {
+			ret = -1;
+			break;
+		}
+		ret = fn(command, tag, &ts);
+	}
+	memmove(b_pulse.buf, b_pulse.buf + off, b_pulse.len - off);
+	b_pulse.len -= off;
+	return ret;
+}
+
+/* Join dir and file into dst of size PATH_MAX. */
+static int
+b_pulse_path_join(char *dst, const char *dir, const char *file)
+{
+	const size_t dir_len = strlen(dir);
+	const size_t file_len = strlen(file);
+	if (unlikely(dir_len + file_len + 1 > PATH_MAX))
+		return -1;
+	u_stpcpy_len(u_mempcpy(dst, dir, dir_len), file, file_len);
+	return 0;
+}
+
+/* The socket of $PULSE_SERVER, if it is local, or of $XDG_RUNTIME_DIR. */
+static int
+b_pulse_socket_path(struct sockaddr_un *addr)
+{
+	char path[PATH_MAX];
+	const char *server = getenv("PULSE_SERVER");
+	if (server) {
+		if (!strncmp(server, "unix:", S_LEN("unix:")))
+			server += S_LEN("unix:");
+		/* Remote servers are not supported. */
+		if (*server != '/' || b_pulse_path_join(path, server, "") == -1)
+			return -1;
+	} else {
+		const char *dir = getenv("XDG_RUNTIME_DIR");
+		if (dir == NULL || b_pulse_path_join(path, dir, "/pulse/native") == -1)
+			return -1;
+	}
+	const size_t len = strlen(path);
+	if (unlikely(len >= sizeof(addr->sun_path)))
+		return -1;
+	memcpy(addr->sun_path, path, len + 1);
+	return 0;
+}
+
+/* PipeWire ignores the cookie, and PulseAudio keeps it in the config dir. */
+static void
+b_pulse_cookie(unsigned char *cookie)
+{
+	memset(cookie, 0, B_PULSE_COOKIE_LEN);
+	char path[PATH_MAX];
+	const char *env = getenv("PULSE_COOKIE");
+	if (env) {
+		if (b_pulse_path_join(path, env, "") == -1)
+			return;
+	} else if ((env = getenv("XDG_CONFIG_HOME"))) {
+		if (b_pulse_path_join(path, env, "/pulse/cookie") == -1)
+			return;
+	} else if ((env = getenv("HOME"))) {
+		if (b_pulse_path_join(path, env, "/.config/pulse/cookie") == -1)
+			return;
+	} else {
+		return;
+	}
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return;
+	if (read(fd, cookie, B_PULSE_COOKIE_LEN) == -1)
+		memset(cookie, 0, B_PULSE_COOKIE_LEN);
+	close(fd);
+}
+
+static uint32_t b_pulse_name_tag;
+
+static int
+b_pulse_handshake_handle(uint32_t command, uint32_t tag, b_pulse_ts_ty *ts)
+{
+	if (unlikely(command == B_PULSE_COMMAND_ERROR))
+		return -1;
+	if (command == B_PULSE_COMMAND_REPLY && tag == b_pulse_name_tag)
+		return 1;
+	return 0;
+	(void)ts;
+}
+
+/* Connect and authenticate on a helper thread, as the server may be slow to
+ * answer while the session starts. */
+static int
+b_pulse_connect(void *unused)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	if (b_pulse_socket_path(&addr) == -1)
+		return -1;
+	b_pulse.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (unlikely(b_pulse.fd == -1))
+		return -1;
+	const struct timeval timeout = { .tv_sec = 2, .tv_usec = 0 };
+	setsockopt(b_pulse.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(b_pulse.fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	if (connect(b_pulse.fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+		goto err;
+	unsigned char pkt[2 * B_PULSE_HEADER_LEN + B_PULSE_COOKIE_LEN + 128];
+	unsigned char cookie[B_PULSE_COOKIE_LEN];
+	uint32_t tag;
+	b_pulse_cookie(cookie);
+	/* No shared memory, as no streams are created. */
+	unsigned char *p = b_pulse_begin(pkt, B_PULSE_COMMAND_AUTH, &tag);
+	p = b_pulse_put_u32(p, B_PULSE_VERSION);
+	p = b_pulse_put_arbitrary(p, cookie, B_PULSE_COOKIE_LEN);
+	unsigned char *name = b_pulse_end(pkt, p);
+	/* Sent along, as the server handles packets in order. */
+	p = b_pulse_begin(name, B_PULSE_COMMAND_SET_CLIENT_NAME, &b_pulse_name_tag);
+	*p++ = 'P';
+	p = b_pulse_put_str(p, S_LITERAL("application.name"));
+	p = b_pulse_put_u32(p, sizeof("dwmblocks-fast"));
+	p = b_pulse_put_arbitrary(p, "dwmblocks-fast", sizeof("dwmblocks-fast"));
+	*p++ = 'N';
+	p = b_pulse_end(name, p);
+	if (b_pulse_send(pkt, (size_t)(p - pkt)) == -1)
+		goto err;
+	b_pulse.len = 0;
+	for (;;) {
+		const int ret = b_pulse_dispatch(b_pulse_handshake_handle);
+		if (ret == 1)
+			break;
+		if (ret == -1 || b_pulse_fill() != 1)
+			goto err;
+	}
+	return 0;
+err:
+	close(b_pulse.fd);
+	b_pulse.fd = -1;
+	return -1;
+	(void)unused;
+}
+
+static int
+b_pulse_query(b_pulse_dev_ty *dev)
+{
+	if (dev->tag) {
+		dev->requery = 1;
+		return 0;
+	}
+	unsigned char pkt[B_PULSE_HEADER_LEN + 64];
+	unsigned char *p = b_pulse_begin(pkt, dev->command, &dev->tag);
+	p = b_pulse_put_u32(p, B_PULSE_INVALID_INDEX);
+	p = b_pulse_put_str(p, dev->name, strlen(dev->name));
+	p = b_pulse_end(pkt, p);
+	return b_pulse_send(pkt, (size_t)(p - pkt));
+}
+
+/* The sink and source infos start the same way. */
+static int
+b_pulse_dev_update(b_pulse_dev_ty *dev, b_pulse_ts_ty *ts)
+{
+	uint32_t idx, owner_module;
+	int vol, muted;
+	if (unlikely(b_pulse_get_u32(ts, &idx) == -1
+	             || b_pulse_skip_str(ts) == -1
+	             || b_pulse_skip_str(ts) == -1
+	             || b_pulse_skip_sample_spec(ts) == -1
+	             || b_pulse_skip_channel_map(ts) == -1
+	             || b_pulse_get_u32(ts, &owner_module) == -1
+	             || b_pulse_get_cvolume(ts, &vol) == -1
+	             || b_pulse_get_bool(ts, &muted) == -1))
+		return -1;
+	const int changed = !dev->known || vol != dev->vol || muted != dev->muted;
+	dev->idx = idx;
+	dev->vol = vol;
+	dev->muted = muted;
+	dev->known = 1;
+	if (changed && dev->func)
+		g_refresh(dev->func, dev->arg);
+	return 0;
+}
+
+static int
+b_pulse_handle(uint32_t command, uint32_t tag, b_pulse_ts_ty *ts)
+{
+	if (command == B_PULSE_COMMAND_SUBSCRIBE_EVENT) {
+		uint32_t type, idx;
+		if (unlikely(b_pulse_get_u32(ts, &type) == -1 || b_pulse_get_u32(ts, &idx) == -1))
+			return -1;
+		const uint32_t facility = type & B_PULSE_EVENT_FACILITY_MASK;
+		for (unsigned int i = 0; i < B_PULSE_DEVS; ++i) {
+			b_pulse_dev_ty *dev = &b_pulse_devs[i];
+			/* Also when the default sink or source may have changed. */
+			if (facility == B_PULSE_EVENT_SERVER || (facility == dev->facility && idx == dev->idx))
+				if (unlikely(b_pulse_query(dev) == -1))
+					return -1;
+		}
+		return 0;
+	}
+	if (command != B_PULSE_COMMAND_REPLY && command != B_PULSE_COMMAND_ERROR)
+		return 0;
+	for (unsigned int i = 0; i < B_PULSE_DEVS; ++i) {
+		b_pulse_dev_ty *dev = &b_pulse_devs[i];
+		if (dev->tag != tag)
+			continue;
+		dev->tag = 0;
+		if (command == B_PULSE_COMMAND_ERROR) {
+			/* No such device, e.g., no mic. Render empty. */
+			dev->known = 0;
+			dev->idx = B_PULSE_INVALID_INDEX;
+			if (dev->func)
+				g_refresh(dev->func, dev->arg);
+		} else if (unlikely(b_pulse_dev_update(dev, ts) == -1)) {
+			return -1;
+		}
+		if (dev->requery) {
+			dev->requery = 0;
+			if (unlikely(b_pulse_query(dev) == -1))
+				return -1;
+		}
+		break;
+	}
+	return 0;
+}
+
+static void
+b_pulse_close(void)
+{
+	if (b_pulse.watched)
+		g_watch_del(b_pulse.fd);
+	close(b_pulse.fd);
+	b_pulse.fd = -1;
+	b_pulse.watched = 0;
+	b_pulse.len = 0;
+	for (unsigned int i = 0; i < B_PULSE_DEVS; ++i) {
+		b_pulse_devs[i].known = 0;
+		b_pulse_devs[i].tag = 0;
+		b_pulse_devs[i].requery = 0;
+	}
+	/* Reconnect with the backoff of the deferred init. */
+	b_pulse.defer.state = B_DEFER_IDLE;
+}
+
+/* E.g., the server restarted. */
+static void
+b_pulse_disconnect(void)
+{
+	b_pulse_close();
+	for (unsigned int i = 0; i < B_PULSE_DEVS; ++i)
+		if (b_pulse_devs[i].func)
+			g_refresh(b_pulse_devs[i].func, b_pulse_devs[i].arg);
+}
+
+/* Called from the main loop when the server sends something. */
+static int
+b_pulse_event(int fd, void *unused)
+{
+	for (;;) {
+		const int ret = b_pulse_fill();
+		if (ret == 0)
+			return 0;
+		if (unlikely(ret == -1 || b_pulse_dispatch(b_pulse_handle) == -1)) {
+			b_pulse_disconnect();
+			return -1;
+		}
+	}
+	(void)fd;
+	(void)unused;
+}
+
+/* Subscribe to the changes of sinks, sources and the server, and query the
+ * default sink and source. */
+static int
+b_pulse_watch(void)
+{
+	fcntl(b_pulse.fd, F_SETFL, fcntl(b_pulse.fd, F_GETFL) | O_NONBLOCK);
+	if (unlikely(g_watch_add(b_pulse.fd, b_pulse_event, NULL) == -1))
+		return -1;
+	b_pulse.watched = 1;
+	unsigned char pkt[B_PULSE_HEADER_LEN + 32];
+	uint32_t tag;
+	unsigned char *p = b_pulse_begin(pkt, B_PULSE_COMMAND_SUBSCRIBE, &tag);
+	p = b_pulse_put_u32(p, B_PULSE_SUBSCRIPTION_MASK_SINK | B_PULSE_SUBSCRIPTION_MASK_SOURCE | B_PULSE_SUBSCRIPTION_MASK_SERVER);
+	p = b_pulse_end(pkt, p);
+	if (unlikely(b_pulse_send(pkt, (size_t)(p - pkt)) == -1))
+		return -1;
+	for (unsigned int i = 0; i < B_PULSE_DEVS; ++i) {
+		b_pulse_devs[i].idx = B_PULSE_INVALID_INDEX;
+		if (unlikely(b_pulse_query(&b_pulse_devs[i]) == -1))
+			return -1;
+	}
+	return 0;
+}
+
+static int
+b_pulse_ready(b_pulse_dev_ty *dev, g_func_ty func, const char *arg, unsigned short *interval)
+{
+	dev->func = func;
+	dev->arg = arg;
+	if (unlikely(!b_defer_ready(&b_pulse.defer, func, arg, interval)))
+		return 0;
+	if (unlikely(!b_pulse.watched) && unlikely(b_pulse_watch() == -1)) {
+		b_pulse_close();
+		*interval = 60;
+		return 0;
+	}
+	if (unlikely(!dev->known)) {
+		/* Until its info arrives, or the device appears. */
+		*interval = (unsigned short)-1;
+		return 0;
+	}
+	return 1;
+}
+
+int
+b_speaker_ready(g_func_ty func, const char *arg, unsigned short *interval)
+{
+	return b_pulse_ready(&b_pulse_devs[B_PULSE_SPEAKER], func, arg, interval);
+}
+
+int
+b_mic_ready(g_func_ty func, const char *arg, unsigned short *interval)
+{
+	return b_pulse_ready(&b_pulse_devs[B_PULSE_MIC], func, arg, interval);
+}
+
+static int
+b_pulse_read(const b_pulse_dev_ty *dev, int *vol, int *muted)
+{
+	if (unlikely(!dev->known))
+		return -1;
+	*vol = dev->vol;
+	*muted = dev->muted;
+	return 0;
+}
+
+int
+b_read_speaker(int *vol, int *muted)
+{
+	return b_pulse_read(&b_pulse_devs[B_PULSE_SPEAKER], vol, muted);
+}
+
+int
+b_read_mic(int *vol, int *muted)
+{
+	return b_pulse_read(&b_pulse_devs[B_PULSE_MIC], vol, muted);
+}
+
+#endif /* USE_PULSE */
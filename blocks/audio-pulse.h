@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_AUDIO_PULSE_H
+#	define B_AUDIO_PULSE_H 1
+
+#	include "../config.h"
+
+#	if USE_PULSE
+
+#		include "../dwmblocks-fast.h"
+
+/* ../blocks/audio-pulse.c */
+
+/* The interface of audio-alsa.h, for the default sink and source of a
+ * PulseAudio or PipeWire server. */
+
+/* Return 1 if the volume is known. Otherwise, connect on a helper thread,
+ * stop the block func with arg until the volume arrives, and return 0. */
+int
+b_speaker_ready(g_func_ty func, const char *arg, unsigned short *interval);
+int
+b_mic_ready(g_func_ty func, const char *arg, unsigned short *interval);
+
+/* Read the volume in percent and whether the device is muted. Return 0 on
+ * success or -1 if the volume is not known. */
+int
+b_read_speaker(int *vol, int *muted);
+int
+b_read_mic(int *vol, int *muted);
+
+#	endif /* USE_PULSE */
+
+#endif /* B_AUDIO_PULSE_H */
@@ -18,28 +18,32 @@
 
 #include "../config.h"
 #include "procfs.h"
+#include "fdpool.h"
+#include "audio.h"
 
-#ifdef USE_ALSA
+#ifdef B_AUDIO
 #	include "../blocks/audio-alsa.h"
+#	include "../blocks/audio-pulse.h"
 #	include "../utils.h"
 #	include "../config.h"
 
 char *
 b_write_speaker_vol(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
 {
+	if (unlikely(!b_speaker_ready(b_write_speaker_vol, unused, interval)))
+		return dst;
+	int vol, muted;
+	if (unlikely(b_read_speaker(&vol, &muted) == -1)) {
+		*interval = 60;
+		return dst;
+	}
 	char *p = dst;
-	const int muted = b_read_speaker_muted();
-	if (likely(!muted)) {
+	if (likely(!muted))
 		p = u_stpcpy_len(p, S_LITERAL(ICON_AUDIO_SPEAKER_ON));
-	} else {
-		if (unlikely(muted == -1)) {
-			*interval = 60;
-			return dst;
-		}
+	else
 		p = u_stpcpy_len(p, S_LITERAL(ICON_AUDIO_SPEAKER_OFF));
-	}
 	*p++ = ' ';
-	p = u_utoa_le3_p((unsigned int)b_read_speaker_vol(), p);
+	p = u_utoa_le3_p((unsigned int)vol, p);
 	return p;
 	(void)dst_size;
 	(void)unused;
@@ -49,23 +53,21 @@ b_write_speaker_vol(char *dst, unsigned int dst_size, const char *unused, unsign
 char *
 b_write_mic_vol(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
 {
+	if (unlikely(!b_mic_ready(b_write_mic_vol, unused, interval)))
+		return dst;
+	int vol, muted;
+	if (unlikely(b_read_mic(&vol, &muted) == -1)) {
+		*interval = 4;
+		return dst;
+	}
 	char *p = dst;
-	const int muted = b_read_mic_muted();
 	if (!muted) {
 		p = u_stpcpy_len(p, S_LITERAL(ICON_AUDIO_MIC_ON));
 	} else {
-		*interval = 4;
-		if (unlikely(muted == -1))
-			return dst;
 		if (S_LEN(ICON_AUDIO_MIC_OFF) == 0)
 			return dst;
 		p = u_stpcpy_len(p, S_LITERAL(ICON_AUDIO_MIC_OFF));
 	}
-	int vol = b_read_mic_vol();
-	if (unlikely(vol == 1)) {
-		*interval = 4;
-		return dst;
-	}
 	*p++ = ' ';
 	p = u_utoa_le3_p((unsigned int)vol, p);
 	return p;
@@ -80,7 +82,7 @@ char *
 b_write_mic_exists(char *dst, unsigned int dst_size, const char *name, unsigned short *interval)
 {
 	char buf[B_PAGE_SIZE + 1];
-	unsigned int read_sz = b_proc_read_file(buf, sizeof(buf), "/proc/asound/cards");
+	unsigned int read_sz = b_fdpool_read(buf, sizeof(buf), "/proc/asound/cards");
 	if (unlikely(read_sz == (unsigned int)-1))
 		DIE(return NULL);
 	const size_t name_len = strlen(name);
@@ -21,7 +21,12 @@
 
 #	include "../config.h"
 
-#	if defined USE_ALSA
+/* The volume of the speaker and the mic, from PulseAudio or ALSA. */
+#	if USE_PULSE || defined USE_ALSA
+#		define B_AUDIO 1
+#	endif
+
+#	ifdef B_AUDIO
 
 /* ../blocks/audio.c */
 
@@ -30,7 +35,7 @@ b_write_speaker_vol(char *dst, unsigned int dst_size, const char *unused, unsign
 char *
 b_write_mic_vol(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
 
-#	endif /* USE_ALSA */
+#	endif /* B_AUDIO */
 
 char *
 b_write_mic_exists(char *dst, unsigned int dst_size, const char *name, unsigned short *interval);
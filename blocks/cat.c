@@ -19,17 +19,189 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 
 #include "../macros.h"
+#include "../config.h"
+#include "../dwmblocks-fast.h"
+#include "fdpool.h"
+#include "cat.h"
+
+#ifdef HAVE_INOTIFY
+#	include <sys/inotify.h>
+#endif
 
 char *
 b_write_cat(char *dst, unsigned int dst_size, const char *filename, unsigned short *interval)
 {
 	if (unlikely(dst_size == 0))
 		return dst;
-	const int fd = open(filename, O_RDONLY);
-	if (unlikely(fd == -1))
+	int read_sz;
+	/* Kernel files can be reread in place. Regular files may be replaced
+	 * by a rename, so they are reopened each time. */
+	if (!strncmp(filename, "/proc/", S_LEN("/proc/")) || !strncmp(filename, "/sys/", S_LEN("/sys/"))) {
+		read_sz = (int)b_fdpool_pread(filename, dst, dst_size - 1);
+	} else {
+		const int fd = open(filename, O_RDONLY);
+		if (unlikely(fd == -1))
+			DIE(return NULL);
+		read_sz = read(fd, dst, dst_size - 1);
+		if (unlikely(close(fd) == -1))
+			DIE(return NULL);
+	}
+	if (unlikely(read_sz == -1))
 		DIE(return NULL);
+	const char *nl = memchr(dst, '\n', read_sz);
+	if (nl)
+		read_sz = nl - dst;
+	*(dst + read_sz) = '\0';
+	return dst + read_sz;
+	(void)dst_size;
+	(void)interval;
+}
+
+#ifdef HAVE_INOTIFY
+
+/* Files of b_write_cat_watch. */
+#	define B_CAT_WATCH_MAX 16
+
+/* The directory of a file is watched rather than the file, so that a file
+ * that is replaced by a rename, or created later, is still followed. */
+typedef struct {
+	const char *filename;
+	/* Last component of filename. */
+	const char *name;
+	/* Watch on the directory, or -1. */
+	int wd;
+} b_cat_watch_ty;
+
+static b_cat_watch_ty b_cat_watches[B_CAT_WATCH_MAX];
+static unsigned int b_cat_watches_len;
+static int b_cat_fd = -1;
+
+static int
+b_cat_read_events(int fd, void *unused)
+{
+	union {
+		struct inotify_event ev;
+		char buf[4096];
+	} u;
+	for (;;) {
+		const ssize_t read_sz = read(fd, u.buf, sizeof(u.buf));
+		if (read_sz == -1) {
+			if (likely(errno == EAGAIN))
+				break;
+			if (errno == EINTR)
+				continue;
+			/* Fall back to polling. */
+			close(fd);
+			b_cat_fd = -1;
+			for (unsigned int i = 0; i < b_cat_watches_len; ++i) {
+				b_cat_watches[i].wd = -1;
+				g_refresh(b_write_cat_watch, b_cat_watches[i].filename);
+			}
+			return -1;
+		}
+		for (ssize_t off = 0; off < read_sz;) {
+			const struct inotify_event *ev = (const struct inotify_event *)(u.buf + off);
+			off += (ssize_t)sizeof(*ev) + ev->len;
+			for (unsigned int i = 0; i < b_cat_watches_len; ++i) {
+				b_cat_watch_ty *w = &b_cat_watches[i];
+				/* Lost events. */
+				if (ev->mask & IN_Q_OVERFLOW) {
+					g_refresh(b_write_cat_watch, w->filename);
+					continue;
+				}
+				if (ev->wd != w->wd)
+					continue;
+				/* The directory is gone. Watched again, or polled,
+				 * when the block is run. */
+				if (ev->mask & IN_IGNORED) {
+					w->wd = -1;
+					g_refresh(b_write_cat_watch, w->filename);
+					continue;
+				}
+				if (ev->len && !strcmp(ev->name, w->name))
+					g_refresh(b_write_cat_watch, w->filename);
+			}
+		}
+	}
+	return 0;
+	(void)unused;
+}
+
+/* Watch the directory of filename. Return 0 if it is watched. */
+static int
+b_cat_watch(const char *filename)
+{
+	/* Kernel files do not send events. */
+	if (!strncmp(filename, "/proc/", S_LEN("/proc/")) || !strncmp(filename, "/sys/", S_LEN("/sys/")))
+		return -1;
+	b_cat_watch_ty *w = NULL;
+	for (unsigned int i = 0; i < b_cat_watches_len; ++i)
+		if (b_cat_watches[i].filename == filename) {
+			w = &b_cat_watches[i];
+			break;
+		}
+	if (w && w->wd != -1)
+		return 0;
+	if (b_cat_fd == -1) {
+		b_cat_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (unlikely(b_cat_fd == -1))
+			return -1;
+		if (unlikely(g_watch_add(b_cat_fd, b_cat_read_events, NULL) == -1)) {
+			close(b_cat_fd);
+			b_cat_fd = -1;
+			return -1;
+		}
+	}
+	if (w == NULL) {
+		if (unlikely(b_cat_watches_len == B_CAT_WATCH_MAX))
+			return -1;
+		w = &b_cat_watches[b_cat_watches_len++];
+		w->filename = filename;
+		const char *slash = strrchr(filename, '/');
+		w->name = slash ? slash + 1 : filename;
+	}
+	char dir[4096];
+	const size_t dir_len = (size_t)(w->name - filename);
+	if (dir_len == 0) {
+		memcpy(dir, ".", 2);
+	} else if (dir_len == 1) {
+		memcpy(dir, "/", 2);
+	} else {
+		if (unlikely(dir_len > sizeof(dir)))
+			return -1;
+		/* Without the last slash. */
+		memcpy(dir, filename, dir_len - 1);
+		dir[dir_len - 1] = '\0';
+	}
+	/* Writers that replace the file rename a temporary file over it. */
+	w->wd = inotify_add_watch(b_cat_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR);
+	return w->wd == -1 ? -1 : 0;
+}
+
+#endif /* HAVE_INOTIFY */
+
+char *
+b_write_cat_watch(char *dst, unsigned int dst_size, const char *filename, unsigned short *interval)
+{
+	if (unlikely(dst_size == 0))
+		return dst;
+	/* Changes of the file trigger a refresh. No need to poll. */
+#ifdef HAVE_INOTIFY
+	*interval = (b_cat_watch(filename) == 0) ? (unsigned short)-1 : INTERVAL_CAT;
+#else
+	*interval = INTERVAL_CAT;
+#endif
+	if (!strncmp(filename, "/proc/", S_LEN("/proc/")) || !strncmp(filename, "/sys/", S_LEN("/sys/")))
+		return b_write_cat(dst, dst_size, filename, interval);
+	/* Not written yet, or removed. */
+	const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		*dst = '\0';
+		return dst;
+	}
 	int read_sz = read(fd, dst, dst_size - 1);
 	if (unlikely(close(fd) == -1))
 		DIE(return NULL);
@@ -40,6 +212,4 @@ b_write_cat(char *dst, unsigned int dst_size, const char *filename, unsigned sho
 		read_sz = nl - dst;
 	*(dst + read_sz) = '\0';
 	return dst + read_sz;
-	(void)dst_size;
-	(void)interval;
 }
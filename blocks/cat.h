@@ -23,5 +23,9 @@
 
 char *
 b_write_cat(char *dst, unsigned int dst_size, const char *filename, unsigned short *interval);
+/* Same as b_write_cat, but only run again when the file is written, or
+ * replaced by a rename, as seen by inotify. An absent file renders empty. */
+char *
+b_write_cat_watch(char *dst, unsigned int dst_size, const char *filename, unsigned short *interval);
 
 #endif /* B_CAT_H */
@@ -28,21 +28,8 @@
 #include "../utils.h"
 #include "../blocks/temp.h"
 #include "procfs.h"
-
-#define SIZE_T_MAX_DIGITS 20
-
-static int fd_cpu_usage = -1;
-static int fd_cpu_usage_power = -1;
-static int fd_cpu_temp = -1;
-
-static int
-b_cpu_init(const char *filename)
-{
-	int fd = -1;
-	for (int retry = 10; (fd = open(filename, O_RDONLY)) < 0 && retry; --retry)
-		sleep(1);
-	return fd;
-}
+#include "fdpool.h"
+#include "powercap.h"
 
 typedef struct {
 	unsigned long long user, nice, system, idle, iowait, irq, softirq;
@@ -50,17 +37,13 @@ typedef struct {
 	unsigned long long cpu_time;
 } time_ty;
 static time_ty last;
+static int b_cpu_primed;
 
 static int
 b_read_cpu_usage(void)
 {
-	if (unlikely(fd_cpu_usage == -1)) {
-		fd_cpu_usage = b_cpu_init("/proc/stat");
-		if (unlikely(fd_cpu_usage < 0))
-			DIE(return -1);
-	}
 	char buf[B_PAGE_SIZE + 1];
-	const unsigned int read_sz = b_proc_read_filefd(buf, sizeof(buf), fd_cpu_usage);
+	const unsigned int read_sz = b_fdpool_read(buf, sizeof(buf), "/proc/stat");
 	if (unlikely(read_sz == (unsigned int)-1))
 		DIE(return -1);
 	time_ty curr;
@@ -79,68 +62,61 @@ b_read_cpu_usage(void)
 	curr.cpu_time = curr.user + curr.nice + curr.system + curr.irq + curr.softirq;
 	if (unlikely(curr.time == 0))
 		return 0;
+	/* Usage since boot is meaningless. */
+	if (unlikely(!b_cpu_primed)) {
+		b_cpu_primed = 1;
+		last = curr;
+		return 0;
+	}
+	if (unlikely(curr.time == last.time))
+		return 0;
 	const int usage = (int)((long double)100 * ((long double)(curr.cpu_time - last.cpu_time) / (long double)(curr.time - last.time)));
 	last = curr;
 	return usage;
 }
 
-static unsigned long long last_energy;
-static unsigned long long energy_max_range;
-static struct timespec last_clock;
+int
+b_cpu_usage_prime(void)
+{
+	if (b_cpu_primed)
+		return 0;
+	if (unlikely(b_read_cpu_usage() == -1))
+		return -1;
+	return 1;
+}
 
-/* Return energy consumed in uJ between two RAPL counter snapshots,
- * correcting for the wrap of the counter at max_range_uj.
- * Tested by tests/test-edge-cases.c. */
-unsigned long long
-b_cpu_energy_diff(unsigned long long curr, unsigned long long prev, unsigned long long max_range_uj)
+char *
+b_cpu_usage_save(char *dst)
 {
-	return (curr >= prev) ? curr - prev : curr + max_range_uj - prev;
+	if (!b_cpu_primed)
+		return dst;
+	dst = u_stpcpy_len(dst, S_LITERAL("cpu "));
+	dst = u_ulltoa_p(last.time, dst);
+	*dst++ = ' ';
+	dst = u_ulltoa_p(last.cpu_time, dst);
+	*dst++ = '\n';
+	return dst;
 }
 
-static int
-b_read_cpu_usage_power(void)
+int
+b_cpu_usage_load(const char *s)
 {
-	if (unlikely(fd_cpu_usage_power == -1)) {
-		fd_cpu_usage_power = b_cpu_init("/sys/class/powercap/intel-rapl/intel-rapl:0/energy_uj");
-		if (unlikely(fd_cpu_usage_power < 0)) {
-			fd_cpu_usage_power = -2;
-			return 0;
-		}
-		const int fd_range = b_cpu_init("/sys/class/powercap/intel-rapl/intel-rapl:0/max_energy_range_uj");
-		if (unlikely(fd_range < 0)) {
-			close(fd_cpu_usage_power);
-			fd_cpu_usage_power = -2;
-			return 0;
-		}
-		char rbuf[SIZE_T_MAX_DIGITS + 1];
-		const unsigned int rsz = b_proc_read_filefd(rbuf, sizeof(rbuf), fd_range);
-		if (unlikely(rsz == (unsigned int)-1)) {
-			close(fd_range);
-			close(fd_cpu_usage_power);
-			fd_cpu_usage_power = -2;
-			return 0;
-		}
-		const char *unused_range;
-		energy_max_range = u_strtoull10(rbuf, &unused_range);
-		if (unlikely(close(fd_range) == -1))
-			DIE(return -1);
-	}
-	if (unlikely(fd_cpu_usage_power == -2))
-		return 0;
-	char buf[SIZE_T_MAX_DIGITS + 1];
-	const unsigned int read_sz = b_proc_read_filefd(buf, sizeof(buf), fd_cpu_usage_power);
-	if (unlikely(read_sz == (unsigned int)-1))
-		DIE(return -1);
-	const char *unused;
-	struct timespec curr_clock;
-	if (unlikely(clock_gettime(CLOCK_MONOTONIC, &curr_clock) != 0))
-		DIE(return -1);
-	const unsigned long long curr_energy = u_strtoull10(buf, &unused);
-	const double clock_diff = (double)(curr_clock.tv_sec - last_clock.tv_sec) + (double)(curr_clock.tv_nsec - last_clock.tv_nsec) / 1000000000;
-	const unsigned long long energy_diff = b_cpu_energy_diff(curr_energy, last_energy, energy_max_range);
-	last_energy = curr_energy;
-	last_clock = curr_clock;
-	return (int)((double)energy_diff / (clock_diff * 1000000.0));
+	time_ty t;
+	if (!u_isdigit(*s))
+		return -1;
+	t.time = u_strtoull10(s, &s);
+	if (*s++ != ' ' || !u_isdigit(*s))
+		return -1;
+	t.cpu_time = u_strtoull10(s, &s);
+	if ((*s != '\n' && *s != '\0') || t.cpu_time > t.time)
+		return -1;
+	/* A baseline from /proc/stat is already better. */
+	if (b_cpu_primed)
+		return 1;
+	last.time = t.time;
+	last.cpu_time = t.cpu_time;
+	b_cpu_primed = 1;
+	return 0;
 }
 
 char *
@@ -162,23 +138,14 @@ b_write_cpu_usage(char *dst, unsigned int dst_size, const char *unused, unsigned
 char *
 b_write_cpu_usage_power(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
 {
-	char *p = dst;
-	const int usage = b_read_cpu_usage_power();
-	p = u_utoa_le3_p((unsigned int)usage, p);
-	return p;
-	(void)dst_size;
+	/* Sum of the package domains. */
+	return b_write_power(dst, dst_size, NULL, interval);
 	(void)unused;
-	(void)interval;
 }
 
 char *
 b_write_cpu_temp(char *dst, unsigned int dst_size, const char *temp_file, unsigned short *interval)
 {
-	if (unlikely(fd_cpu_temp == -1)) {
-		fd_cpu_temp = b_cpu_init(temp_file);
-		if (unlikely(fd_cpu_temp < 0))
-			DIE(return NULL);
-	}
-	return b_write_tempfd(dst, dst_size, fd_cpu_temp, interval);
-	(void)temp_file;
+	/* NULL finds the CPU sensor. */
+	return b_write_temp(dst, dst_size, temp_file, interval);
 }
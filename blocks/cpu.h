@@ -25,6 +25,19 @@
 
 /* ../blocks/cpu.c */
 
+/* Take the first sample of b_write_cpu_usage. Return 1 if one was taken,
+ * 0 if it had been, or -1 on error. */
+int
+b_cpu_usage_prime(void);
+/* Write the last sample as "cpu <time> <cpu_time>\n" and return the end.
+ * Async-signal-safe. */
+char *
+b_cpu_usage_save(char *dst);
+/* Restore a sample from the text after "cpu ". Return 0 if it was
+ * restored, 1 if it was ignored because one had been taken, or -1 if it
+ * is malformed. */
+int
+b_cpu_usage_load(const char *s);
 char *
 b_write_cpu_temp(char *dst, unsigned int dst_size, const char *temp_file, unsigned short *interval);
 char *
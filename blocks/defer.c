@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../macros.h"
+#include "../dwmblocks-fast.h"
+#include "defer.h"
+
+/* Helper threads write their b_defer_ty * here when they are done, to be
+ * picked up by the main loop. */
+static int b_defer_pipe[2] = { -1, -1 };
+
+static int
+b_defer_pipe_init(void);
+
+static void
+b_defer_waiter_add(b_defer_ty *d, g_func_ty func, const char *arg, unsigned short *interval)
+{
+	for (unsigned int i = 0; i < d->waiters_len; ++i)
+		if (d->waiters[i].func == func && d->waiters[i].arg == arg && d->waiters[i].interval == interval) {
+			*interval = (unsigned short)-1;
+			return;
+		}
+	/* Poll instead. */
+	if (unlikely(d->waiters_len == B_DEFER_WAITERS_MAX)) {
+		*interval = 1;
+		return;
+	}
+	d->waiters[d->waiters_len].func = func;
+	d->waiters[d->waiters_len].arg = arg;
+	d->waiters[d->waiters_len].interval = interval;
+	++d->waiters_len;
+	/* Stop until refreshed. */
+	*interval = (unsigned short)-1;
+}
+
+static void
+b_defer_done(b_defer_ty *d, int ret)
+{
+	if (ret == 0) {
+		d->state = B_DEFER_DONE;
+		d->backoff = 0;
+		return;
+	}
+	d->state = B_DEFER_IDLE;
+	d->backoff = d->backoff ? MIN(d->backoff * 2, B_DEFER_BACKOFF_MAX) : 1;
+	d->retry_time = g_time + d->backoff;
+}
+
+static void *
+b_defer_thread(void *data)
+{
+	b_defer_ty *d = (b_defer_ty *)data;
+	d->ret = d->fn(d->data);
+	/* Atomic, as it is less than PIPE_BUF. */
+	while (write(b_defer_pipe[1], &d, sizeof(d)) == -1 && errno == EINTR)
+		;
+	return NULL;
+}
+
+/* Called from the main loop. */
+static int
+b_defer_watch(int fd, void *unused)
+{
+	b_defer_ty *d;
+	while (read(fd, &d, sizeof(d)) == sizeof(d)) {
+		/* Also makes d->ret and what fn initialized visible. */
+		pthread_join(d->thread, NULL);
+		b_defer_done(d, d->ret);
+		for (unsigned int i = 0; i < d->waiters_len; ++i) {
+			/* A refresh runs the block but keeps its interval, which
+			 * would leave it stopped. Make it due on the next tick,
+			 * after which it is back on its own interval, unless it
+			 * backs off again. */
+			*d->waiters[i].interval = 0;
+			g_refresh(d->waiters[i].func, d->waiters[i].arg);
+		}
+		d->waiters_len = 0;
+	}
+	return 0;
+	(void)unused;
+}
+
+static int
+b_defer_pipe_init(void)
+{
+	if (b_defer_pipe[0] != -1)
+		return 0;
+	if (pipe(b_defer_pipe) == -1)
+		return -1;
+	for (unsigned int i = 0; i < 2; ++i)
+		fcntl(b_defer_pipe[i], F_SETFD, FD_CLOEXEC);
+	fcntl(b_defer_pipe[0], F_SETFL, O_NONBLOCK);
+	if (g_watch_add(b_defer_pipe[0], b_defer_watch, NULL) == -1) {
+		close(b_defer_pipe[0]);
+		close(b_defer_pipe[1]);
+		b_defer_pipe[0] = b_defer_pipe[1] = -1;
+		return -1;
+	}
+	return 0;
+}
+
+static int
+b_defer_start(b_defer_ty *d)
+{
+	if (b_defer_pipe_init() == -1)
+		return -1;
+	/* Signals are for the main thread. */
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	const int ret = pthread_create(&d->thread, NULL, b_defer_thread, d);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	return ret ? -1 : 0;
+}
+
+int
+b_defer_due(const b_defer_ty *d)
+{
+	if (d->state != B_DEFER_IDLE)
+		return 0;
+	return !(d->backoff && (int)(d->retry_time - g_time) > 0);
+}
+
+int
+b_defer_ready(b_defer_ty *d, g_func_ty func, const char *arg, unsigned short *interval)
+{
+	switch (d->state) {
+	case B_DEFER_DONE:
+		return 1;
+	case B_DEFER_RUNNING:
+		b_defer_waiter_add(d, func, arg, interval);
+		return 0;
+	case B_DEFER_IDLE:
+		break;
+	}
+	/* Backing off. */
+	if (d->backoff && (int)(d->retry_time - g_time) > 0) {
+		*interval = (unsigned short)(d->retry_time - g_time);
+		return 0;
+	}
+	if (d->async && b_defer_start(d) == 0) {
+		d->state = B_DEFER_RUNNING;
+		b_defer_waiter_add(d, func, arg, interval);
+		return 0;
+	}
+	/* No helper thread. */
+	b_defer_done(d, d->fn(d->data));
+	if (d->state == B_DEFER_DONE)
+		return 1;
+	*interval = d->backoff;
+	return 0;
+}
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_DEFER_H
+#	define B_DEFER_H 1
+
+#	include <pthread.h>
+
+#	include "../dwmblocks-fast.h"
+
+/* ../blocks/defer.c */
+
+/* Deferred initialization of what a block needs, e.g., a library or a
+ * sensor that may appear later. Instead of retrying with sleep in the main
+ * loop, the block renders empty and is run again when the init is done or
+ * due to be retried, while the other blocks keep updating. */
+
+/* Upper bound of the retry backoff in seconds. */
+#	define B_DEFER_BACKOFF_MAX 64
+/* Blocks that can wait on one init. */
+#	define B_DEFER_WAITERS_MAX 8
+
+/* Return 0 on success or -1 to retry later. */
+typedef int (*b_defer_fn_ty)(void *data);
+
+typedef enum {
+	B_DEFER_IDLE = 0,
+	B_DEFER_RUNNING,
+	B_DEFER_DONE
+} b_defer_state_ty;
+
+typedef struct {
+	b_defer_fn_ty fn;
+	void *data;
+	/* Run fn on a helper thread, for library inits that may block. */
+	int async;
+	b_defer_state_ty state;
+	/* Set by the helper thread, read after it is joined. */
+	int ret;
+	unsigned short backoff;
+	unsigned int retry_time;
+	pthread_t thread;
+	struct {
+		g_func_ty func;
+		const char *arg;
+		/* The B_SLEEP of the block. */
+		unsigned short *interval;
+	} waiters[B_DEFER_WAITERS_MAX];
+	unsigned int waiters_len;
+} b_defer_ty;
+
+#	define B_DEFER_INIT(f, d, a) { .fn = (f), .data = (d), .async = (a) }
+
+/* Return 1 if the init of d is done. Otherwise, start or schedule it, set
+ * *interval so that the block func with arg is run again when it may be
+ * done, and return 0, in which case the block should render empty. */
+int
+b_defer_ready(b_defer_ty *d, g_func_ty func, const char *arg, unsigned short *interval);
+/* Return 1 if b_defer_ready would start the init of d now, which is
+ * neither done, running nor backing off. */
+int
+b_defer_due(const b_defer_ty *d);
+
+#endif /* B_DEFER_H */
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+
+#ifdef USE_DLOPEN
+
+#	include <dlfcn.h>
+#	include <string.h>
+
+#	include "dl.h"
+
+void *
+b_dl_open(const char *soname)
+{
+	/* Resolve lazily: most of a library is never called. */
+	return dlopen(soname, RTLD_LAZY | RTLD_LOCAL);
+}
+
+int
+b_dl_sym(void *handle, const char *name, void *fn, size_t size)
+{
+	void *sym = dlsym(handle, name);
+	if (sym == NULL)
+		return -1;
+	/* POSIX guarantees that a function pointer has the representation of
+	 * a void *, but ISO C has no conversion between them. */
+	memcpy(fn, &sym, size);
+	return 0;
+}
+
+#endif /* USE_DLOPEN */
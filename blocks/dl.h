@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_DL_H
+#	define B_DL_H 1
+
+#	include <stddef.h>
+
+#	include "../config.h"
+
+#	ifdef USE_DLOPEN
+
+/* ../blocks/dl.c */
+
+/* Optional libraries are loaded on first use with dlopen instead of being
+ * linked, so that the binary runs without them and does not pay for their
+ * relocation when they are unused. Their functions are resolved into a
+ * table of function pointers per library. */
+
+/* Return the handle of soname, loaded on first use, or NULL if it is
+ * missing. Never unloaded. */
+void *
+b_dl_open(const char *soname);
+/* Resolve name in handle into the function pointer fn of size size.
+ * Return 0, or -1 if it is missing. */
+int
+b_dl_sym(void *handle, const char *name, void *fn, size_t size);
+
+#		define B_DL_STR(x)  #x
+#		define B_DL_XSTR(x) B_DL_STR(x)
+/* Resolve table.fn. Headers may map a function to a versioned symbol,
+ * e.g., nvmlInit to nvmlInit_v2, so fn is expanded before being looked up. */
+#		define B_DL_SYM(handle, table, fn) b_dl_sym((handle), B_DL_XSTR(fn), &(table).fn, sizeof((table).fn))
+
+#	endif /* USE_DLOPEN */
+
+#endif /* B_DL_H */
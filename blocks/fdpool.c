@@ -0,0 +1,291 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../config.h"
+#include "../macros.h"
+#include "fdpool.h"
+
+#if USE_IO_URING && defined HAVE_IO_URING
+#	include <stdlib.h>
+#	include <stdint.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <linux/io_uring.h>
+#	include "../dwmblocks-fast.h"
+#	define B_FDPOOL_URING 1
+#endif
+
+typedef struct {
+	const char *path;
+	int fd;
+#ifdef B_FDPOOL_URING
+	/* Blocks that read this file, as a bitmask of block indexes. */
+	unsigned long long blocks;
+	/* Largest read requested by b_fdpool_pread. */
+	unsigned int want;
+	/* Result of the read submitted by b_fdpool_prefetch. */
+	char *pre_buf;
+	unsigned int pre_size;
+	unsigned int pre_len;
+	unsigned int pre_time;
+	/* pre_buf may still be written by the kernel. */
+	int pre_inflight;
+#endif
+} b_fdpool_ty;
+
+static b_fdpool_ty b_fdpool[B_FDPOOL_MAX];
+static unsigned int b_fdpool_len;
+
+static b_fdpool_ty *
+b_fdpool_get(const char *path)
+{
+	/* Blocks pass the same string each time, so try the pointer first. */
+	for (unsigned int i = 0; i < b_fdpool_len; ++i)
+		if (b_fdpool[i].path == path)
+			return &b_fdpool[i];
+	for (unsigned int i = 0; i < b_fdpool_len; ++i)
+		if (!strcmp(b_fdpool[i].path, path))
+			return &b_fdpool[i];
+	if (unlikely(b_fdpool_len == B_FDPOOL_MAX))
+		return NULL;
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return NULL;
+	b_fdpool_ty *e = &b_fdpool[b_fdpool_len++];
+	e->path = path;
+	e->fd = fd;
+#ifdef B_FDPOOL_URING
+	e->pre_time = (unsigned int)-1;
+#endif
+	return e;
+}
+
+#ifdef B_FDPOOL_URING
+
+unsigned int b_fdpool_block = (unsigned int)-1;
+
+static struct {
+	int fd;
+	unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned int *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+} b_uring = { .fd = -1 };
+/* Set if io_uring is unavailable, e.g., disabled by sysctl or seccomp. */
+static int b_uring_failed;
+/* Reads submitted whose completion has not been reaped. */
+static unsigned int b_uring_inflight;
+
+static int
+b_uring_init(void)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	const int fd = (int)syscall(SYS_io_uring_setup, B_FDPOOL_MAX, &p);
+	if (fd == -1)
+		return -1;
+	size_t sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	size_t cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		sq_sz = cq_sz = MAX(sq_sz, cq_sz);
+	char *sq = mmap(NULL, sq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (sq == MAP_FAILED)
+		goto err;
+	char *cq = sq;
+	if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+		cq = mmap(NULL, cq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cq == MAP_FAILED)
+			goto err;
+	}
+	b_uring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (b_uring.sqes == MAP_FAILED)
+		goto err;
+	b_uring.sq_head = (unsigned int *)(sq + p.sq_off.head);
+	b_uring.sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+	b_uring.sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+	b_uring.sq_array = (unsigned int *)(sq + p.sq_off.array);
+	b_uring.cq_head = (unsigned int *)(cq + p.cq_off.head);
+	b_uring.cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+	b_uring.cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+	b_uring.cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	b_uring.fd = fd;
+	return 0;
+err:
+	/* The mappings go away with the process. */
+	close(fd);
+	return -1;
+}
+
+/* Take the completed reads. */
+static void
+b_uring_reap(void)
+{
+	unsigned int head = *b_uring.cq_head;
+	const unsigned int cq_tail = __atomic_load_n(b_uring.cq_tail, __ATOMIC_ACQUIRE);
+	for (; head != cq_tail; ++head) {
+		const struct io_uring_cqe *cqe = &b_uring.cqes[head & *b_uring.cq_mask];
+		b_fdpool_ty *e = &b_fdpool[cqe->user_data];
+		e->pre_inflight = 0;
+		--b_uring_inflight;
+		/* Failed reads are retried by b_fdpool_pread. */
+		if (cqe->res < 0)
+			continue;
+		e->pre_len = (unsigned int)cqe->res;
+		e->pre_time = g_time;
+	}
+	__atomic_store_n(b_uring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* Wait for every submitted read, so that no buffer is written once it is
+ * reused. If that fails, the buffers are given up and io_uring is not
+ * used anymore. */
+static void
+b_uring_drain(void)
+{
+	for (;;) {
+		b_uring_reap();
+		if (b_uring_inflight == 0)
+			return;
+		if (syscall(SYS_io_uring_enter, b_uring.fd, 0, b_uring_inflight, IORING_ENTER_GETEVENTS, NULL, 0) == -1 && errno != EINTR)
+			break;
+	}
+	for (unsigned int i = 0; i < b_fdpool_len; ++i) {
+		b_fdpool_ty *e = &b_fdpool[i];
+		if (!e->pre_inflight)
+			continue;
+		/* Leaked, as it may still be written. */
+		e->pre_buf = NULL;
+		e->pre_size = 0;
+		e->pre_inflight = 0;
+	}
+	b_uring_inflight = 0;
+	b_uring_failed = 1;
+}
+
+void
+b_fdpool_prefetch(unsigned long long due_mask)
+{
+	if (unlikely(b_uring.fd == -1)) {
+		if (b_uring_failed)
+			return;
+		if (b_uring_init() == -1) {
+			b_uring_failed = 1;
+			return;
+		}
+	}
+	if (unlikely(b_uring_failed))
+		return;
+	unsigned int tail = *b_uring.sq_tail;
+	const unsigned int head = __atomic_load_n(b_uring.sq_head, __ATOMIC_ACQUIRE);
+	const unsigned int mask = *b_uring.sq_mask;
+	unsigned char idxs[B_FDPOOL_MAX];
+	unsigned int n = 0;
+	for (unsigned int i = 0; i < b_fdpool_len; ++i) {
+		b_fdpool_ty *e = &b_fdpool[i];
+		if (!(e->blocks & due_mask) || e->fd == -1 || e->want == 0 || e->pre_inflight)
+			continue;
+		if (e->pre_size < e->want) {
+			char *buf = realloc(e->pre_buf, e->want);
+			if (unlikely(buf == NULL))
+				continue;
+			e->pre_buf = buf;
+			e->pre_size = e->want;
+		}
+		const unsigned int idx = tail & mask;
+		struct io_uring_sqe *sqe = &b_uring.sqes[idx];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = e->fd;
+		sqe->addr = (unsigned long long)(uintptr_t)e->pre_buf;
+		sqe->len = e->pre_size;
+		sqe->off = 0;
+		sqe->user_data = i;
+		b_uring.sq_array[idx] = idx;
+		idxs[n] = (unsigned char)i;
+		++tail;
+		++n;
+	}
+	if (n == 0)
+		return;
+	__atomic_store_n(b_uring.sq_tail, tail, __ATOMIC_RELEASE);
+	/* Submit all reads and wait for them in one syscall. */
+	syscall(SYS_io_uring_enter, b_uring.fd, n, n, IORING_ENTER_GETEVENTS, NULL, 0);
+	/* Even if it failed or was interrupted, the reads it took are
+	 * running. Take back the others, so that a later enter does not
+	 * submit them. */
+	const unsigned int submitted = __atomic_load_n(b_uring.sq_head, __ATOMIC_ACQUIRE) - head;
+	if (unlikely(submitted < n))
+		__atomic_store_n(b_uring.sq_tail, head + submitted, __ATOMIC_RELEASE);
+	for (unsigned int k = 0; k < submitted; ++k)
+		b_fdpool[idxs[k]].pre_inflight = 1;
+	b_uring_inflight += submitted;
+	b_uring_drain();
+}
+
+#endif /* B_FDPOOL_URING */
+
+ssize_t
+b_fdpool_pread(const char *path, void *dst, size_t n)
+{
+	b_fdpool_ty *e = b_fdpool_get(path);
+	if (unlikely(e == NULL))
+		return -1;
+#ifdef B_FDPOOL_URING
+	if (b_fdpool_block < 64)
+		e->blocks |= 1ULL << b_fdpool_block;
+	if (n > e->want)
+		e->want = (unsigned int)MIN(n, B_FDPOOL_PREFETCH_MAX);
+	/* Use the data read by b_fdpool_prefetch in this tick, once. */
+	if (e->pre_time == g_time && n <= e->pre_size) {
+		e->pre_time = (unsigned int)-1;
+		const size_t len = MIN(n, e->pre_len);
+		memcpy(dst, e->pre_buf, len);
+		return (ssize_t)len;
+	}
+#endif
+	ssize_t read_sz = pread(e->fd, dst, n, 0);
+	if (unlikely(read_sz == -1)) {
+		/* The file was removed and may have come back, e.g., a sysfs
+		 * attribute of an unplugged device. */
+		if (errno != ENODEV && errno != ESTALE && errno != EBADF)
+			return -1;
+		close(e->fd);
+		e->fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (e->fd == -1)
+			return -1;
+		read_sz = pread(e->fd, dst, n, 0);
+	}
+	return read_sz;
+}
+
+unsigned int
+b_fdpool_read(char *dst, unsigned int dst_size, const char *path)
+{
+	if (unlikely(dst_size == 0))
+		return (unsigned int)-1;
+	const ssize_t read_sz = b_fdpool_pread(path, dst, dst_size - 1);
+	if (unlikely(read_sz == -1))
+		return (unsigned int)-1;
+	dst[read_sz] = '\0';
+	return (unsigned int)read_sz;
+}
@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_FDPOOL_H
+#	define B_FDPOOL_H 1
+
+#	include <sys/types.h>
+
+#	include "../macros.h"
+#	include "../config.h"
+
+/* ../blocks/fdpool.c */
+
+/* Maximum number of files kept open. */
+#	define B_FDPOOL_MAX 64
+
+/* Read up to n bytes from the start of path. The file is opened on
+ * first use and kept open, so that later reads cost one pread. It is
+ * reopened if the device went away, e.g., after hotplug. path must
+ * stay valid for the lifetime of the program. Return -1 on error. */
+ssize_t
+b_fdpool_pread(const char *path, void *dst, size_t n);
+/* Like b_fdpool_pread, but nul-terminate dst. Return the number of bytes
+ * read, or (unsigned int)-1 on error. */
+unsigned int
+b_fdpool_read(char *dst, unsigned int dst_size, const char *path);
+
+#	if USE_IO_URING && defined HAVE_IO_URING
+
+/* Largest read that is prefetched. */
+#		define B_FDPOOL_PREFETCH_MAX 4096
+
+/* Index of the block being run, used to learn which files each block
+ * reads. Blocks past the 64th are not prefetched. */
+extern unsigned int b_fdpool_block;
+/* Read the files of the blocks in due_mask with one io_uring_enter.
+ * The next b_fdpool_pread of each file in this tick uses the result. */
+void
+b_fdpool_prefetch(unsigned long long due_mask);
+
+#	endif
+
+#endif /* B_FDPOOL_H */
@@ -0,0 +1,452 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+#include "gpu.h"
+
+#ifdef B_GPU_DRM
+
+#	include <dirent.h>
+#	include <limits.h>
+#	include <stdlib.h>
+#	include <string.h>
+#	include <time.h>
+#	include <unistd.h>
+
+#	include "../macros.h"
+#	include "../utils.h"
+#	include "fdpool.h"
+#	include "procfs.h"
+#	include "temp.h"
+#	include "gpu-drm.h"
+
+#	ifndef PATH_MAX
+#		define PATH_MAX 4096
+#	endif
+
+/* Maximum number of distinct clients counted in one fdinfo scan. */
+#	define B_GPU_DRM_CLIENTS_MAX 256
+
+typedef struct {
+	/* [N] in card[N], for sorting. */
+	unsigned int card;
+	/* PCI slot, to match drm-pdev in fdinfo. Empty if not on PCI. */
+	char pdev[B_GPU_DRM_PDEV_MAX];
+	/* Files read through the fd pool, or NULL if the driver has none. */
+	/* device/gpu_busy_percent */
+	char *busy;
+	/* device/mem_info_vram_used and device/mem_info_vram_total */
+	char *vram_used;
+	char *vram_total;
+	/* device/hwmon/hwmon[N]/temp1_input */
+	char *temp;
+	/* power1_average or power1_input in uW, or else energy1_input in uJ. */
+	char *power;
+	char *energy;
+	unsigned long long last_energy;
+	struct timespec last_energy_time;
+	int energy_primed;
+#	if USE_GPU_DRM_FDINFO
+	/* Busy time of each engine, summed over the clients of a scan. */
+	unsigned int engines_len;
+	struct {
+		char name[B_GPU_DRM_ENGINE_NAME_MAX];
+		unsigned long long ns;
+		unsigned long long last_ns;
+		unsigned int capacity;
+		int primed;
+	} engines[B_GPU_DRM_ENGINES_MAX];
+#	endif
+} b_gpu_drm_card_ty;
+
+static b_gpu_drm_card_ty b_gpu_drm_cards[B_GPU_MAX];
+static unsigned int b_gpu_drm_len;
+#	if USE_GPU_DRM_FDINFO
+/* Some GPU has no gpu_busy_percent. */
+static int b_gpu_drm_fdinfo;
+#	endif
+
+/* Return the index of the engine called name of client, adding it if
+ * needed, or -1 if there are too many. */
+static ATTR_INLINE unsigned int
+b_gpu_drm_engine(b_gpu_drm_client_ty *client, const char *name, unsigned int name_len)
+{
+	unsigned int i = 0;
+	for (; i < client->engines_len; ++i)
+		if (!strncmp(client->engines[i].name, name, name_len) && client->engines[i].name[name_len] == '\0')
+			return i;
+	if (unlikely(i == B_GPU_DRM_ENGINES_MAX || name_len >= B_GPU_DRM_ENGINE_NAME_MAX))
+		return (unsigned int)-1;
+	u_stpcpy_len(client->engines[i].name, name, name_len);
+	client->engines[i].ns = 0;
+	client->engines[i].capacity = 0;
+	++client->engines_len;
+	return i;
+}
+
+int
+b_gpu_drm_fdinfo_parse(const char *buf, unsigned int len, b_gpu_drm_client_ty *client)
+{
+	int has_id = 0;
+	*client->pdev = '\0';
+	client->engines_len = 0;
+	struct b_proc_iter iter;
+	b_proc_iter_init(&iter, buf, len);
+	const char *key, *val;
+	unsigned int key_len, val_len;
+	while (b_proc_iter_next(&iter, &key, &key_len, &val, &val_len, ':')) {
+		if (key_len <= S_LEN("drm-") || memcmp(key, S_LITERAL("drm-")))
+			continue;
+		key += S_LEN("drm-");
+		key_len -= S_LEN("drm-");
+		/* Values are indented with tabs. */
+		for (; val_len && *val == '\t'; ++val, --val_len) {}
+		if (key_len == S_LEN("pdev") && !memcmp(key, S_LITERAL("pdev"))) {
+			if (unlikely(val_len >= sizeof(client->pdev)))
+				return -1;
+			u_stpcpy_len(client->pdev, val, val_len);
+		} else if (key_len == S_LEN("client-id") && !memcmp(key, S_LITERAL("client-id"))) {
+			client->client_id = u_atoull10(val);
+			has_id = 1;
+		} else if (key_len > S_LEN("engine-capacity-") && !memcmp(key, S_LITERAL("engine-capacity-"))) {
+			const unsigned int i = b_gpu_drm_engine(client, key + S_LEN("engine-capacity-"), key_len - S_LEN("engine-capacity-"));
+			if (i != (unsigned int)-1)
+				client->engines[i].capacity = u_atou10(val);
+		} else if (key_len > S_LEN("engine-") && !memcmp(key, S_LITERAL("engine-"))) {
+			/* drm-engine-render: 25662044495 ns */
+			const unsigned int i = b_gpu_drm_engine(client, key + S_LEN("engine-"), key_len - S_LEN("engine-"));
+			if (i != (unsigned int)-1)
+				client->engines[i].ns = u_atoull10(val);
+		}
+	}
+	return (*client->pdev && has_id) ? 0 : -1;
+}
+
+/* Return a copy of path if it can be read, or NULL. */
+static char *
+b_gpu_drm_file(char *path, char *path_e, const char *name, unsigned int name_len)
+{
+	u_stpcpy_len(path_e, name, name_len);
+	if (access(path, R_OK) == -1)
+		return NULL;
+	return strdup(path);
+}
+
+/* Find the first hwmon[N] of the GPU in .../device, in path, and its
+ * sensors. */
+static void
+b_gpu_drm_add_hwmon(b_gpu_drm_card_ty *c, char *path, char *path_e)
+{
+	char *dir_e = u_stpcpy_len(path_e, S_LITERAL("/hwmon"));
+	DIR *dp = opendir(path);
+	if (dp == NULL)
+		return;
+	struct dirent *ep;
+	while ((ep = readdir(dp)))
+		if (!strncmp(ep->d_name, "hwmon", S_LEN("hwmon")) && u_isdigit(ep->d_name[S_LEN("hwmon")]))
+			break;
+	if (ep == NULL) {
+		closedir(dp);
+		return;
+	}
+	dir_e = u_stpcpy(u_stpcpy_len(dir_e, S_LITERAL("/")), ep->d_name);
+	closedir(dp);
+	c->temp = b_gpu_drm_file(path, dir_e, S_LITERAL("/temp1_input"));
+	/* amdgpu has power1_average, or power1_input since RDNA3. */
+	c->power = b_gpu_drm_file(path, dir_e, S_LITERAL("/power1_average"));
+	if (c->power == NULL)
+		c->power = b_gpu_drm_file(path, dir_e, S_LITERAL("/power1_input"));
+	/* i915 and xe have only the energy. */
+	if (c->power == NULL)
+		c->energy = b_gpu_drm_file(path, dir_e, S_LITERAL("/energy1_input"));
+}
+
+/* Fill c from .../card[N]/device in path. Return 1 if it is a GPU read
+ * through this backend, or 0 if not. */
+static int
+b_gpu_drm_add(b_gpu_drm_card_ty *c, unsigned int card, char *path, char *path_e)
+{
+	memset(c, 0, sizeof(*c));
+	c->card = card;
+	char uevent[512];
+	u_stpcpy_len(path_e, S_LITERAL("/uevent"));
+	const unsigned int uevent_len = b_proc_read_file(uevent, sizeof(uevent), path);
+	if (uevent_len == (unsigned int)-1)
+		return 0;
+	struct b_proc_iter iter;
+	b_proc_iter_init(&iter, uevent, uevent_len);
+	const char *key, *val;
+	unsigned int key_len, val_len;
+	while (b_proc_iter_next(&iter, &key, &key_len, &val, &val_len, '=')) {
+		if (key_len == S_LEN("DRIVER") && !memcmp(key, S_LITERAL("DRIVER"))) {
+			/* Read through NVML, and has none of the files below. */
+			if (val_len == S_LEN("nvidia") && !memcmp(val, S_LITERAL("nvidia")))
+				return 0;
+		} else if (key_len == S_LEN("PCI_SLOT_NAME") && !memcmp(key, S_LITERAL("PCI_SLOT_NAME"))) {
+			if (val_len < sizeof(c->pdev))
+				u_stpcpy_len(c->pdev, val, val_len);
+		}
+	}
+	c->busy = b_gpu_drm_file(path, path_e, S_LITERAL("/gpu_busy_percent"));
+	c->vram_used = b_gpu_drm_file(path, path_e, S_LITERAL("/mem_info_vram_used"));
+	c->vram_total = b_gpu_drm_file(path, path_e, S_LITERAL("/mem_info_vram_total"));
+	b_gpu_drm_add_hwmon(c, path, path_e);
+	if (c->busy || c->vram_used || c->temp || c->power || c->energy)
+		return 1;
+#	if USE_GPU_DRM_FDINFO
+	/* Integrated Intel GPUs have only the busy time of the clients. */
+	if (*c->pdev)
+		return 1;
+#	endif
+	return 0;
+}
+
+static int
+b_gpu_drm_cmp(const void *a, const void *b)
+{
+	const unsigned int p = ((const b_gpu_drm_card_ty *)a)->card;
+	const unsigned int q = ((const b_gpu_drm_card_ty *)b)->card;
+	return (p > q) - (p < q);
+}
+
+/* Paths are keys of the fd pool and stay allocated, so the GPUs are
+ * found only once. */
+static int
+b_gpu_drm_init(b_gpu_dev_ty *devs, unsigned int max)
+{
+	if (b_gpu_drm_len)
+		goto out;
+	char path[PATH_MAX];
+	const char *root = b_sysfs_root();
+	if (unlikely(strlen(root) + S_LEN("/class/drm/") + NAME_MAX + S_LEN("/device/hwmon/") + NAME_MAX + S_LEN("/power1_average") >= sizeof(path)))
+		return -1;
+	char *path_e = u_stpcpy_len(u_stpcpy(path, root), S_LITERAL("/class/drm"));
+	DIR *dp = opendir(path);
+	/* No DRM driver, e.g., in a VM. */
+	if (dp == NULL)
+		return 0;
+	unsigned int len = 0;
+	struct dirent *ep;
+	while (len < max && (ep = readdir(dp))) {
+		/* card0, but not its connectors, e.g., card0-DP-1, or renderD128. */
+		const char *num = ep->d_name + S_LEN("card");
+		if (strncmp(ep->d_name, "card", S_LEN("card")) || !u_isdigit(*num))
+			continue;
+		const char *p = num;
+		for (; u_isdigit(*p); ++p) {}
+		if (*p != '\0')
+			continue;
+		char *dir_e = u_stpcpy_len(u_stpcpy(u_stpcpy_len(path_e, S_LITERAL("/")), ep->d_name), S_LITERAL("/device"));
+		len += (unsigned int)b_gpu_drm_add(&b_gpu_drm_cards[len], u_atou10(num), path, dir_e);
+	}
+	closedir(dp);
+	/* Number the GPUs as the kernel does. */
+	qsort(b_gpu_drm_cards, len, sizeof(b_gpu_drm_cards[0]), b_gpu_drm_cmp);
+#	if USE_GPU_DRM_FDINFO
+	for (unsigned int i = 0; i < len; ++i)
+		if (b_gpu_drm_cards[i].busy == NULL)
+			b_gpu_drm_fdinfo = 1;
+#	endif
+	b_gpu_drm_len = len;
+out:
+	for (unsigned int i = 0; i < b_gpu_drm_len; ++i) {
+		const b_gpu_drm_card_ty *c = &b_gpu_drm_cards[i];
+		memcpy(devs[i].id, c->pdev, sizeof(c->pdev));
+		devs[i].has = 0;
+		if (c->temp)
+			devs[i].has |= B_GPU_BIT(B_GPU_MON_TEMP);
+		if (c->busy)
+			devs[i].has |= B_GPU_BIT(B_GPU_MON_USAGE);
+#	if USE_GPU_DRM_FDINFO
+		else if (*c->pdev)
+			devs[i].has |= B_GPU_BIT(B_GPU_MON_USAGE);
+#	endif
+		if (c->vram_used && c->vram_total)
+			devs[i].has |= B_GPU_BIT(B_GPU_MON_VRAM);
+		if (c->power || c->energy)
+			devs[i].has |= B_GPU_BIT(B_GPU_MON_POWER_USAGE);
+	}
+	return (int)b_gpu_drm_len;
+}
+
+/* Return the number in path, or 0 if path is NULL or cannot be read. */
+static unsigned long long
+b_gpu_drm_read_ull(const char *path)
+{
+	char buf[S_LEN("18446744073709551615") + 2];
+	if (path == NULL || b_fdpool_read(buf, sizeof(buf), path) == (unsigned int)-1)
+		return 0;
+	return u_atoull10(buf);
+}
+
+static unsigned int
+b_gpu_drm_read_temp(const char *path)
+{
+	char buf[B_TEMP_BUF];
+	long millidegrees;
+	if (path == NULL)
+		return 0;
+	const unsigned int len = b_fdpool_read(buf, sizeof(buf), path);
+	if (len == (unsigned int)-1 || b_temp_parse(buf, len, &millidegrees) == -1 || millidegrees < 0)
+		return 0;
+	return (unsigned int)(millidegrees / 1000);
+}
+
+/* Return the power in W drawn since the previous sample. */
+static unsigned int
+b_gpu_drm_read_energy(b_gpu_drm_card_ty *c)
+{
+	const unsigned long long energy = b_gpu_drm_read_ull(c->energy);
+	struct timespec now;
+	if (unlikely(clock_gettime(CLOCK_MONOTONIC, &now) != 0))
+		return 0;
+	unsigned int watts = 0;
+	if (c->energy_primed && energy >= c->last_energy) {
+		const double secs = (double)(now.tv_sec - c->last_energy_time.tv_sec) + (double)(now.tv_nsec - c->last_energy_time.tv_nsec) / 1000000000;
+		if (secs > 0)
+			watts = (unsigned int)((double)(energy - c->last_energy) / (secs * 1000000.0));
+	}
+	c->last_energy = energy;
+	c->last_energy_time = now;
+	c->energy_primed = 1;
+	return watts;
+}
+
+#	if USE_GPU_DRM_FDINFO
+
+/* Clients seen in the current scan: their fds may be dup'ed or shared
+ * between processes. */
+static struct {
+	struct {
+		unsigned int card;
+		unsigned long long id;
+	} seen[B_GPU_DRM_CLIENTS_MAX];
+	unsigned int seen_len;
+	struct timespec last_time;
+	int primed;
+} b_gpu_drm_scan;
+
+static void
+b_gpu_drm_fdinfo_add(const char *fdinfo, unsigned int fdinfo_len, void *unused)
+{
+	b_gpu_drm_client_ty client;
+	if (b_gpu_drm_fdinfo_parse(fdinfo, fdinfo_len, &client) == -1)
+		return;
+	unsigned int i = 0;
+	for (; i < b_gpu_drm_len; ++i)
+		if (b_gpu_drm_cards[i].busy == NULL && !strcmp(b_gpu_drm_cards[i].pdev, client.pdev))
+			break;
+	if (i == b_gpu_drm_len)
+		return;
+	for (unsigned int j = 0; j < b_gpu_drm_scan.seen_len; ++j)
+		if (b_gpu_drm_scan.seen[j].card == i && b_gpu_drm_scan.seen[j].id == client.client_id)
+			return;
+	if (unlikely(b_gpu_drm_scan.seen_len == B_GPU_DRM_CLIENTS_MAX))
+		return;
+	b_gpu_drm_scan.seen[b_gpu_drm_scan.seen_len].card = i;
+	b_gpu_drm_scan.seen[b_gpu_drm_scan.seen_len].id = client.client_id;
+	++b_gpu_drm_scan.seen_len;
+	b_gpu_drm_card_ty *c = &b_gpu_drm_cards[i];
+	for (unsigned int k = 0; k < client.engines_len; ++k) {
+		unsigned int e = 0;
+		for (; e < c->engines_len; ++e)
+			if (!strcmp(c->engines[e].name, client.engines[k].name))
+				break;
+		if (e == c->engines_len) {
+			if (unlikely(e == B_GPU_DRM_ENGINES_MAX))
+				continue;
+			memcpy(c->engines[e].name, client.engines[k].name, sizeof(c->engines[e].name));
+			c->engines[e].ns = 0;
+			c->engines[e].primed = 0;
+			++c->engines_len;
+		}
+		c->engines[e].ns += client.engines[k].ns;
+		c->engines[e].capacity = MAX(client.engines[k].capacity, 1u);
+	}
+	(void)unused;
+}
+
+/* Set the usage of GPUs without gpu_busy_percent to that of their
+ * busiest engine since the previous scan. */
+static void
+b_gpu_drm_sample_fdinfo(b_gpu_dev_ty *devs)
+{
+	for (unsigned int i = 0; i < b_gpu_drm_len; ++i)
+		for (unsigned int e = 0; e < b_gpu_drm_cards[i].engines_len; ++e)
+			b_gpu_drm_cards[i].engines[e].ns = 0;
+	b_gpu_drm_scan.seen_len = 0;
+	struct timespec now;
+	if (unlikely(clock_gettime(CLOCK_MONOTONIC, &now) != 0))
+		return;
+	if (unlikely(b_proc_fdinfo_each(S_LITERAL("/dev/dri/"), b_gpu_drm_fdinfo_add, NULL) == -1))
+		return;
+	const double ns = (double)(now.tv_sec - b_gpu_drm_scan.last_time.tv_sec) * 1000000000 + (double)(now.tv_nsec - b_gpu_drm_scan.last_time.tv_nsec);
+	for (unsigned int i = 0; i < b_gpu_drm_len; ++i) {
+		b_gpu_drm_card_ty *c = &b_gpu_drm_cards[i];
+		if (c->busy)
+			continue;
+		unsigned int usage = 0;
+		for (unsigned int e = 0; e < c->engines_len; ++e) {
+			/* A client that exited takes its busy time with it. */
+			if (b_gpu_drm_scan.primed && c->engines[e].primed && c->engines[e].ns >= c->engines[e].last_ns && ns > 0) {
+				const double busy = (double)(c->engines[e].ns - c->engines[e].last_ns) / (ns * c->engines[e].capacity);
+				usage = MAX(usage, (unsigned int)(busy * 100));
+			}
+			c->engines[e].last_ns = c->engines[e].ns;
+			c->engines[e].primed = 1;
+		}
+		devs[i].usage = MIN(usage, 100u);
+	}
+	b_gpu_drm_scan.last_time = now;
+	b_gpu_drm_scan.primed = 1;
+}
+
+#	endif
+
+static void
+b_gpu_drm_sample(b_gpu_dev_ty *devs, unsigned int mask)
+{
+	for (unsigned int i = 0; i < b_gpu_drm_len; ++i) {
+		b_gpu_drm_card_ty *c = &b_gpu_drm_cards[i];
+		b_gpu_dev_ty *d = &devs[i];
+		const unsigned int need = mask & d->needed;
+		if (need & B_GPU_BIT(B_GPU_MON_TEMP))
+			d->temp = b_gpu_drm_read_temp(c->temp);
+		if (need & B_GPU_BIT(B_GPU_MON_USAGE))
+			d->usage = (unsigned int)b_gpu_drm_read_ull(c->busy);
+		if (need & B_GPU_BIT(B_GPU_MON_VRAM)) {
+			const unsigned long long total = b_gpu_drm_read_ull(c->vram_total);
+			d->vram = total ? (unsigned int)(b_gpu_drm_read_ull(c->vram_used) * 100 / total) : 0;
+		}
+		if (need & B_GPU_BIT(B_GPU_MON_POWER_USAGE)) {
+			if (c->power)
+				/* Convert from microwatt to watt. */
+				d->power = (unsigned int)(b_gpu_drm_read_ull(c->power) / 1000000);
+			else
+				d->power = c->energy ? b_gpu_drm_read_energy(c) : 0;
+		}
+	}
+#	if USE_GPU_DRM_FDINFO
+	if ((mask & B_GPU_BIT(B_GPU_MON_USAGE)) && b_gpu_drm_fdinfo)
+		b_gpu_drm_sample_fdinfo(devs);
+#	endif
+}
+
+const b_gpu_backend_ty b_gpu_drm = { b_gpu_drm_init, b_gpu_drm_sample };
+
+#endif /* B_GPU_DRM */
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_GPU_DRM_H
+#	define B_GPU_DRM_H 1
+
+#	include "../config.h"
+#	include "gpu.h"
+
+#	ifdef B_GPU_DRM
+
+/* ../blocks/gpu-drm.c */
+
+/* 0000:03:00.0 */
+#		define B_GPU_DRM_PDEV_MAX 32
+/* Maximum number of engines of one GPU, e.g., render, copy, video. */
+#		define B_GPU_DRM_ENGINES_MAX 8
+#		define B_GPU_DRM_ENGINE_NAME_MAX 24
+
+/* Busy time of the engines of one DRM client, from its fdinfo. */
+typedef struct {
+	char pdev[B_GPU_DRM_PDEV_MAX];
+	unsigned long long client_id;
+	unsigned int engines_len;
+	struct {
+		char name[B_GPU_DRM_ENGINE_NAME_MAX];
+		/* drm-engine-[name], in ns. */
+		unsigned long long ns;
+		/* drm-engine-capacity-[name], the number of such engines. */
+		unsigned int capacity;
+	} engines[B_GPU_DRM_ENGINES_MAX];
+} b_gpu_drm_client_ty;
+
+/* Parse /proc/[pid]/fdinfo/[fd] of a DRM fd into client.
+ * Return -1 if it has no drm-pdev or drm-client-id.
+ * Tested by tests/test-edge-cases.c. */
+int
+b_gpu_drm_fdinfo_parse(const char *buf, unsigned int len, b_gpu_drm_client_ty *client);
+
+/* GPUs of the DRM drivers, e.g., amdgpu, i915 and xe, through sysfs. */
+extern const b_gpu_backend_ty b_gpu_drm;
+
+#	endif /* B_GPU_DRM */
+
+#endif /* B_GPU_DRM_H */
@@ -17,8 +17,6 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
 
 #include "../config.h"
-#include "temp.h"
-#include <unistd.h>
 
 #ifdef USE_CUDA
 #	ifndef NVML_HEADER
@@ -26,61 +24,95 @@
 #	endif
 #	include NVML_HEADER
 
-#	include <stdlib.h>
-#	include <assert.h>
-#	include <fcntl.h>
+#	include <stdio.h>
+#	include <string.h>
 
-#	include "../config.h"
 #	include "../macros.h"
-#	include "../utils.h"
-
-typedef struct {
-	nvmlDevice_t dev;
-	unsigned int temp;
-	unsigned int power;
-	nvmlUtilization_t utilization;
-	nvmlMemory_t memory;
-} b_gpu_mon_ty;
-
-typedef struct {
-	b_gpu_mon_ty *buf;
-	nvmlReturn_t ret;
-	unsigned int deviceCount;
-	int init;
-} b_gpu_ty;
-b_gpu_ty b_gpu;
-
-typedef enum {
-	B_GPU_MON_TEMP = 0,
-	B_GPU_MON_USAGE,
-	B_GPU_MON_VRAM,
-	B_GPU_MON_POWER_USAGE
-} b_gpus_ty;
-
-int b_gpu_temp_fd = -1;
-
+#	include "dl.h"
+#	include "gpu-nvidia.h"
+
+#	ifdef USE_DLOPEN
+/* libnvidia-ml, resolved by b_gpu_nvidia_init. */
+static struct {
+	nvmlReturn_t (*nvmlInit)(void);
+	nvmlReturn_t (*nvmlShutdown)(void);
+	const char *(*nvmlErrorString)(nvmlReturn_t);
+	nvmlReturn_t (*nvmlDeviceGetCount)(unsigned int *);
+	nvmlReturn_t (*nvmlDeviceGetHandleByIndex)(unsigned int, nvmlDevice_t *);
+	nvmlReturn_t (*nvmlDeviceGetUUID)(nvmlDevice_t, char *, unsigned int);
+#		if USE_NVML_DEVICEGETTEMPERATUREV
+	nvmlReturn_t (*nvmlDeviceGetTemperatureV)(nvmlDevice_t, nvmlTemperature_t *);
+#		else
+	nvmlReturn_t (*nvmlDeviceGetTemperature)(nvmlDevice_t, nvmlTemperatureSensors_t, unsigned int *);
+#		endif
+	nvmlReturn_t (*nvmlDeviceGetUtilizationRates)(nvmlDevice_t, nvmlUtilization_t *);
+	nvmlReturn_t (*nvmlDeviceGetMemoryInfo)(nvmlDevice_t, nvmlMemory_t *);
+	nvmlReturn_t (*nvmlDeviceGetPowerUsage)(nvmlDevice_t, unsigned int *);
+#		ifdef NVML_FI_DEV_POWER_AVERAGE
+	/* Optional: missing from older drivers. */
+	nvmlReturn_t (*nvmlDeviceGetFieldValues)(nvmlDevice_t, int, nvmlFieldValue_t *);
+#		endif
+} b_nvml;
+#		define B_NVML(fn) (b_nvml.fn)
+
+/* Fail on machines without the Nvidia driver. */
 static int
-b_gpu_temp_fd_init(const char *filename)
+b_nvml_load(void)
 {
-	int fd;
-	for (int retry = 10; (fd = open(filename, O_RDONLY)) < 0 && retry; --retry)
-		sleep(1);
-	return fd;
+	static void *handle;
+	if (handle)
+		return 0;
+	void *h = b_dl_open("libnvidia-ml.so.1");
+	if (h == NULL)
+		return -1;
+	if (B_DL_SYM(h, b_nvml, nvmlInit) == -1
+	    || B_DL_SYM(h, b_nvml, nvmlShutdown) == -1
+	    || B_DL_SYM(h, b_nvml, nvmlErrorString) == -1
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetCount) == -1
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetHandleByIndex) == -1
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetUUID) == -1
+#		if USE_NVML_DEVICEGETTEMPERATUREV
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetTemperatureV) == -1
+#		else
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetTemperature) == -1
+#		endif
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetUtilizationRates) == -1
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetMemoryInfo) == -1
+	    || B_DL_SYM(h, b_nvml, nvmlDeviceGetPowerUsage) == -1)
+		return -1;
+#		ifdef NVML_FI_DEV_POWER_AVERAGE
+	B_DL_SYM(h, b_nvml, nvmlDeviceGetFieldValues);
+#		endif
+	handle = h;
+	return 0;
 }
+#	else
+#		define B_NVML(fn) (fn)
+#	endif
 
-void
-b_gpu_cleanup(void)
+static struct {
+	nvmlDevice_t devs[B_GPU_MAX];
+	unsigned int len;
+	nvmlReturn_t ret;
+	int init;
+	/* nvmlDeviceGetFieldValues works. */
+	int fields_ok;
+} b_gpu_nv = { .fields_ok = 1 };
+
+static void
+b_gpu_nvidia_cleanup(void)
 {
-	if (b_gpu.init)
-		nvmlShutdown();
-	free(b_gpu.buf);
+	if (b_gpu_nv.init)
+		B_NVML(nvmlShutdown)();
+	b_gpu_nv.init = 0;
+	b_gpu_nv.len = 0;
 }
 
-void
-b_gpu_err(void)
+static void
+b_gpu_nvidia_err(void)
 {
-	fprintf(stderr, "nvml error: %s\n", nvmlErrorString(b_gpu.ret));
-	b_gpu_cleanup();
+	fprintf(stderr, "nvml error: %s\n", B_NVML(nvmlErrorString)(b_gpu_nv.ret));
+	b_gpu_nvidia_cleanup();
 }
 
 static ATTR_INLINE
@@ -91,144 +123,127 @@ b_gpu_nvmlDeviceGetTemperature(nvmlDevice_t dev, nvmlTemperatureSensors_t sensor
 	nvmlTemperature_t tmp;
 	tmp.sensorType = sensorType;
 	tmp.version = nvmlTemperature_v1;
-	const nvmlReturn_t ret = nvmlDeviceGetTemperatureV(dev, &tmp);
+	const nvmlReturn_t ret = B_NVML(nvmlDeviceGetTemperatureV)(dev, &tmp);
 	*temp = (unsigned int)tmp.temperature;
 	return ret;
 #	else
-	return nvmlDeviceGetTemperature(buf.dev, sensorType, temp);
+	return B_NVML(nvmlDeviceGetTemperature)(dev, sensorType, temp);
 #	endif
 }
 
-void
-b_gpu_init(void)
+/* nvmlInit may take a while to load the driver. */
+static int
+b_gpu_nvidia_init(b_gpu_dev_ty *devs, unsigned int max)
 {
-	b_gpu.ret = nvmlInit();
-	if (unlikely(unlikely(b_gpu.ret != NVML_SUCCESS)))
-		DIE_DO(nvmlErrorString(b_gpu.ret));
-	b_gpu.ret = nvmlDeviceGetCount(&b_gpu.deviceCount);
-	if (unlikely(b_gpu.ret != NVML_SUCCESS))
-		DIE_DO(b_gpu_err());
-	b_gpu.buf = (b_gpu_mon_ty *)calloc(b_gpu.deviceCount, sizeof(*b_gpu.buf));
-	if (b_gpu.buf == NULL)
-		DIE_DO(b_gpu_err());
-	for (unsigned int i = 0; i < b_gpu.deviceCount; ++i) {
-		b_gpu.ret = nvmlDeviceGetHandleByIndex(i, &b_gpu.buf[i].dev);
-		if (unlikely(b_gpu.ret != NVML_SUCCESS))
-			DIE_DO(b_gpu_err());
+	if (b_gpu_nv.init)
+		return (int)b_gpu_nv.len;
+#	ifdef USE_DLOPEN
+	/* No Nvidia driver, but other backends may find GPUs. */
+	if (b_nvml_load() == -1)
+		return 0;
+#	endif
+	b_gpu_nv.ret = B_NVML(nvmlInit)();
+	if (unlikely(b_gpu_nv.ret != NVML_SUCCESS))
+		return -1;
+	b_gpu_nv.init = 1;
+	unsigned int count;
+	b_gpu_nv.ret = B_NVML(nvmlDeviceGetCount)(&count);
+	if (unlikely(b_gpu_nv.ret != NVML_SUCCESS))
+		goto err;
+	count = MIN(count, max);
+	for (unsigned int i = 0; i < count; ++i) {
+		b_gpu_nv.ret = B_NVML(nvmlDeviceGetHandleByIndex)(i, &b_gpu_nv.devs[i]);
+		if (unlikely(b_gpu_nv.ret != NVML_SUCCESS))
+			goto err;
+		/* Only needed to select the GPU. */
+		if (B_NVML(nvmlDeviceGetUUID)(b_gpu_nv.devs[i], devs[i].id, sizeof(devs[i].id)) != NVML_SUCCESS)
+			*devs[i].id = '\0';
+		devs[i].has = B_GPU_BIT(B_GPU_MON_TEMP) | B_GPU_BIT(B_GPU_MON_USAGE) | B_GPU_BIT(B_GPU_MON_VRAM) | B_GPU_BIT(B_GPU_MON_POWER_USAGE);
 	}
-	b_gpu.init = 1;
+	b_gpu_nv.len = count;
+	if (count == 0)
+		b_gpu_nvidia_cleanup();
+	return (int)count;
+err:
+	b_gpu_nvidia_cleanup();
+	return -1;
 }
 
-static ATTR_INLINE unsigned int
-b_gpu_read_temp(nvmlDevice_t dev, unsigned int *temp)
+static ATTR_INLINE void
+b_gpu_read_temp(nvmlDevice_t dev, b_gpu_dev_ty *d)
 {
-	b_gpu.ret = b_gpu_nvmlDeviceGetTemperature(dev, NVML_TEMPERATURE_GPU, temp);
-	if (unlikely(b_gpu.ret != NVML_SUCCESS))
-		DIE_DO(b_gpu_err());
-	return *temp;
+	b_gpu_nv.ret = b_gpu_nvmlDeviceGetTemperature(dev, NVML_TEMPERATURE_GPU, &d->temp);
+	if (unlikely(b_gpu_nv.ret != NVML_SUCCESS))
+		DIE_DO(b_gpu_nvidia_err());
 }
 
-static ATTR_INLINE unsigned int
-b_gpu_read_usage(nvmlDevice_t dev, nvmlUtilization_t *utilization)
+static ATTR_INLINE void
+b_gpu_read_usage(nvmlDevice_t dev, b_gpu_dev_ty *d)
 {
-	b_gpu.ret = nvmlDeviceGetUtilizationRates(dev, utilization);
-	if (unlikely(b_gpu.ret != NVML_SUCCESS))
-		DIE_DO(b_gpu_err());
-	return utilization->gpu;
-}
-
-static ATTR_INLINE unsigned int
-b_gpu_read_usage_vram(nvmlDevice_t dev, nvmlMemory_t *memory)
-{
-	b_gpu.ret = nvmlDeviceGetMemoryInfo(dev, memory);
-	if (unlikely(b_gpu.ret != NVML_SUCCESS))
-		DIE_DO(b_gpu_err());
-	return 100 - (unsigned int)(((long double)memory->free / (long double)memory->total) * (long double)100);
+	nvmlUtilization_t utilization;
+	b_gpu_nv.ret = B_NVML(nvmlDeviceGetUtilizationRates)(dev, &utilization);
+	if (unlikely(b_gpu_nv.ret != NVML_SUCCESS))
+		DIE_DO(b_gpu_nvidia_err());
+	d->usage = utilization.gpu;
 }
 
-static ATTR_INLINE unsigned int
-b_gpu_read_usage_power(nvmlDevice_t dev, unsigned int *power)
+static ATTR_INLINE void
+b_gpu_read_usage_vram(nvmlDevice_t dev, b_gpu_dev_ty *d)
 {
-#if 0
-	nvmlFieldValue_t values = { .fieldId = NVML_FI_DEV_POWER_INSTANT };
-	b_gpu.ret = nvmlDeviceGetFieldValues(dev, 1, &values);
-	/* Convert from miliwatt to watt. */
-	*power = values.value.uiVal / (double)1000;
-#else
-	b_gpu.ret = nvmlDeviceGetPowerUsage(dev, power);
-	*power = (double)*power / (double)1000;
-#endif
-	if (unlikely(b_gpu.ret != NVML_SUCCESS))
-		DIE_DO(b_gpu_err());
-	return *power;
+	nvmlMemory_t memory;
+	b_gpu_nv.ret = B_NVML(nvmlDeviceGetMemoryInfo)(dev, &memory);
+	if (unlikely(b_gpu_nv.ret != NVML_SUCCESS))
+		DIE_DO(b_gpu_nvidia_err());
+	d->vram = 100 - (unsigned int)(((long double)memory.free / (long double)memory.total) * (long double)100);
 }
 
-static ATTR_INLINE char *
-b_write_gpus(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval, b_gpus_ty mon_type, unsigned int max_digits)
+static ATTR_INLINE void
+b_gpu_read_usage_power(nvmlDevice_t dev, b_gpu_dev_ty *d)
 {
-	if (b_gpu.init == 0)
-		b_gpu_init();
-	unsigned int avg = 0;
-	for (unsigned int i = 0; i < b_gpu.deviceCount; ++i)
-		switch (mon_type) {
-		case B_GPU_MON_TEMP:
-			avg += b_gpu_read_temp(b_gpu.buf[i].dev, &b_gpu.buf[i].temp);
-			break;
-		case B_GPU_MON_USAGE:
-			avg += b_gpu_read_usage(b_gpu.buf[i].dev, &b_gpu.buf[i].utilization);
-			break;
-		case B_GPU_MON_VRAM:
-			avg += b_gpu_read_usage_vram(b_gpu.buf[i].dev, &b_gpu.buf[i].memory);
-			break;
-		case B_GPU_MON_POWER_USAGE:
-			avg += b_gpu_read_usage_power(b_gpu.buf[i].dev, &b_gpu.buf[i].power);
-			break;
+#	ifdef NVML_FI_DEV_POWER_AVERAGE
+	/* The average of the last second, as nvmlDeviceGetPowerUsage reports
+	 * on older GPUs. Newer ones report the instant power there instead.
+	 * Falls back to nvmlDeviceGetPowerUsage for good once it fails. */
+	if (b_gpu_nv.fields_ok
+#		ifdef USE_DLOPEN
+	    && b_nvml.nvmlDeviceGetFieldValues
+#		endif
+	) {
+		nvmlFieldValue_t value;
+		memset(&value, 0, sizeof(value));
+		value.fieldId = NVML_FI_DEV_POWER_AVERAGE;
+		b_gpu_nv.ret = B_NVML(nvmlDeviceGetFieldValues)(dev, 1, &value);
+		if (likely(b_gpu_nv.ret == NVML_SUCCESS && value.nvmlReturn == NVML_SUCCESS)) {
+			/* Convert from milliwatt to watt. */
+			d->power = value.value.uiVal / 1000;
+			return;
 		}
-	if (b_gpu.deviceCount > 1)
-		if (max_digits == 3)
-			avg /= b_gpu.deviceCount;
-	char *p = dst;
-	if (max_digits == 3)
-		p = u_utoa_le3_p(avg, p);
-	else
-		p = u_utoa_p(avg, p);
-	return p;
-	(void)dst_size;
-	(void)unused;
-	(void)interval;
-}
-
-char *
-b_write_gpu_temp(char *dst, unsigned int dst_size, const char *temp_file, unsigned short *interval)
-{
-#if USE_NVSPEED
-	if (unlikely(b_gpu_temp_fd < 0)) {
-		b_gpu_temp_fd = b_gpu_temp_fd_init(temp_file);
-		if (unlikely(b_gpu_temp_fd < 0))
-			DIE(return NULL);
+		b_gpu_nv.fields_ok = 0;
 	}
-	return b_write_tempfd(dst, dst_size, b_gpu_temp_fd, interval);
-#else
-	return b_write_gpus(dst, dst_size, temp_file, interval, B_GPU_MON_TEMP, 3);
-#endif
-}
-
-char *
-b_write_gpu_usage(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
-{
-	return b_write_gpus(dst, dst_size, unused, interval, B_GPU_MON_USAGE, 3);
+#	endif
+	unsigned int power;
+	b_gpu_nv.ret = B_NVML(nvmlDeviceGetPowerUsage)(dev, &power);
+	if (unlikely(b_gpu_nv.ret != NVML_SUCCESS))
+		DIE_DO(b_gpu_nvidia_err());
+	d->power = power / 1000;
 }
 
-char *
-b_write_gpu_usage_vram(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
+static void
+b_gpu_nvidia_sample(b_gpu_dev_ty *devs, unsigned int mask)
 {
-	return b_write_gpus(dst, dst_size, unused, interval, B_GPU_MON_VRAM, 3);
+	for (unsigned int i = 0; i < b_gpu_nv.len; ++i) {
+		const unsigned int need = mask & devs[i].needed;
+		if (need & B_GPU_BIT(B_GPU_MON_TEMP))
+			b_gpu_read_temp(b_gpu_nv.devs[i], &devs[i]);
+		if (need & B_GPU_BIT(B_GPU_MON_USAGE))
+			b_gpu_read_usage(b_gpu_nv.devs[i], &devs[i]);
+		if (need & B_GPU_BIT(B_GPU_MON_VRAM))
+			b_gpu_read_usage_vram(b_gpu_nv.devs[i], &devs[i]);
+		if (need & B_GPU_BIT(B_GPU_MON_POWER_USAGE))
+			b_gpu_read_usage_power(b_gpu_nv.devs[i], &devs[i]);
+	}
 }
 
-char *
-b_write_gpu_usage_power(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
-{
-	return b_write_gpus(dst, dst_size, unused, interval, B_GPU_MON_POWER_USAGE, (unsigned int)-1);
-}
+const b_gpu_backend_ty b_gpu_nvidia = { b_gpu_nvidia_init, b_gpu_nvidia_sample };
 
 #endif
@@ -23,18 +23,12 @@
 
 #	ifdef USE_CUDA
 
-/* ../blocks/gpu.c */
-
-char *
-b_write_gpu_all(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
-char *
-b_write_gpu_temp(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
-char *
-b_write_gpu_usage(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
-char *
-b_write_gpu_usage_vram(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
-char *
-b_write_gpu_usage_power(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
+#		include "gpu.h"
+
+/* ../blocks/gpu-nvidia.c */
+
+/* GPUs of the Nvidia driver, through NVML. */
+extern const b_gpu_backend_ty b_gpu_nvidia;
 
 #	endif /* USE_CUDA */
 
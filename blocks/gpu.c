@@ -0,0 +1,398 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+#include "gpu.h"
+
+#ifdef B_GPU
+
+#	include <fcntl.h>
+#	include <stdio.h>
+#	include <string.h>
+
+#	include "../macros.h"
+#	include "../utils.h"
+#	include "../dwmblocks-fast.h"
+#	include "defer.h"
+#	include "temp.h"
+#	include "gpu-nvidia.h"
+#	include "gpu-drm.h"
+
+#	ifndef GPU_ALL_SEP
+#		define GPU_ALL_SEP "/"
+#	endif
+
+/* Tried in this order; GPUs are numbered across all of them. */
+static const b_gpu_backend_ty *const b_gpu_backends[] = {
+#	ifdef USE_CUDA
+	&b_gpu_nvidia,
+#	endif
+#	ifdef B_GPU_DRM
+	&b_gpu_drm,
+#	endif
+};
+#	define B_GPU_BACKENDS (sizeof(b_gpu_backends) / sizeof(b_gpu_backends[0]))
+
+static struct {
+	b_gpu_dev_ty devs[B_GPU_MAX];
+	unsigned int len;
+	/* The GPUs of backend i start at devs[first[i]]. */
+	unsigned int first[B_GPU_BACKENDS];
+	unsigned int n[B_GPU_BACKENDS];
+	/* B_GPU_BIT of the metrics shown by some block. */
+	unsigned int needed;
+	/* Those of them read in tick time. */
+	unsigned int sampled;
+	unsigned int time;
+	/* Bit i is set if backend i failed to init and is retried. */
+	unsigned int failed;
+} b_gpu;
+
+/* Run on a helper thread: nvmlInit may take a while to load the driver.
+ * Fail, and retry later, only if no backend found a GPU. Otherwise, the
+ * backends that failed are retried by b_gpu_retry_poll. */
+static int
+b_gpu_init(void *unused)
+{
+	unsigned int len = 0;
+	b_gpu.failed = 0;
+	for (unsigned int i = 0; i < B_GPU_BACKENDS; ++i) {
+		const int n = b_gpu_backends[i]->init(b_gpu.devs + len, B_GPU_MAX - len);
+		b_gpu.first[i] = len;
+		b_gpu.n[i] = (n > 0) ? (unsigned int)n : 0;
+		if (n == -1)
+			b_gpu.failed |= 1u << i;
+		len += b_gpu.n[i];
+	}
+	if (len == 0)
+		return -1;
+	b_gpu.len = len;
+	return 0;
+	(void)unused;
+}
+
+static b_defer_ty b_gpu_defer = B_DEFER_INIT(b_gpu_init, NULL, 1);
+
+/* The GPUs of the backends in b_gpu.failed, found by a later init. */
+static struct {
+	b_gpu_dev_ty devs[B_GPU_MAX];
+	unsigned int first[B_GPU_BACKENDS];
+	unsigned int n[B_GPU_BACKENDS];
+} b_gpu_retry;
+
+/* Run on a helper thread while the blocks show the GPUs found so far,
+ * which are only read. */
+static int
+b_gpu_retry_init(void *unused)
+{
+	unsigned int len = 0;
+	for (unsigned int i = 0; i < B_GPU_BACKENDS; ++i) {
+		b_gpu_retry.first[i] = len;
+		b_gpu_retry.n[i] = 0;
+		if (!(b_gpu.failed & (1u << i)))
+			continue;
+		const int n = b_gpu_backends[i]->init(b_gpu_retry.devs + len, B_GPU_MAX - b_gpu.len - len);
+		if (n == -1)
+			return -1;
+		b_gpu_retry.n[i] = (unsigned int)n;
+		len += (unsigned int)n;
+	}
+	return 0;
+	(void)unused;
+}
+
+static b_defer_ty b_gpu_retry_defer = B_DEFER_INIT(b_gpu_retry_init, NULL, 1);
+
+/* Read every metric that some GPU block shows from every GPU, once per
+ * tick, so that the blocks of one tick share one pass. */
+static void
+b_gpu_sample(void)
+{
+	if (b_gpu.time != g_time) {
+		b_gpu.time = g_time;
+		b_gpu.sampled = 0;
+	}
+	/* A block may run for the first time after the pass of its tick. */
+	const unsigned int need = b_gpu.needed & ~b_gpu.sampled;
+	if (likely(need == 0))
+		return;
+	for (unsigned int i = 0; i < B_GPU_BACKENDS; ++i)
+		if (b_gpu.n[i])
+			b_gpu_backends[i]->sample(b_gpu.devs + b_gpu.first[i], need);
+	b_gpu.sampled |= need;
+}
+
+typedef enum {
+	B_GPU_SEL_AVG = 0,
+	B_GPU_SEL_MAX,
+	B_GPU_SEL_ALL,
+	B_GPU_SEL_ONE
+} b_gpu_sel_mode_ty;
+
+typedef struct {
+	const char *arg;
+	b_gpu_sel_mode_ty mode;
+	/* For B_GPU_SEL_ONE. */
+	unsigned int idx;
+} b_gpu_sel_ty;
+
+/* Selection of each arg, resolved once. */
+static b_gpu_sel_ty b_gpu_sels[16];
+static unsigned int b_gpu_sels_len;
+
+/* Resolve arg into sel. Return -1 if no GPU matches. */
+static int
+b_gpu_sel_parse(const char *arg, b_gpu_sel_ty *sel)
+{
+	sel->arg = arg;
+	sel->idx = 0;
+	if (arg == NULL || *arg == '\0') {
+		sel->mode = B_GPU_SEL_AVG;
+		return 0;
+	}
+	if (!strcmp(arg, "max")) {
+		sel->mode = B_GPU_SEL_MAX;
+		return 0;
+	}
+	if (!strcmp(arg, "all")) {
+		sel->mode = B_GPU_SEL_ALL;
+		return 0;
+	}
+	sel->mode = B_GPU_SEL_ONE;
+	const char *p = arg;
+	for (; u_isdigit(*p); ++p) {}
+	if (*p == '\0') {
+		sel->idx = u_atou10(arg);
+		return (sel->idx < b_gpu.len) ? 0 : -1;
+	}
+	const size_t arg_len = strlen(arg);
+	for (unsigned int i = 0; i < b_gpu.len; ++i)
+		if (!strncmp(b_gpu.devs[i].id, arg, arg_len)) {
+			sel->idx = i;
+			return 0;
+		}
+	return -1;
+}
+
+/* Return the selection of arg, or NULL if no GPU matches. tmp is used
+ * if there are too many args to remember. */
+static const b_gpu_sel_ty *
+b_gpu_sel(const char *arg, b_gpu_sel_ty *tmp)
+{
+	for (unsigned int i = 0; i < b_gpu_sels_len; ++i)
+		if (b_gpu_sels[i].arg == arg)
+			return &b_gpu_sels[i];
+	const int full = (b_gpu_sels_len == sizeof(b_gpu_sels) / sizeof(b_gpu_sels[0]));
+	b_gpu_sel_ty *sel = full ? tmp : &b_gpu_sels[b_gpu_sels_len];
+	if (unlikely(b_gpu_sel_parse(arg, sel) == -1)) {
+		/* It may be one of those still to be found. */
+		if (b_gpu.failed)
+			return NULL;
+		fputs("dwmblocks-fast: GPU not found: ", stderr);
+		fputs(arg, stderr);
+		fputc('\n', stderr);
+		return NULL;
+	}
+	if (likely(!full))
+		++b_gpu_sels_len;
+	return sel;
+}
+
+/* Put the GPUs found by b_gpu_retry_init in the place of their backend,
+ * which renumbers those after them. */
+static void
+b_gpu_retry_merge(void)
+{
+	b_gpu_dev_ty devs[B_GPU_MAX];
+	unsigned int len = 0;
+	for (unsigned int i = 0; i < B_GPU_BACKENDS; ++i) {
+		const int retried = (b_gpu.failed & (1u << i)) != 0;
+		const b_gpu_dev_ty *src = retried ? b_gpu_retry.devs + b_gpu_retry.first[i] : b_gpu.devs + b_gpu.first[i];
+		const unsigned int n = MIN(retried ? b_gpu_retry.n[i] : b_gpu.n[i], B_GPU_MAX - len);
+		memcpy(devs + len, src, n * sizeof(*src));
+		if (retried)
+			for (unsigned int j = len; j < len + n; ++j)
+				devs[j].needed = b_gpu.needed & devs[j].has;
+		b_gpu.first[i] = len;
+		b_gpu.n[i] = n;
+		len += n;
+	}
+	memcpy(b_gpu.devs, devs, len * sizeof(devs[0]));
+	b_gpu.len = len;
+	b_gpu.failed = 0;
+	b_gpu.sampled = 0;
+	/* Indices may point to other GPUs now. */
+	b_gpu_sels_len = 0;
+}
+
+/* Retry the backends that failed, without holding back the block. */
+static void
+b_gpu_retry_poll(g_func_ty self, const char *arg, unsigned short *interval)
+{
+	if (b_gpu_retry_defer.state == B_DEFER_DONE) {
+		b_gpu_retry_merge();
+		return;
+	}
+	if (!b_defer_due(&b_gpu_retry_defer))
+		return;
+	const unsigned short keep = *interval;
+	b_defer_ready(&b_gpu_retry_defer, self, arg, interval);
+	*interval = keep;
+}
+
+static ATTR_INLINE unsigned int
+b_gpu_value(const b_gpu_dev_ty *d, b_gpus_ty mon_type)
+{
+	switch (mon_type) {
+	case B_GPU_MON_TEMP:
+		return d->temp;
+	case B_GPU_MON_USAGE:
+		return d->usage;
+	case B_GPU_MON_VRAM:
+		return d->vram;
+	case B_GPU_MON_POWER_USAGE:
+		return d->power;
+	}
+	return 0;
+}
+
+static ATTR_INLINE char *
+b_gpu_write_value(char *dst, unsigned int value, unsigned int max_digits)
+{
+	if (max_digits == 3)
+		return u_utoa_le3_p(value, dst);
+	return u_utoa_p(value, dst);
+}
+
+static ATTR_INLINE char *
+b_write_gpus(char *dst, unsigned int dst_size, const char *arg, unsigned short *interval, b_gpus_ty mon_type, unsigned int max_digits, g_func_ty self)
+{
+	if (unlikely(!b_defer_ready(&b_gpu_defer, self, arg, interval)))
+		return dst;
+	if (unlikely(b_gpu.failed))
+		b_gpu_retry_poll(self, arg, interval);
+	b_gpu_sel_ty tmp;
+	const b_gpu_sel_ty *sel = b_gpu_sel(arg, &tmp);
+	if (unlikely(sel == NULL)) {
+		/* Don't retry, unless a backend is still to init. */
+		if (!b_gpu.failed)
+			*interval = (unsigned short)-1;
+		return dst;
+	}
+	const unsigned int bit = B_GPU_BIT(mon_type);
+	const unsigned int first = (sel->mode == B_GPU_SEL_ONE) ? sel->idx : 0;
+	const unsigned int last = (sel->mode == B_GPU_SEL_ONE) ? sel->idx + 1 : b_gpu.len;
+	/* GPUs without the metric, e.g., without gpu_busy_percent, would
+	 * count as 0. */
+	unsigned int n = 0;
+	for (unsigned int i = first; i < last; ++i)
+		if (b_gpu.devs[i].has & bit) {
+			b_gpu.devs[i].needed |= bit;
+			++n;
+		}
+	if (unlikely(n == 0)) {
+		/* Don't retry, unless a backend is still to init. */
+		if (!b_gpu.failed)
+			*interval = (unsigned short)-1;
+		return dst;
+	}
+	b_gpu.needed |= bit;
+	b_gpu_sample();
+	char *p = dst;
+	unsigned int value = 0;
+	switch (sel->mode) {
+	case B_GPU_SEL_AVG:
+		for (unsigned int i = 0; i < b_gpu.len; ++i)
+			if (b_gpu.devs[i].has & bit)
+				value += b_gpu_value(&b_gpu.devs[i], mon_type);
+		/* Power is summed. */
+		if (max_digits == 3)
+			value /= n;
+		break;
+	case B_GPU_SEL_MAX:
+		for (unsigned int i = 0; i < b_gpu.len; ++i)
+			if (b_gpu.devs[i].has & bit)
+				value = MAX(value, b_gpu_value(&b_gpu.devs[i], mon_type));
+		break;
+	case B_GPU_SEL_ALL:
+		for (unsigned int i = 0; i < b_gpu.len; ++i) {
+			if (!(b_gpu.devs[i].has & bit))
+				continue;
+			/* Room for the value, the separator and the nul. */
+			if (unlikely((unsigned int)(p - dst) + S_LEN("4294967295") + S_LEN(GPU_ALL_SEP) + 1 > dst_size))
+				break;
+			if (p != dst)
+				p = u_stpcpy_len(p, S_LITERAL(GPU_ALL_SEP));
+			p = b_gpu_write_value(p, b_gpu_value(&b_gpu.devs[i], mon_type), max_digits);
+		}
+		return p;
+	case B_GPU_SEL_ONE:
+		value = b_gpu_value(&b_gpu.devs[sel->idx], mon_type);
+		break;
+	}
+	return b_gpu_write_value(p, value, max_digits);
+}
+
+#	if USE_NVSPEED
+static int b_gpu_temp_fd = -1;
+
+/* The file may appear only after nvspeed has started. */
+static int
+b_gpu_temp_fd_init(void *filename)
+{
+	b_gpu_temp_fd = open((const char *)filename, O_RDONLY | O_CLOEXEC);
+	return (b_gpu_temp_fd < 0) ? -1 : 0;
+}
+#	endif
+
+char *
+b_write_gpu_temp(char *dst, unsigned int dst_size, const char *temp_file, unsigned short *interval)
+{
+#	if USE_NVSPEED
+	static b_defer_ty defer;
+	if (unlikely(defer.fn == NULL)) {
+		defer.fn = b_gpu_temp_fd_init;
+		defer.data = (void *)temp_file;
+	}
+	if (unlikely(!b_defer_ready(&defer, b_write_gpu_temp, temp_file, interval)))
+		return dst;
+	return b_write_tempfd(dst, dst_size, b_gpu_temp_fd, interval);
+#	else
+	return b_write_gpus(dst, dst_size, temp_file, interval, B_GPU_MON_TEMP, 3, b_write_gpu_temp);
+#	endif
+}
+
+char *
+b_write_gpu_usage(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
+{
+	return b_write_gpus(dst, dst_size, unused, interval, B_GPU_MON_USAGE, 3, b_write_gpu_usage);
+}
+
+char *
+b_write_gpu_usage_vram(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
+{
+	return b_write_gpus(dst, dst_size, unused, interval, B_GPU_MON_VRAM, 3, b_write_gpu_usage_vram);
+}
+
+char *
+b_write_gpu_usage_power(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
+{
+	return b_write_gpus(dst, dst_size, unused, interval, B_GPU_MON_POWER_USAGE, (unsigned int)-1, b_write_gpu_usage_power);
+}
+
+#endif /* B_GPU */
@@ -21,8 +21,74 @@
 
 #	include "../config.h"
 
-#	ifdef USE_CUDA
-#		include "gpu-nvidia.h"
-#	endif /* USE_CUDA */
+#	if defined USE_GPU_DRM && defined HAVE_SYSFS
+#		define B_GPU_DRM 1
+#	endif
+
+#	if defined USE_CUDA || defined B_GPU_DRM
+#		define B_GPU 1
+
+/* ../blocks/gpu.c */
+
+/* Maximum number of GPUs, over all backends. */
+#		define B_GPU_MAX 16
+/* Enough for the UUID of NVML, e.g., GPU-5f1c..., or a PCI slot. */
+#		define B_GPU_ID_MAX 96
+
+typedef enum {
+	B_GPU_MON_TEMP = 0,
+	B_GPU_MON_USAGE,
+	B_GPU_MON_VRAM,
+	B_GPU_MON_POWER_USAGE
+} b_gpus_ty;
+
+#		define B_GPU_BIT(mon_type) (1u << (mon_type))
+
+/* Last sample of one GPU. */
+typedef struct {
+	/* UUID or PCI slot, to select the GPU in arg. May be empty. */
+	char id[B_GPU_ID_MAX];
+	/* B_GPU_BIT of the metrics this GPU reports, set by init. */
+	unsigned int has;
+	/* B_GPU_BIT of the metrics shown by some block for this GPU. */
+	unsigned int needed;
+	/* In degrees Celsius. */
+	unsigned int temp;
+	/* In percent. */
+	unsigned int usage;
+	unsigned int vram;
+	/* In watts. */
+	unsigned int power;
+} b_gpu_dev_ty;
+
+/* A source of GPUs: NVML, or the DRM drivers through sysfs. */
+typedef struct {
+	/* Find the GPUs, at most max, fill their id and has in devs and
+	 * return how many, or -1 on error. Called on a helper thread until some backend
+	 * finds a GPU; a backend that found some returns them again. */
+	int (*init)(b_gpu_dev_ty *devs, unsigned int max);
+	/* Read the metrics in mask, of B_GPU_BIT, that are also needed by
+	 * each of the GPUs found by init into devs. */
+	void (*sample)(b_gpu_dev_ty *devs, unsigned int mask);
+} b_gpu_backend_ty;
+
+/* arg selects the GPUs of a block, of those that report its metric:
+ *   NULL    the average of all GPUs, or the sum of their power
+ *   max     the highest value
+ *   all     the value of each GPU, separated by GPU_ALL_SEP
+ *   0, 1    the GPU at that index, counting NVML first
+ *   id      the GPU whose UUID or PCI slot starts with id, e.g., GPU-5f1c
+ *           or 0000:03:00.0
+ * With USE_NVSPEED, arg of b_write_gpu_temp is the temperature file. */
+char *
+b_write_gpu_temp(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
+char *
+b_write_gpu_usage(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
+char *
+b_write_gpu_usage_vram(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
+char *
+b_write_gpu_usage_power(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
+
+#	endif /* B_GPU */
 
 #endif /* B_GPU_H */
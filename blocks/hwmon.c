@@ -0,0 +1,462 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+
+#ifdef HAVE_SYSFS
+
+#	include <dirent.h>
+#	include <fcntl.h>
+#	include <limits.h>
+#	include <stdio.h>
+#	include <stdlib.h>
+#	include <string.h>
+#	include <unistd.h>
+
+#	include "../macros.h"
+#	include "../utils.h"
+#	include "procfs.h"
+#	include "hwmon.h"
+
+#	ifndef PATH_MAX
+#		define PATH_MAX 4096
+#	endif
+
+typedef struct {
+	char chip[B_HWMON_NAME_MAX];
+	/* temp1 */
+	char sensor[B_HWMON_NAME_MAX];
+	/* Contents of temp1_label, or empty. */
+	char label[B_HWMON_NAME_MAX];
+	/* [N] in hwmon[N], for sorting. */
+	unsigned int hwmon;
+	/* .../hwmon[N]/temp1_input */
+	char *path;
+} b_hwmon_ty;
+
+typedef enum {
+	B_HWMON_UNINIT = 0,
+	/* Read from the cache, which may be stale. */
+	B_HWMON_CACHED,
+	/* Scanned in this process. */
+	B_HWMON_SCANNED
+} b_hwmon_state_ty;
+
+static b_hwmon_ty b_hwmon[B_HWMON_MAX];
+static unsigned int b_hwmon_len;
+static b_hwmon_state_ty b_hwmon_state;
+
+/* Remember the result for each spec, since blocks pass the same one. */
+static struct {
+	const char *spec;
+	const b_hwmon_ty *e;
+} b_hwmon_specs[16];
+static unsigned int b_hwmon_specs_len;
+
+/* Paths may still be held by callers, e.g., as keys of the fd pool, so
+ * they are not freed. This happens at most once, on a stale cache. */
+static void
+b_hwmon_clear(void)
+{
+	b_hwmon_len = 0;
+	b_hwmon_specs_len = 0;
+}
+
+/* Read the first line of a small file. Return -1 on error. */
+static int
+b_hwmon_read_line(const char *path, char *dst, unsigned int dst_size)
+{
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+	const ssize_t read_sz = read(fd, dst, dst_size - 1);
+	close(fd);
+	if (read_sz <= 0)
+		return -1;
+	dst[read_sz] = '\0';
+	char *nl = strchr(dst, '\n');
+	if (nl)
+		*nl = '\0';
+	return 0;
+}
+
+static int
+b_hwmon_add(const char *chip, const char *sensor, unsigned int sensor_len, const char *label, unsigned int hwmon, const char *path)
+{
+	if (unlikely(b_hwmon_len == B_HWMON_MAX))
+		return 0;
+	b_hwmon_ty *e = &b_hwmon[b_hwmon_len];
+	e->path = strdup(path);
+	if (unlikely(e->path == NULL))
+		return -1;
+	u_stpcpy_len(e->chip, chip, MIN(strlen(chip), sizeof(e->chip) - 1));
+	u_stpcpy_len(e->sensor, sensor, MIN(sensor_len, sizeof(e->sensor) - 1));
+	u_stpcpy_len(e->label, label, MIN(strlen(label), sizeof(e->label) - 1));
+	e->hwmon = hwmon;
+	++b_hwmon_len;
+	return 0;
+}
+
+/* Add the sensors of .../hwmon[N]. */
+static int
+b_hwmon_scan_dir(char *path, char *path_e, unsigned int hwmon)
+{
+	char chip[B_HWMON_NAME_MAX];
+	u_stpcpy_len(path_e, S_LITERAL("/name"));
+	if (b_hwmon_read_line(path, chip, sizeof(chip)) == -1)
+		return 0;
+	*path_e = '\0';
+	DIR *dp = opendir(path);
+	if (dp == NULL)
+		return 0;
+	struct dirent *ep;
+	while ((ep = readdir(dp))) {
+		/* [sensor]_input */
+		const size_t name_len = strlen(ep->d_name);
+		if (name_len <= S_LEN("_input") || memcmp(ep->d_name + name_len - S_LEN("_input"), S_LITERAL("_input")))
+			continue;
+		const unsigned int sensor_len = (unsigned int)(name_len - S_LEN("_input"));
+		if (sensor_len >= B_HWMON_NAME_MAX)
+			continue;
+		/* [sensor]_label */
+		char label[B_HWMON_NAME_MAX];
+		char *p = u_stpcpy_len(path_e, S_LITERAL("/"));
+		u_stpcpy_len(u_stpcpy_len(p, ep->d_name, sensor_len), S_LITERAL("_label"));
+		if (b_hwmon_read_line(path, label, sizeof(label)) == -1)
+			*label = '\0';
+		u_stpcpy_len(p, ep->d_name, name_len);
+		if (unlikely(b_hwmon_add(chip, ep->d_name, sensor_len, label, hwmon, path) == -1)) {
+			closedir(dp);
+			return -1;
+		}
+	}
+	closedir(dp);
+	return 0;
+}
+
+/* Split temp12 into "temp" and 12. */
+static unsigned int
+b_hwmon_sensor_num(const char *sensor, unsigned int *prefix_len)
+{
+	const char *p = sensor;
+	while (*p && !u_isdigit(*p))
+		++p;
+	*prefix_len = (unsigned int)(p - sensor);
+	return u_atou10(p);
+}
+
+static int
+b_hwmon_cmp(const void *a, const void *b)
+{
+	const b_hwmon_ty *p = (const b_hwmon_ty *)a;
+	const b_hwmon_ty *q = (const b_hwmon_ty *)b;
+	if (p->hwmon != q->hwmon)
+		return p->hwmon < q->hwmon ? -1 : 1;
+	unsigned int p_len, q_len;
+	const unsigned int p_num = b_hwmon_sensor_num(p->sensor, &p_len);
+	const unsigned int q_num = b_hwmon_sensor_num(q->sensor, &q_len);
+	const int cmp = strncmp(p->sensor, q->sensor, MIN(p_len, q_len));
+	if (cmp || p_len != q_len)
+		return cmp ? cmp : (p_len < q_len ? -1 : 1);
+	return (p_num > q_num) - (p_num < q_num);
+}
+
+static int
+b_hwmon_scan(void)
+{
+	b_hwmon_clear();
+	char path[PATH_MAX];
+	const char *root = b_sysfs_root();
+	if (unlikely(strlen(root) + S_LEN("/class/hwmon/") + NAME_MAX + S_LEN("/") + NAME_MAX >= sizeof(path)))
+		return -1;
+	char *path_e = u_stpcpy_len(u_stpcpy(path, root), S_LITERAL("/class/hwmon"));
+	DIR *dp = opendir(path);
+	/* No hwmon devices, e.g., in a VM. */
+	if (dp == NULL)
+		return 0;
+	struct dirent *ep;
+	while ((ep = readdir(dp))) {
+		if (strncmp(ep->d_name, "hwmon", S_LEN("hwmon")) || !u_isdigit(ep->d_name[S_LEN("hwmon")]))
+			continue;
+		char *dir_e = u_stpcpy(u_stpcpy_len(path_e, S_LITERAL("/")), ep->d_name);
+		if (unlikely(b_hwmon_scan_dir(path, dir_e, u_atou10(ep->d_name + S_LEN("hwmon"))) == -1)) {
+			closedir(dp);
+			return -1;
+		}
+	}
+	closedir(dp);
+	qsort(b_hwmon, b_hwmon_len, sizeof(b_hwmon[0]), b_hwmon_cmp);
+	return 0;
+}
+
+/* The cache lives in $XDG_RUNTIME_DIR, which is cleared on logout, and
+ * records the boot and the sysfs root it is valid for:
+ *   [boot_id]
+ *   [sysfs root]
+ *   [chip]\t[sensor]\t[label]\t[path]
+ *   ... */
+static int
+b_hwmon_cache_path(char *dst, unsigned int dst_size)
+{
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	if (dir == NULL || *dir == '\0')
+		return -1;
+	if (strlen(dir) + S_LEN("/dwmblocks-fast-hwmon.tmp") >= dst_size)
+		return -1;
+	u_stpcpy_len(u_stpcpy(dst, dir), S_LITERAL("/dwmblocks-fast-hwmon"));
+	return 0;
+}
+
+static int
+b_hwmon_boot_id(char *dst, unsigned int dst_size)
+{
+	return b_hwmon_read_line("/proc/sys/kernel/random/boot_id", dst, dst_size);
+}
+
+static void
+b_hwmon_cache_write(void)
+{
+	char path[PATH_MAX];
+	char boot_id[64];
+	if (b_hwmon_cache_path(path, sizeof(path)) == -1 || b_hwmon_boot_id(boot_id, sizeof(boot_id)) == -1)
+		return;
+	char tmp[PATH_MAX];
+	u_stpcpy_len(u_stpcpy(tmp, path), S_LITERAL(".tmp"));
+	FILE *fp = fopen(tmp, "w");
+	if (fp == NULL)
+		return;
+	fputs(boot_id, fp);
+	fputc('\n', fp);
+	fputs(b_sysfs_root(), fp);
+	fputc('\n', fp);
+	for (unsigned int i = 0; i < b_hwmon_len; ++i) {
+		fputs(b_hwmon[i].chip, fp);
+		fputc('\t', fp);
+		fputs(b_hwmon[i].sensor, fp);
+		fputc('\t', fp);
+		fputs(b_hwmon[i].label, fp);
+		fputc('\t', fp);
+		fputs(b_hwmon[i].path, fp);
+		fputc('\n', fp);
+	}
+	/* Replace the old cache atomically. */
+	if (fclose(fp) != 0 || rename(tmp, path) == -1)
+		unlink(tmp);
+}
+
+/* Return the next \t or \n-terminated field of a cache line. */
+static char *
+b_hwmon_cache_field(char **p, int delimiter)
+{
+	char *field = *p;
+	char *end = strchr(field, delimiter);
+	if (end == NULL)
+		return NULL;
+	*end = '\0';
+	*p = end + 1;
+	return field;
+}
+
+static int
+b_hwmon_cache_read(void)
+{
+	char path[PATH_MAX];
+	char boot_id[64];
+	if (b_hwmon_cache_path(path, sizeof(path)) == -1 || b_hwmon_boot_id(boot_id, sizeof(boot_id)) == -1)
+		return -1;
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+	static char buf[B_HWMON_MAX * (3 * B_HWMON_NAME_MAX + 128) + 1];
+	const ssize_t read_sz = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (read_sz <= 0 || read_sz == sizeof(buf) - 1)
+		return -1;
+	buf[read_sz] = '\0';
+	char *p = buf;
+	const char *cached_boot_id = b_hwmon_cache_field(&p, '\n');
+	const char *cached_root = b_hwmon_cache_field(&p, '\n');
+	if (cached_boot_id == NULL || cached_root == NULL || strcmp(cached_boot_id, boot_id) || strcmp(cached_root, b_sysfs_root()))
+		return -1;
+	b_hwmon_clear();
+	while (*p) {
+		const char *chip = b_hwmon_cache_field(&p, '\t');
+		const char *sensor = chip ? b_hwmon_cache_field(&p, '\t') : NULL;
+		const char *label = sensor ? b_hwmon_cache_field(&p, '\t') : NULL;
+		const char *input = label ? b_hwmon_cache_field(&p, '\n') : NULL;
+		if (input == NULL || b_hwmon_add(chip, sensor, (unsigned int)strlen(sensor), label, 0, input) == -1) {
+			b_hwmon_clear();
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+b_hwmon_index(void)
+{
+	if (b_hwmon_cache_read() == 0) {
+		b_hwmon_state = B_HWMON_CACHED;
+		return 0;
+	}
+	if (unlikely(b_hwmon_scan() == -1))
+		return -1;
+	b_hwmon_state = B_HWMON_SCANNED;
+	b_hwmon_cache_write();
+	return 0;
+}
+
+static const b_hwmon_ty *
+b_hwmon_find(const char *chip, unsigned int chip_len, const char *label)
+{
+	for (unsigned int i = 0; i < b_hwmon_len; ++i) {
+		const b_hwmon_ty *e = &b_hwmon[i];
+		if (strncmp(e->chip, chip, chip_len) || e->chip[chip_len] != '\0')
+			continue;
+		if (label == NULL) {
+			if (!strncmp(e->sensor, "temp", S_LEN("temp")))
+				return e;
+		} else if (!strcmp(e->label, label) || !strcmp(e->sensor, label)) {
+			return e;
+		}
+	}
+	return NULL;
+}
+
+/* Package sensors of common CPU drivers, in order of preference. */
+static const struct {
+	const char *chip;
+	const char *label;
+} b_hwmon_cpus[] = {
+	{ "coretemp", "Package id 0" },
+	{ "k10temp", "Tctl" },
+	{ "k10temp", "Tdie" },
+	{ "zenpower", "Tdie" },
+	{ "cpu_thermal", NULL },
+	{ "acpitz", NULL },
+};
+
+static const b_hwmon_ty *
+b_hwmon_lookup(const char *spec)
+{
+	if (spec == NULL) {
+		for (unsigned int i = 0; i < sizeof(b_hwmon_cpus) / sizeof(b_hwmon_cpus[0]); ++i) {
+			const b_hwmon_ty *e = b_hwmon_find(b_hwmon_cpus[i].chip, (unsigned int)strlen(b_hwmon_cpus[i].chip), b_hwmon_cpus[i].label);
+			if (e)
+				return e;
+		}
+		return NULL;
+	}
+	const char *colon = strchr(spec, ':');
+	if (colon == NULL)
+		return b_hwmon_find(spec, (unsigned int)strlen(spec), NULL);
+	return b_hwmon_find(spec, (unsigned int)(colon - spec), colon + 1);
+}
+
+/* Return 1 if e is still what its path points to. hwmon[N] is renumbered
+ * when drivers are loaded in another order, e.g., after a module reload,
+ * so the path may exist but belong to another chip. */
+static int
+b_hwmon_valid(const b_hwmon_ty *e)
+{
+	const char *slash = strrchr(e->path, '/');
+	char path[PATH_MAX];
+	if (slash == NULL || (size_t)(slash - e->path) + S_LEN("/") + sizeof(e->sensor) + S_LEN("_label") >= sizeof(path))
+		return 0;
+	char *path_e = u_stpcpy_len(path, e->path, (size_t)(slash - e->path));
+	char buf[B_HWMON_NAME_MAX];
+	u_stpcpy_len(path_e, S_LITERAL("/name"));
+	if (b_hwmon_read_line(path, buf, sizeof(buf)) == -1 || strcmp(buf, e->chip))
+		return 0;
+	if (*e->label) {
+		u_stpcpy_len(u_stpcpy(u_stpcpy_len(path_e, S_LITERAL("/")), e->sensor), S_LITERAL("_label"));
+		if (b_hwmon_read_line(path, buf, sizeof(buf)) == -1 || strcmp(buf, e->label))
+			return 0;
+	}
+	return access(e->path, F_OK) == 0;
+}
+
+/* Rescan if the cache does not match the system. */
+static int
+b_hwmon_rescan_stale(int stale)
+{
+	if (b_hwmon_state != B_HWMON_CACHED || !stale)
+		return 0;
+	if (unlikely(b_hwmon_scan() == -1))
+		return -1;
+	b_hwmon_state = B_HWMON_SCANNED;
+	b_hwmon_cache_write();
+	return 1;
+}
+
+unsigned int
+b_hwmon_temps(const char *chip, const char **paths, unsigned int paths_max)
+{
+	if (unlikely(b_hwmon_state == B_HWMON_UNINIT))
+		if (unlikely(b_hwmon_index() == -1))
+			return 0;
+	for (;;) {
+		const char *name = chip;
+		if (name == NULL) {
+			const b_hwmon_ty *cpu = b_hwmon_lookup(NULL);
+			name = cpu ? cpu->chip : "";
+		}
+		unsigned int n = 0;
+		int stale = 0;
+		for (unsigned int i = 0; i < b_hwmon_len && n < paths_max; ++i) {
+			const b_hwmon_ty *e = &b_hwmon[i];
+			if (strcmp(e->chip, name) || strncmp(e->sensor, "temp", S_LEN("temp")))
+				continue;
+			stale |= !b_hwmon_valid(e);
+			paths[n++] = e->path;
+		}
+		const int ret = b_hwmon_rescan_stale(stale || n == 0);
+		if (unlikely(ret == -1))
+			return 0;
+		if (ret == 0)
+			return n;
+	}
+}
+
+const char *
+b_hwmon_path(const char *spec)
+{
+	for (unsigned int i = 0; i < b_hwmon_specs_len; ++i)
+		if (b_hwmon_specs[i].spec == spec)
+			return b_hwmon_specs[i].e->path;
+	if (unlikely(b_hwmon_state == B_HWMON_UNINIT))
+		if (unlikely(b_hwmon_index() == -1))
+			return NULL;
+	const b_hwmon_ty *e = b_hwmon_lookup(spec);
+	/* The cache may be stale, e.g., a device was unplugged. */
+	const int ret = b_hwmon_rescan_stale(e == NULL || !b_hwmon_valid(e));
+	if (unlikely(ret == -1))
+		return NULL;
+	if (ret == 1)
+		e = b_hwmon_lookup(spec);
+	if (e == NULL)
+		return NULL;
+	if (b_hwmon_specs_len < sizeof(b_hwmon_specs) / sizeof(b_hwmon_specs[0])) {
+		b_hwmon_specs[b_hwmon_specs_len].spec = spec;
+		b_hwmon_specs[b_hwmon_specs_len].e = e;
+		++b_hwmon_specs_len;
+	}
+	return e->path;
+}
+
+#endif /* HAVE_SYSFS */
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_HWMON_H
+#	define B_HWMON_H 1
+
+#	include "../macros.h"
+
+#	ifdef HAVE_SYSFS
+
+/* ../blocks/hwmon.c */
+
+/* Maximum number of indexed sensors. */
+#		define B_HWMON_MAX 256
+#		define B_HWMON_NAME_MAX 32
+
+/* Return the *_input file of the sensor named by spec, which is one of:
+ *   chip:label   e.g., k10temp:Tctl, nvme:Composite, coretemp:Package id 0
+ *   chip:sensor  e.g., acpitz:temp1, for sensors without a label
+ *   chip         the first temperature sensor of chip
+ * If spec is NULL, guess the CPU package sensor.
+ * The result stays valid for the lifetime of the program.
+ * Return NULL if there is no such sensor. */
+const char *
+b_hwmon_path(const char *spec);
+/* Store the temperature inputs of all instances of chip, or of the CPU
+ * chip if NULL, into paths. Return how many were stored. */
+unsigned int
+b_hwmon_temps(const char *chip, const char **paths, unsigned int paths_max);
+
+#	endif /* HAVE_SYSFS */
+
+#endif /* B_HWMON_H */
@@ -17,25 +17,120 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
 
 #include "../config.h"
+
+#include <unistd.h>
+#ifdef HAVE_PIDFD_OPEN
+#	include <poll.h>
+#	include <sys/syscall.h>
+#	ifndef SYS_pidfd_open
+#		undef HAVE_PIDFD_OPEN
+#	endif
+#endif
+
 #include "../blocks/procfs.h"
+#include "../blocks/procwatch.h"
+#include "../blocks/obs.h"
 #include "../macros.h"
 #include "../utils.h"
 
 unsigned int b_obs_recording_pid;
 unsigned int b_obs_open_pid;
 
+static b_obs_proc_ty b_obs_open = { "obs", S_LEN("obs"), &b_obs_open_pid, -1, -1, b_write_obs_on };
+static b_obs_proc_ty b_obs_recording = { "obs-ffmpeg-mux", S_LEN("obs-ffmpeg-mux"), &b_obs_recording_pid, -1, -1, b_write_obs_recording };
+
+static int
+b_obs_proc_alive(const b_obs_proc_ty *proc)
+{
+	/* Construct path: /proc/[pid]/(status|comm). */
+#ifdef HAVE_PROCFS_PID_COMM
+	char fname[S_LEN("/proc/") + sizeof(unsigned int) * 8 + S_LEN("/comm") + 1];
+#else
+	char fname[S_LEN("/proc/") + sizeof(unsigned int) * 8 + S_LEN("/status") + 1];
+#endif
+	char *fname_e = fname;
+	/* /proc/ */
+	fname_e = u_stpcpy_len(fname_e, S_LITERAL("/proc/"));
+	/* /proc/[pid] */
+	fname_e = u_utoa_p(*proc->pid, fname_e);
+	/* /proc/[pid]/(status|comm) */
+#ifdef HAVE_PROCFS_PID_COMM
+	fname_e = u_stpcpy_len(fname_e, S_LITERAL("/comm"));
+#else
+	fname_e = u_stpcpy_len(fname_e, S_LITERAL("/status"));
+#endif
+	(void)fname_e;
+	return b_proc_exist_at(proc->name, proc->name_len, fname);
+}
+
+#ifdef HAVE_PIDFD_OPEN
+
+/* The process exited. */
+static int
+b_obs_pidfd_read(int fd, void *data)
+{
+	b_obs_proc_ty *proc = (b_obs_proc_ty *)data;
+	close(fd);
+	proc->pidfd = -1;
+	*proc->pid = 0;
+	b_procwatch_invalidate();
+	g_refresh(proc->block, NULL);
+	return -1;
+}
+
+/* Watch the cached pid with a pidfd, which becomes readable when the
+ * process exits. Return -1 if liveness has to be polled instead. */
+static int
+b_obs_pidfd_watch(b_obs_proc_ty *proc)
+{
+	const int fd = (int)syscall(SYS_pidfd_open, (pid_t)*proc->pid, 0);
+	if (fd == -1)
+		return -1;
+	/* The pid may have exited or been reused before we got the pidfd. */
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	if (poll(&pfd, 1, 0) != 0 || b_obs_proc_alive(proc) != 1) {
+		close(fd);
+		*proc->pid = 0;
+		return -1;
+	}
+	if (unlikely(g_watch_add(fd, b_obs_pidfd_read, proc) == -1)) {
+		close(fd);
+		return -1;
+	}
+	proc->pidfd = fd;
+	return 0;
+}
+
+#endif /* HAVE_PIDFD_OPEN */
+
 char *
-b_write_obs(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval, const char *proc_name, unsigned int proc_name_len, unsigned int *pid_cache, unsigned int proc_interval, const char *proc_icon_on, const char *proc_icon_off)
+b_write_obs(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval, b_obs_proc_ty *proc, unsigned int proc_interval, const char *proc_icon_on, const char *proc_icon_off)
 {
+	if (unlikely(proc->watch_id == -1)) {
+		proc->watch_id = b_procwatch_add(proc->name, proc->name_len, proc->block);
+		if (unlikely(proc->watch_id == -1))
+			DIE(return NULL);
+	}
+	/* Process events keep the pid up to date. No need to poll. */
+	if (b_procwatch_evented()) {
+		*proc->pid = b_procwatch_pid(proc->watch_id);
+		*interval = (unsigned short)-1;
+		dst = u_stpcpy(dst, *proc->pid ? proc_icon_on : proc_icon_off);
+		return dst;
+	}
 	/* Need to search /proc/[pid] for proc. */
-	if (*pid_cache == 0) {
+	if (*proc->pid == 0) {
 		/* Cache the pid to avoid searching for next calls. */
-		*pid_cache = b_proc_exist(proc_name, proc_name_len);
-		if (unlikely(*pid_cache == (unsigned int)-1))
+		*proc->pid = b_procwatch_pid(proc->watch_id);
+		if (unlikely(*proc->pid == (unsigned int)-1))
 			DIE(return NULL);
-		if (*pid_cache == 0) {
+#ifdef HAVE_PIDFD_OPEN
+		if (*proc->pid)
+			b_obs_pidfd_watch(proc);
+#endif
+		if (*proc->pid == 0) {
 			/* OBS is not recording, but still on. Keep checking. */
-			if (pid_cache == &b_obs_recording_pid && b_obs_open_pid)
+			if (proc == &b_obs_recording && b_obs_open_pid)
 				*interval = proc_interval;
 			/* OBS is closed. Stop checking. */
 			else
@@ -43,28 +138,11 @@ b_write_obs(char *dst, unsigned int dst_size, const char *unused, unsigned short
 			dst = u_stpcpy(dst, proc_icon_off);
 			return dst;
 		}
-	} else {
-		/* Construct path: /proc/[pid]/(status|comm). */
-#ifdef HAVE_PROCFS_PID_COMM
-		char fname[S_LEN("/proc/") + sizeof(unsigned int) * 8 + S_LEN("/comm") + 1];
-#else
-		char fname[S_LEN("/proc/") + sizeof(unsigned int) * 8 + S_LEN("/status") + 1];
-#endif
-		char *fname_e = fname;
-		/* /proc/ */
-		fname_e = u_stpcpy_len(fname_e, S_LITERAL("/proc/"));
-		/* /proc/[pid] */
-		fname_e = u_utoa_p(*pid_cache, fname_e);
-		/* /proc/[pid]/(status|comm) */
-#ifdef HAVE_PROCFS_PID_COMM
-		fname_e = u_stpcpy_len(fname_e, S_LITERAL("/comm"));
-#else
-		fname_e = u_stpcpy_len(fname_e, S_LITERAL("/status"));
-#endif
-		(void)fname_e;
-		int ret = b_proc_exist_at(proc_name, proc_name_len, fname);
+	} else if (proc->pidfd == -1) {
+		/* No pidfd, poll /proc/[pid]. */
+		const int ret = b_obs_proc_alive(proc);
 		if (ret == 0) {
-			*pid_cache = 0;
+			*proc->pid = 0;
 			*interval = (unsigned short)-1;
 			dst = u_stpcpy(dst, proc_icon_off);
 			return dst;
@@ -73,7 +151,8 @@ b_write_obs(char *dst, unsigned int dst_size, const char *unused, unsigned short
 		}
 	}
 	dst = u_stpcpy(dst, proc_icon_on);
-	*interval = proc_interval;
+	/* The pidfd reports the exit. No need to poll. */
+	*interval = (proc->pidfd == -1) ? proc_interval : (unsigned short)-1;
 	return dst;
 	(void)unused;
 	(void)dst_size;
@@ -82,7 +161,7 @@ b_write_obs(char *dst, unsigned int dst_size, const char *unused, unsigned short
 char *
 b_write_obs_on(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
 {
-	return b_write_obs(dst, dst_size, unused, interval, S_LITERAL("obs"), &b_obs_open_pid, INTERVAL_OBS_ON, ICON_OBS_ON, ICON_OBS_OFF);
+	return b_write_obs(dst, dst_size, unused, interval, &b_obs_open, INTERVAL_OBS_ON, ICON_OBS_ON, ICON_OBS_OFF);
 	(void)unused;
 	(void)dst_size;
 }
@@ -90,7 +169,7 @@ b_write_obs_on(char *dst, unsigned int dst_size, const char *unused, unsigned sh
 char *
 b_write_obs_recording(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
 {
-	return b_write_obs(dst, dst_size, unused, interval, S_LITERAL("obs-ffmpeg-mux"), &b_obs_recording_pid, INTERVAL_OBS_RECORDING, ICON_OBS_RECORDING_ON, ICON_OBS_RECORDING_OFF);
+	return b_write_obs(dst, dst_size, unused, interval, &b_obs_recording, INTERVAL_OBS_RECORDING, ICON_OBS_RECORDING_ON, ICON_OBS_RECORDING_OFF);
 	(void)unused;
 	(void)dst_size;
 }
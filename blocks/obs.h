@@ -19,10 +19,24 @@
 #ifndef B_OBS_H
 #	define B_OBS_H 1
 
+#	include "../dwmblocks-fast.h"
+
 /* ../blocks/obs.c */
 
+typedef struct {
+	const char *name;
+	unsigned int name_len;
+	/* Cached pid, 0 if not running. */
+	unsigned int *pid;
+	/* Id from b_procwatch_add. */
+	int watch_id;
+	/* Watched pidfd of *pid, or -1. */
+	int pidfd;
+	g_func_ty block;
+} b_obs_proc_ty;
+
 char *
-b_write_obs(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval, const char *proc_name, unsigned int proc_name_len, unsigned int proc_interval, const char *proc_icon, unsigned int *pid_cache);
+b_write_obs(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval, b_obs_proc_ty *proc, unsigned int proc_interval, const char *proc_icon_on, const char *proc_icon_off);
 char *
 b_write_obs_on(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
 char *
@@ -0,0 +1,285 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+
+#ifdef HAVE_POWERCAP
+
+#	include <dirent.h>
+#	include <fcntl.h>
+#	include <limits.h>
+#	include <string.h>
+#	include <time.h>
+#	include <unistd.h>
+
+#	include "../macros.h"
+#	include "../utils.h"
+#	include "../dwmblocks-fast.h"
+#	include "procfs.h"
+#	include "powercap.h"
+
+#	ifndef PATH_MAX
+#		define PATH_MAX 4096
+#	endif
+
+typedef struct {
+	/* intel-rapl:0:1 */
+	char id[B_POWERCAP_NAME_MAX];
+	/* package-0, core, uncore, dram, psys */
+	char name[B_POWERCAP_NAME_MAX];
+	/* energy_uj */
+	int fd;
+	unsigned long long max_range;
+	unsigned long long last_energy;
+	struct timespec last_time;
+	double watts;
+	int primed;
+} b_powercap_ty;
+
+static b_powercap_ty b_powercap[B_POWERCAP_MAX];
+static unsigned int b_powercap_len;
+static int b_powercap_init_done;
+static unsigned int b_powercap_time = (unsigned int)-1;
+
+unsigned long long
+b_powercap_energy_diff(unsigned long long curr, unsigned long long prev, unsigned long long max_range_uj)
+{
+	return (curr >= prev) ? curr - prev : curr + max_range_uj - prev;
+}
+
+static int
+b_powercap_read_ull(int fd, unsigned long long *n)
+{
+	char buf[S_LEN("18446744073709551615") + 2];
+	const unsigned int read_sz = b_proc_read_filefd(buf, sizeof(buf), fd);
+	if (read_sz == (unsigned int)-1 || read_sz == 0 || !u_isdigit(*buf))
+		return -1;
+	*n = u_atoull10(buf);
+	return 0;
+}
+
+/* Add the zone id in path, which is modified. */
+static void
+b_powercap_add(const char *id, char *path, char *path_e)
+{
+	if (unlikely(b_powercap_len == B_POWERCAP_MAX))
+		return;
+	const size_t id_len = strlen(id);
+	if (unlikely(id_len >= B_POWERCAP_NAME_MAX))
+		return;
+	b_powercap_ty *z = &b_powercap[b_powercap_len];
+	memcpy(z->id, id, id_len + 1);
+	/* name */
+	u_stpcpy_len(path_e, S_LITERAL("/name"));
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return;
+	const unsigned int name_len = b_proc_read_filefd(z->name, sizeof(z->name), fd);
+	close(fd);
+	if (name_len == (unsigned int)-1 || name_len == 0)
+		return;
+	if (z->name[name_len - 1] == '\n')
+		z->name[name_len - 1] = '\0';
+	/* max_energy_range_uj */
+	u_stpcpy_len(path_e, S_LITERAL("/max_energy_range_uj"));
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return;
+	const int ret = b_powercap_read_ull(fd, &z->max_range);
+	close(fd);
+	if (ret == -1)
+		return;
+	/* energy_uj, which is kept open. Needs cap_dac_read_search. */
+	u_stpcpy_len(path_e, S_LITERAL("/energy_uj"));
+	z->fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (z->fd == -1)
+		return;
+	z->primed = 0;
+	++b_powercap_len;
+}
+
+static int
+b_powercap_init(void)
+{
+	char path[PATH_MAX];
+	const char *root = b_sysfs_root();
+	if (unlikely(strlen(root) + S_LEN("/class/powercap/") + NAME_MAX + S_LEN("/max_energy_range_uj") >= sizeof(path)))
+		return -1;
+	char *path_e = u_stpcpy_len(u_stpcpy(path, root), S_LITERAL("/class/powercap"));
+	DIR *dp = opendir(path);
+	/* No powercap, e.g., in a VM. */
+	if (dp == NULL)
+		return 0;
+	struct dirent *ep;
+	/* Zones and subzones are all linked here: intel-rapl:0, intel-rapl:0:1.
+	 * AMD CPUs use the same names. Skip intel-rapl-mmio, which mirrors the
+	 * package zone through MMIO and would be counted twice. */
+	while ((ep = readdir(dp))) {
+		if (strncmp(ep->d_name, "intel-rapl:", S_LEN("intel-rapl:")))
+			continue;
+		char *dir_e = u_stpcpy(u_stpcpy_len(path_e, S_LITERAL("/")), ep->d_name);
+		b_powercap_add(ep->d_name, path, dir_e);
+	}
+	closedir(dp);
+	return 0;
+}
+
+static int
+b_powercap_init_once(void)
+{
+	if (likely(b_powercap_init_done))
+		return 0;
+	b_powercap_init_done = 1;
+	return b_powercap_init();
+}
+
+static int
+b_powercap_sample_zone(b_powercap_ty *z)
+{
+	unsigned long long energy;
+	if (unlikely(b_powercap_read_ull(z->fd, &energy) == -1))
+		return -1;
+	struct timespec now;
+	if (unlikely(clock_gettime(CLOCK_MONOTONIC, &now) != 0))
+		return -1;
+	if (z->primed) {
+		const double secs = (double)(now.tv_sec - z->last_time.tv_sec) + (double)(now.tv_nsec - z->last_time.tv_nsec) / 1000000000;
+		const unsigned long long diff = b_powercap_energy_diff(energy, z->last_energy, z->max_range);
+		z->watts = (secs > 0) ? (double)diff / (secs * 1000000.0) : 0;
+	}
+	z->last_energy = energy;
+	z->last_time = now;
+	z->primed = 1;
+	return 0;
+}
+
+int
+b_powercap_sample(void)
+{
+	if (unlikely(b_powercap_init_once() == -1))
+		return -1;
+	/* Blocks of different domains share one pass. */
+	if (b_powercap_time == g_time)
+		return (int)b_powercap_len;
+	b_powercap_time = g_time;
+	for (unsigned int i = 0; i < b_powercap_len; ++i)
+		if (unlikely(b_powercap_sample_zone(&b_powercap[i]) == -1))
+			return -1;
+	return (int)b_powercap_len;
+}
+
+int
+b_powercap_prime(void)
+{
+	if (unlikely(b_powercap_init_once() == -1))
+		return -1;
+	int ret = 0;
+	for (unsigned int i = 0; i < b_powercap_len; ++i) {
+		b_powercap_ty *z = &b_powercap[i];
+		if (z->primed)
+			continue;
+		if (unlikely(b_powercap_sample_zone(z) == -1))
+			return -1;
+		ret = 1;
+	}
+	return ret;
+}
+
+char *
+b_powercap_save(char *dst)
+{
+	for (unsigned int i = 0; i < b_powercap_len; ++i) {
+		const b_powercap_ty *z = &b_powercap[i];
+		if (!z->primed)
+			continue;
+		dst = u_stpcpy(u_stpcpy_len(dst, S_LITERAL("rapl ")), z->id);
+		*dst++ = ' ';
+		dst = u_ulltoa_p(z->last_energy, dst);
+		*dst++ = ' ';
+		dst = u_ulltoa_p((unsigned long long)z->last_time.tv_sec, dst);
+		*dst++ = ' ';
+		dst = u_ulltoa_p((unsigned long long)z->last_time.tv_nsec, dst);
+		*dst++ = '\n';
+	}
+	return dst;
+}
+
+void
+b_powercap_load(const char *s)
+{
+	if (unlikely(b_powercap_init_once() == -1))
+		return;
+	const char *id_e = strchr(s, ' ');
+	if (id_e == NULL)
+		return;
+	const size_t id_len = (size_t)(id_e - s);
+	for (unsigned int i = 0; i < b_powercap_len; ++i) {
+		b_powercap_ty *z = &b_powercap[i];
+		if (z->primed || strncmp(z->id, s, id_len) || z->id[id_len] != '\0')
+			continue;
+		const char *p = id_e + 1;
+		const unsigned long long energy = u_strtoull10(p, &p);
+		if (*p++ != ' ')
+			return;
+		const unsigned long long sec = u_strtoull10(p, &p);
+		if (*p++ != ' ')
+			return;
+		const unsigned long long nsec = u_strtoull10(p, &p);
+		if (energy > z->max_range || nsec >= 1000000000)
+			return;
+		z->last_energy = energy;
+		z->last_time.tv_sec = (time_t)sec;
+		z->last_time.tv_nsec = (long)nsec;
+		z->primed = 1;
+		return;
+	}
+}
+
+double
+b_powercap_watts(const char *domain)
+{
+	const int package = (domain == NULL || !strcmp(domain, "package"));
+	double watts = 0;
+	int found = 0;
+	for (unsigned int i = 0; i < b_powercap_len; ++i) {
+		const b_powercap_ty *z = &b_powercap[i];
+		if (package ? strncmp(z->name, "package-", S_LEN("package-")) : strcmp(z->name, domain))
+			continue;
+		watts += z->watts;
+		found = 1;
+	}
+	return found ? watts : -1;
+}
+
+char *
+b_write_power(char *dst, unsigned int dst_size, const char *domain, unsigned short *interval)
+{
+	const int n = b_powercap_sample();
+	if (unlikely(n == -1))
+		DIE(return NULL);
+	const double watts = b_powercap_watts(domain);
+	/* No RAPL, or no access to energy_uj. */
+	if (watts < 0) {
+		*interval = (unsigned short)-1;
+		return dst;
+	}
+	return u_utoa_le3_p((unsigned int)watts, dst);
+	(void)dst_size;
+}
+
+#endif /* HAVE_POWERCAP */
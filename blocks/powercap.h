@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_POWERCAP_H
+#	define B_POWERCAP_H 1
+
+#	include "../macros.h"
+
+#	ifdef HAVE_POWERCAP
+
+/* ../blocks/powercap.c */
+
+/* Maximum number of RAPL zones, counting subzones. */
+#		define B_POWERCAP_MAX 32
+#		define B_POWERCAP_NAME_MAX 32
+
+/* Return energy consumed in uJ between two RAPL counter snapshots,
+ * correcting for the wrap of the counter at max_range_uj.
+ * Tested by tests/test-edge-cases.c. */
+unsigned long long
+b_powercap_energy_diff(unsigned long long curr, unsigned long long prev, unsigned long long max_range_uj);
+/* Read the energy counters of all zones, at most once per tick.
+ * Return the number of zones, or -1 on error. */
+int
+b_powercap_sample(void);
+/* Take the first sample of zones that have none, ignoring the per-tick
+ * cache. Return 1 if one was taken, 0 if not, or -1 on error. */
+int
+b_powercap_prime(void);
+/* Write the last samples as "rapl <zone> <energy_uj> <sec> <nsec>\n"
+ * lines and return the end. The time is CLOCK_MONOTONIC.
+ * Async-signal-safe. */
+char *
+b_powercap_save(char *dst);
+/* Restore a sample from the text after "rapl ". */
+void
+b_powercap_load(const char *s);
+/* Return the power in W drawn by domain since the previous sample,
+ * summed over all zones of that name, e.g., "dram" on every socket.
+ * "package" or NULL sums package-0, package-1, ...
+ * Return -1 if there is no such domain. */
+double
+b_powercap_watts(const char *domain);
+/* Power of a RAPL domain: package, core, uncore, dram, psys. */
+char *
+b_write_power(char *dst, unsigned int dst_size, const char *domain, unsigned short *interval);
+
+#	endif /* HAVE_POWERCAP */
+
+#endif /* B_POWERCAP_H */
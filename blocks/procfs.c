@@ -17,8 +17,8 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
 
 #include <fcntl.h>
-#include <dirent.h>
 #include <stdlib.h>
+#include <sys/syscall.h>
 #include <assert.h>
 #include <unistd.h>
 #include <errno.h>
@@ -180,48 +180,327 @@ b_proc_iter_next(struct b_proc_iter *iter, const char **key, unsigned int *key_l
 	return 0;
 }
 
-unsigned int
-b_proc_exist(const char *proc_name, unsigned int proc_name_len)
+/* Return the process name in the contents of /proc/[pid]/(status|comm). */
+static ATTR_INLINE const char *
+b_proc_name_get(const char *proc_buf, unsigned int proc_buf_sz, unsigned int *name_len)
 {
-	/* Construct path: /proc/[pid]/(status|comm). */
 #ifdef HAVE_PROCFS_PID_COMM
-	char fname[S_LEN("/proc/") + sizeof(unsigned int) * 8 + S_LEN("/comm") + 1];
+	if (proc_buf_sz && proc_buf[proc_buf_sz - 1] == '\n')
+		--proc_buf_sz;
+	*name_len = proc_buf_sz;
+	return proc_buf;
 #else
-	char fname[S_LEN("/proc/") + sizeof(unsigned int) * 8 + S_LEN("/status") + 1];
+	const char *p = u_strstr_len(proc_buf, proc_buf_sz, S_LITERAL("Name:\t"));
+	if (p == NULL)
+		return NULL;
+	p += S_LEN("Name:\t");
+	const char *end = (const char *)memchr(p, '\n', proc_buf_sz - (p - proc_buf));
+	*name_len = end ? (unsigned int)(end - p) : proc_buf_sz - (p - proc_buf);
+	return p;
 #endif
-	char *fnamep = fname;
-	/* /proc/ */
-	fnamep = u_stpcpy_len(fnamep, S_LITERAL("/proc/"));
-	/* Open /proc/ */
-	DIR *dp = opendir("/proc/");
-	if (unlikely(dp == NULL))
-		return (unsigned int)-1;
-	struct dirent *ep;
-	errno = 0;
-	while ((ep = readdir(dp))) {
-		/* Enter /proc/[pid] */
-		if (*(ep->d_name) == '.' || !u_isdigit(*(ep->d_name)))
+}
+
+static ATTR_INLINE unsigned int
+b_proc_hash(const char *s, unsigned int len)
+{
+	/* FNV-1a */
+	unsigned int h = 2166136261u;
+	for (; len--; ++s)
+		h = (h ^ (unsigned char)*s) * 16777619u;
+	return h;
+}
+
+/* Return non-zero if /proc/[pid] has exited but has not been reaped. */
+static int
+b_proc_zombie_at(int proc_fd, const char *pid_path, unsigned int pid_path_len)
+{
+	char fname[S_LEN("4294967295") + S_LEN("/stat") + 1];
+	u_stpcpy_len(u_stpcpy_len(fname, pid_path, pid_path_len), S_LITERAL("/stat"));
+	const int fd = openat(proc_fd, fname, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return 1;
+	char buf[512];
+	const ssize_t read_sz = read(fd, buf, sizeof(buf));
+	close(fd);
+	if (read_sz <= 0)
+		return 1;
+	/* [pid] ([name]) [state] ... The name may contain ')'. */
+	const char *p = buf + read_sz;
+	while (--p > buf && *p != ')') {}
+	if (*p != ')' || buf + read_sz - p < 3)
+		return 0;
+	return p[2] == 'Z' || p[2] == 'X';
+}
+
+static int b_proc_fd = -1;
+static union {
+	struct b_proc_dirent64 d;
+	char buf[32 * 1024];
+} b_proc_dents;
+
+/* Open or rewind /proc for another scan. */
+static int
+b_proc_rewind(void)
+{
+	/* Keep /proc open and rewind it for the next scans. */
+	if (b_proc_fd == -1) {
+		b_proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (unlikely(b_proc_fd == -1))
+			return -1;
+	} else if (unlikely(lseek(b_proc_fd, 0, SEEK_SET) == -1)) {
+		return -1;
+	}
+	return 0;
+}
+
+int
+b_proc_exist_many(const char *const *proc_names, const unsigned int *proc_names_len, unsigned int n, unsigned int *pids)
+{
+	if (unlikely(n > B_PROC_NAMES_MAX))
+		return -1;
+	/* Open-addressed hash set of names. Slots hold index + 1. */
+	unsigned char set[B_PROC_NAMES_MAX * 2];
+	/* Index of the first of the same name, which the others copy, so
+	 * that all are found when each distinct name is. */
+	unsigned char first[B_PROC_NAMES_MAX];
+	unsigned int remaining = 0;
+	memset(set, 0, sizeof(set));
+	for (unsigned int i = 0; i < n; ++i) {
+		pids[i] = 0;
+		first[i] = (unsigned char)i;
+		unsigned int h = b_proc_hash(proc_names[i], proc_names_len[i]) & (sizeof(set) - 1);
+		for (; set[h]; h = (h + 1) & (sizeof(set) - 1)) {
+			const unsigned int j = set[h] - 1;
+			if (proc_names_len[j] == proc_names_len[i] && !memcmp(proc_names[j], proc_names[i], proc_names_len[i])) {
+				first[i] = (unsigned char)j;
+				break;
+			}
+		}
+		if (first[i] != i)
 			continue;
-		char *fname_e = fnamep;
-		/* /proc/[pid] */
-		fname_e = u_stpcpy(fname_e, ep->d_name);
-		/* /proc/[pid]/(status|comm) */
+		set[h] = (unsigned char)(i + 1);
+		++remaining;
+	}
+	if (unlikely(b_proc_rewind() == -1))
+		return -1;
+	if (remaining == 0)
+		return 0;
+	for (;;) {
+		const long nread = syscall(SYS_getdents64, b_proc_fd, b_proc_dents.buf, sizeof(b_proc_dents.buf));
+		if (unlikely(nread == -1))
+			return -1;
+		if (nread == 0)
+			break;
+		for (long off = 0; off < nread;) {
+			const struct b_proc_dirent64 *d = (const struct b_proc_dirent64 *)(b_proc_dents.buf + off);
+			off += d->d_reclen;
+			/* Enter /proc/[pid] */
+			if (!u_isdigit(*(d->d_name)))
+				continue;
+			/* [pid]/(status|comm) relative to /proc */
 #ifdef HAVE_PROCFS_PID_COMM
-		fname_e = u_stpcpy_len(fname_e, S_LITERAL("/comm"));
+			char fname[S_LEN("4294967295") + S_LEN("/comm") + 1];
+			char buf[64];
 #else
-		fname_e = u_stpcpy_len(fname_e, S_LITERAL("/status"));
+			char fname[S_LEN("4294967295") + S_LEN("/status") + 1];
+			char buf[B_PAGE_SIZE];
 #endif
-		const int ret = b_proc_exist_at(proc_name, proc_name_len, fname);
-		if (unlikely(ret == -1)) {
-			closedir(dp);
-			return (unsigned int)-1;
+			const unsigned int pid_len = (unsigned int)strlen(d->d_name);
+			if (unlikely(pid_len > S_LEN("4294967295")))
+				continue;
+			char *fname_e = u_stpcpy_len(fname, d->d_name, pid_len);
+#ifdef HAVE_PROCFS_PID_COMM
+			u_stpcpy_len(fname_e, S_LITERAL("/comm"));
+#else
+			u_stpcpy_len(fname_e, S_LITERAL("/status"));
+#endif
+			errno = 0;
+			const int fd = openat(b_proc_fd, fname, O_RDONLY | O_CLOEXEC);
+			if (fd == -1) {
+				/* The process has exited. */
+				if (likely(errno != ENOMEM))
+					continue;
+				return -1;
+			}
+			const ssize_t read_sz = read(fd, buf, sizeof(buf));
+			if (unlikely(close(fd) == -1))
+				return -1;
+			if (read_sz <= 0)
+				continue;
+			unsigned int name_len;
+			const char *name = b_proc_name_get(buf, (unsigned int)read_sz, &name_len);
+			if (name == NULL)
+				continue;
+			unsigned int h = b_proc_hash(name, name_len) & (sizeof(set) - 1);
+			for (; set[h]; h = (h + 1) & (sizeof(set) - 1)) {
+				const unsigned int i = set[h] - 1;
+				if (proc_names_len[i] != name_len || memcmp(proc_names[i], name, name_len))
+					continue;
+				if (pids[i] || b_proc_zombie_at(b_proc_fd, d->d_name, pid_len))
+					break;
+				pids[i] = u_atou10(d->d_name);
+				if (--remaining == 0)
+					goto out;
+				break;
+			}
 		}
-		if (ret)
-			return (unsigned int)atoi(ep->d_name);
 	}
-	if (unlikely(errno == EBADF))
+out:
+	for (unsigned int i = 0; i < n; ++i)
+		pids[i] = pids[first[i]];
+	return 0;
+}
+
+unsigned int
+b_proc_exist(const char *proc_name, unsigned int proc_name_len)
+{
+	unsigned int pid;
+	if (unlikely(b_proc_exist_many(&proc_name, &proc_name_len, 1, &pid) == -1))
 		return (unsigned int)-1;
-	if (unlikely(closedir(dp) == -1))
+	return pid;
+}
+
+/* Count the fds in /proc/[pid]/fd that point to link_prefix*. */
+static unsigned int
+b_proc_fd_count_at(int fd_dir, const char *link_prefix, unsigned int link_prefix_len)
+{
+	union {
+		struct b_proc_dirent64 d;
+		char buf[4096];
+	} u;
+	unsigned int count = 0;
+	for (;;) {
+		const long nread = syscall(SYS_getdents64, fd_dir, u.buf, sizeof(u.buf));
+		if (nread <= 0)
+			break;
+		for (long off = 0; off < nread;) {
+			const struct b_proc_dirent64 *d = (const struct b_proc_dirent64 *)(u.buf + off);
+			off += d->d_reclen;
+			if (!u_isdigit(*(d->d_name)))
+				continue;
+			char link[64];
+			const ssize_t link_len = readlinkat(fd_dir, d->d_name, link, sizeof(link));
+			if (link_len >= (ssize_t)link_prefix_len && !memcmp(link, link_prefix, link_prefix_len))
+				++count;
+		}
+	}
+	return count;
+}
+
+unsigned int
+b_proc_fd_count(const char *link_prefix, unsigned int link_prefix_len)
+{
+	if (unlikely(b_proc_rewind() == -1))
 		return (unsigned int)-1;
+	unsigned int count = 0;
+	for (;;) {
+		const long nread = syscall(SYS_getdents64, b_proc_fd, b_proc_dents.buf, sizeof(b_proc_dents.buf));
+		if (unlikely(nread == -1))
+			return (unsigned int)-1;
+		if (nread == 0)
+			break;
+		for (long off = 0; off < nread;) {
+			const struct b_proc_dirent64 *d = (const struct b_proc_dirent64 *)(b_proc_dents.buf + off);
+			off += d->d_reclen;
+			/* Enter /proc/[pid] */
+			if (!u_isdigit(*(d->d_name)))
+				continue;
+			const unsigned int pid_len = (unsigned int)strlen(d->d_name);
+			if (unlikely(pid_len > S_LEN("4294967295")))
+				continue;
+			/* [pid]/fd relative to /proc */
+			char fname[S_LEN("4294967295") + S_LEN("/fd") + 1];
+			u_stpcpy_len(u_stpcpy_len(fname, d->d_name, pid_len), S_LITERAL("/fd"));
+			/* Exited, or owned by another user without cap_dac_read_search. */
+			const int fd_dir = openat(b_proc_fd, fname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (fd_dir == -1)
+				continue;
+			count += b_proc_fd_count_at(fd_dir, link_prefix, link_prefix_len);
+			close(fd_dir);
+		}
+	}
+	return count;
+}
+
+/* Call fn with the fdinfo of each fd in fd_dir whose target starts with
+ * link_prefix. */
+static void
+b_proc_fdinfo_each_at(int pid_dir, int fd_dir, const char *link_prefix, unsigned int link_prefix_len, b_proc_fdinfo_fn_ty fn, void *data)
+{
+	union {
+		struct b_proc_dirent64 d;
+		char buf[4096];
+	} u;
+	char info[4096];
+	for (;;) {
+		const long nread = syscall(SYS_getdents64, fd_dir, u.buf, sizeof(u.buf));
+		if (nread <= 0)
+			break;
+		for (long off = 0; off < nread;) {
+			const struct b_proc_dirent64 *d = (const struct b_proc_dirent64 *)(u.buf + off);
+			off += d->d_reclen;
+			if (!u_isdigit(*(d->d_name)))
+				continue;
+			char link[64];
+			const ssize_t link_len = readlinkat(fd_dir, d->d_name, link, sizeof(link));
+			if (link_len < (ssize_t)link_prefix_len || memcmp(link, link_prefix, link_prefix_len))
+				continue;
+			char fname[S_LEN("fdinfo/") + S_LEN("4294967295") + 1];
+			const size_t fd_len = strlen(d->d_name);
+			if (unlikely(fd_len > S_LEN("4294967295")))
+				continue;
+			u_stpcpy_len(u_stpcpy_len(fname, S_LITERAL("fdinfo/")), d->d_name, fd_len);
+			const int fd = openat(pid_dir, fname, O_RDONLY | O_CLOEXEC);
+			if (fd == -1)
+				continue;
+			const unsigned int info_len = b_proc_read_filefd(info, sizeof(info), fd);
+			close(fd);
+			if (info_len != (unsigned int)-1 && info_len != 0)
+				fn(info, info_len, data);
+		}
+	}
+}
+
+int
+b_proc_fdinfo_each(const char *link_prefix, unsigned int link_prefix_len, b_proc_fdinfo_fn_ty fn, void *data)
+{
+	if (unlikely(b_proc_rewind() == -1))
+		return -1;
+	for (;;) {
+		const long nread = syscall(SYS_getdents64, b_proc_fd, b_proc_dents.buf, sizeof(b_proc_dents.buf));
+		if (unlikely(nread == -1))
+			return -1;
+		if (nread == 0)
+			break;
+		for (long off = 0; off < nread;) {
+			const struct b_proc_dirent64 *d = (const struct b_proc_dirent64 *)(b_proc_dents.buf + off);
+			off += d->d_reclen;
+			/* Enter /proc/[pid] */
+			if (!u_isdigit(*(d->d_name)))
+				continue;
+			/* Exited, or owned by another user without cap_dac_read_search. */
+			const int pid_dir = openat(b_proc_fd, d->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (pid_dir == -1)
+				continue;
+			const int fd_dir = openat(pid_dir, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (fd_dir != -1) {
+				b_proc_fdinfo_each_at(pid_dir, fd_dir, link_prefix, link_prefix_len, fn, data);
+				close(fd_dir);
+			}
+			close(pid_dir);
+		}
+	}
 	return 0;
 }
+
+const char *
+b_sysfs_root(void)
+{
+	static const char *root;
+	if (unlikely(root == NULL)) {
+		root = getenv("DWMBLOCKS_FAST_SYSFS");
+		if (root == NULL || *root == '\0')
+			root = "/sys";
+	}
+	return root;
+}
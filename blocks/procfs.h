@@ -25,10 +25,44 @@
 
 #define B_PAGE_SIZE 4096
 
+/* Maximum number of names for b_proc_exist_many. */
+#define B_PROC_NAMES_MAX 32
+
+/* Layout of the records returned by getdents64(2). */
+struct b_proc_dirent64 {
+	unsigned long long d_ino;
+	long long d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+int
+b_proc_name_match(const char *proc_buf, unsigned int proc_buf_sz, const char *proc_name, unsigned int proc_name_len);
 int
 b_proc_exist_at(const char *proc_name, unsigned int proc_name_len, const char *pid_status_path);
 unsigned int
 b_proc_exist(const char *proc_name, unsigned int proc_name_len);
+/* Find processes named proc_names[i] in one pass over /proc.
+ * pids[i] is set to the pid of a match, or 0 if none is running.
+ * A repeated name is matched once, and all of its entries get the same
+ * pid. Return -1 on error. */
+int
+b_proc_exist_many(const char *const *proc_names, const unsigned int *proc_names_len, unsigned int n, unsigned int *pids);
+/* Count open fds of all processes whose target starts with link_prefix.
+ * Processes that cannot be inspected are skipped. */
+unsigned int
+b_proc_fd_count(const char *link_prefix, unsigned int link_prefix_len);
+typedef void (*b_proc_fdinfo_fn_ty)(const char *fdinfo, unsigned int fdinfo_len, void *data);
+/* Call fn with /proc/[pid]/fdinfo/[fd] of each open fd, of all processes,
+ * whose target starts with link_prefix, e.g., "/dev/dri/". Processes that
+ * cannot be inspected are skipped. Return -1 on error. */
+int
+b_proc_fdinfo_each(const char *link_prefix, unsigned int link_prefix_len, b_proc_fdinfo_fn_ty fn, void *data);
+/* Return the root of sysfs, /sys unless overriden by $DWMBLOCKS_FAST_SYSFS,
+ * e.g., to run against a fixture tree. */
+const char *
+b_sysfs_root(void);
 unsigned int
 b_proc_read_file(char *dst, unsigned int dst_size, const char *filename);
 unsigned int
@@ -0,0 +1,363 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+
+#ifdef HAVE_PROCFS
+
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <string.h>
+#	include <errno.h>
+
+#	ifdef HAVE_PROC_CONNECTOR
+#		include <sys/socket.h>
+#		include <linux/netlink.h>
+#		include <linux/connector.h>
+#		include <linux/cn_proc.h>
+#	endif
+
+#	include "../macros.h"
+#	include "../utils.h"
+#	include "../dwmblocks-fast.h"
+#	include "procfs.h"
+#	include "procwatch.h"
+
+typedef struct {
+	const char *name;
+	unsigned int name_len;
+	unsigned int pid;
+	g_func_ty block;
+} b_procwatch_ty;
+
+typedef enum {
+	B_PROCWATCH_UNINIT = 0,
+	/* Scan /proc on each b_procwatch_pid. */
+	B_PROCWATCH_SCAN,
+	/* Track pids with proc connector events. */
+	B_PROCWATCH_EVENT
+} b_procwatch_state_ty;
+
+static b_procwatch_ty b_procwatch[B_PROCWATCH_MAX];
+static unsigned int b_procwatch_len;
+static b_procwatch_state_ty b_procwatch_state;
+/* When scanning, share one pass over /proc between blocks in a tick. */
+static unsigned int b_procwatch_scan_time = (unsigned int)-1;
+
+static void
+b_procwatch_set(b_procwatch_ty *w, unsigned int pid)
+{
+	if (w->pid == pid)
+		return;
+	DBG(fprintf(stderr, "%s:%d:%s: %s: %u -> %u\n", __FILE__, __LINE__, ASSERT_FUNC, w->name, w->pid, pid));
+	w->pid = pid;
+	g_refresh(w->block, NULL);
+}
+
+static int
+b_procwatch_scan(b_procwatch_ty *w)
+{
+	const unsigned int pid = b_proc_exist(w->name, w->name_len);
+	if (unlikely(pid == (unsigned int)-1))
+		return -1;
+	b_procwatch_set(w, pid);
+	return 0;
+}
+
+/* Look for all watched names in one pass over /proc. */
+static int
+b_procwatch_scan_all(void)
+{
+	const char *names[B_PROCWATCH_MAX];
+	unsigned int names_len[B_PROCWATCH_MAX];
+	unsigned int pids[B_PROCWATCH_MAX];
+	for (unsigned int i = 0; i < b_procwatch_len; ++i) {
+		names[i] = b_procwatch[i].name;
+		names_len[i] = b_procwatch[i].name_len;
+	}
+	if (unlikely(b_proc_exist_many(names, names_len, b_procwatch_len, pids) == -1))
+		return -1;
+	for (unsigned int i = 0; i < b_procwatch_len; ++i)
+		b_procwatch_set(&b_procwatch[i], pids[i]);
+	return 0;
+}
+
+#	ifdef HAVE_PROC_CONNECTOR
+
+/* A process replaced its image, so its comm may have changed. */
+static int
+b_procwatch_on_exec(unsigned int tgid)
+{
+	char fname[S_LEN("/proc/") + sizeof(unsigned int) * 8 + S_LEN("/comm") + 1];
+	char *fname_e = fname;
+	fname_e = u_stpcpy_len(fname_e, S_LITERAL("/proc/"));
+	fname_e = u_utoa_p(tgid, fname_e);
+	fname_e = u_stpcpy_len(fname_e, S_LITERAL("/comm"));
+	char buf[32];
+	const unsigned int read_sz = b_proc_read_file(buf, sizeof(buf), fname);
+	/* Already exited. */
+	if (read_sz == (unsigned int)-1)
+		return 0;
+	for (unsigned int i = 0; i < b_procwatch_len; ++i) {
+		b_procwatch_ty *w = &b_procwatch[i];
+		if (b_proc_name_match(buf, read_sz, w->name, w->name_len)) {
+			if (w->pid == 0)
+				b_procwatch_set(w, tgid);
+		} else if (w->pid == tgid) {
+			b_procwatch_set(w, 0);
+			/* Another instance may still be running. */
+			if (unlikely(b_procwatch_scan(w) == -1))
+				return -1;
+		}
+	}
+	return 0;
+}
+
+/* A thread renamed itself with prctl(PR_SET_NAME). */
+static int
+b_procwatch_on_comm(unsigned int pid, unsigned int tgid, const char *comm, unsigned int comm_size)
+{
+	/* Only the main thread names the process. */
+	if (pid != tgid)
+		return 0;
+	const char *nul = (const char *)memchr(comm, '\0', comm_size);
+	const unsigned int comm_len = nul ? (unsigned int)(nul - comm) : comm_size;
+	for (unsigned int i = 0; i < b_procwatch_len; ++i) {
+		b_procwatch_ty *w = &b_procwatch[i];
+		if (w->name_len == comm_len && !memcmp(w->name, comm, comm_len)) {
+			if (w->pid == 0)
+				b_procwatch_set(w, tgid);
+		} else if (w->pid == tgid) {
+			b_procwatch_set(w, 0);
+			/* Another instance may still be running. */
+			if (unlikely(b_procwatch_scan(w) == -1))
+				return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+b_procwatch_on_exit(unsigned int pid, unsigned int tgid)
+{
+	if (pid != tgid)
+		return 0;
+	for (unsigned int i = 0; i < b_procwatch_len; ++i) {
+		b_procwatch_ty *w = &b_procwatch[i];
+		if (w->pid == tgid) {
+			b_procwatch_set(w, 0);
+			/* Another instance may still be running. */
+			if (unlikely(b_procwatch_scan(w) == -1))
+				return -1;
+		}
+	}
+	return 0;
+}
+
+/* Handle the connector messages in buf. Return the error in the
+ * acknowledgement of PROC_CN_MCAST_LISTEN, if any, or -1 on error. */
+static int
+b_procwatch_handle(struct nlmsghdr *nl, int len)
+{
+	int ack = 0;
+	for (; NLMSG_OK(nl, len); nl = NLMSG_NEXT(nl, len)) {
+		if (nl->nlmsg_type == NLMSG_NOOP || nl->nlmsg_type == NLMSG_ERROR)
+			continue;
+		const struct cn_msg *cn = (const struct cn_msg *)NLMSG_DATA(nl);
+		if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC)
+			continue;
+		const struct proc_event *ev = (const struct proc_event *)cn->data;
+		switch (ev->what) {
+		case PROC_EVENT_NONE:
+			if (ev->event_data.ack.err)
+				ack = (int)ev->event_data.ack.err;
+			break;
+		case PROC_EVENT_EXEC:
+			if (unlikely(b_procwatch_on_exec((unsigned int)ev->event_data.exec.process_tgid) == -1))
+				return -1;
+			break;
+		case PROC_EVENT_COMM:
+			if (unlikely(b_procwatch_on_comm((unsigned int)ev->event_data.comm.process_pid, (unsigned int)ev->event_data.comm.process_tgid, ev->event_data.comm.comm, sizeof(ev->event_data.comm.comm)) == -1))
+				return -1;
+			break;
+		case PROC_EVENT_EXIT:
+			if (unlikely(b_procwatch_on_exit((unsigned int)ev->event_data.exit.process_pid, (unsigned int)ev->event_data.exit.process_tgid) == -1))
+				return -1;
+			break;
+		default:
+			break;
+		}
+	}
+	return ack;
+}
+
+/* Drain the socket. Return the acknowledgement error, if any, or -1 on
+ * error. */
+static int
+b_procwatch_recv(int fd)
+{
+	union {
+		struct nlmsghdr nl;
+		char buf[B_PAGE_SIZE];
+	} u;
+	int ack = 0;
+	for (;;) {
+		const ssize_t len = recv(fd, u.buf, sizeof(u.buf), MSG_DONTWAIT);
+		if (len == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			if (errno == EINTR)
+				continue;
+			/* The socket buffer overran and events were lost. */
+			if (errno == ENOBUFS) {
+				if (unlikely(b_procwatch_scan_all() == -1))
+					return -1;
+				continue;
+			}
+			return -1;
+		}
+		const int ret = b_procwatch_handle(&u.nl, (int)len);
+		if (unlikely(ret == -1))
+			return -1;
+		if (ret)
+			ack = ret;
+	}
+	return ack;
+}
+
+static int
+b_procwatch_read(int fd, void *unused)
+{
+	if (likely(b_procwatch_recv(fd) == 0))
+		return 0;
+	/* Fall back to scanning and let the blocks poll again. */
+	close(fd);
+	b_procwatch_state = B_PROCWATCH_SCAN;
+	for (unsigned int i = 0; i < b_procwatch_len; ++i)
+		g_refresh(b_procwatch[i].block, NULL);
+	return -1;
+	(void)unused;
+}
+
+/* Subscribe to process events. Needs CAP_NET_ADMIN. */
+static int
+b_procwatch_nl_init(void)
+{
+	const int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_CONNECTOR);
+	if (fd == -1)
+		return -1;
+	struct sockaddr_nl sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+	sa.nl_groups = CN_IDX_PROC;
+	if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) == -1)
+		goto err;
+	union {
+		struct nlmsghdr nl;
+		char buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+	} u;
+	memset(&u, 0, sizeof(u));
+	u.nl.nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+	u.nl.nlmsg_type = NLMSG_DONE;
+	struct cn_msg *cn = (struct cn_msg *)NLMSG_DATA(&u.nl);
+	cn->id.idx = CN_IDX_PROC;
+	cn->id.val = CN_VAL_PROC;
+	cn->len = sizeof(enum proc_cn_mcast_op);
+	const enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+	memcpy(cn->data, &op, sizeof(op));
+	if (send(fd, u.buf, u.nl.nlmsg_len, 0) == -1)
+		goto err;
+	/* The kernel acknowledges with EPERM if we lack the capability. */
+	if (b_procwatch_recv(fd) != 0)
+		goto err;
+	return fd;
+err:
+	close(fd);
+	return -1;
+}
+
+#	endif /* HAVE_PROC_CONNECTOR */
+
+static void
+b_procwatch_init(void)
+{
+	b_procwatch_state = B_PROCWATCH_SCAN;
+#	ifdef HAVE_PROC_CONNECTOR
+	const int fd = b_procwatch_nl_init();
+	if (fd == -1) {
+		DBG(fprintf(stderr, "%s:%d:%s: proc connector unavailable, scanning /proc instead.\n", __FILE__, __LINE__, ASSERT_FUNC));
+		return;
+	}
+	if (unlikely(g_watch_add(fd, b_procwatch_read, NULL) == -1)) {
+		close(fd);
+		return;
+	}
+	b_procwatch_state = B_PROCWATCH_EVENT;
+#	endif
+}
+
+int
+b_procwatch_add(const char *name, unsigned int name_len, g_func_ty block)
+{
+	/* The same block asking again, e.g., after a restart of its watch. */
+	for (unsigned int i = 0; i < b_procwatch_len; ++i)
+		if (b_procwatch[i].block == block && b_procwatch[i].name_len == name_len && !memcmp(b_procwatch[i].name, name, name_len))
+			return (int)i;
+	if (unlikely(b_procwatch_len == B_PROCWATCH_MAX))
+		return -1;
+	if (unlikely(b_procwatch_state == B_PROCWATCH_UNINIT))
+		b_procwatch_init();
+	b_procwatch_ty *w = &b_procwatch[b_procwatch_len];
+	w->name = name;
+	w->name_len = name_len;
+	w->pid = 0;
+	w->block = block;
+	/* Events only report changes, so find running processes once. */
+	if (b_procwatch_state == B_PROCWATCH_EVENT) {
+		w->pid = b_proc_exist(name, name_len);
+		if (unlikely(w->pid == (unsigned int)-1))
+			return -1;
+	}
+	return (int)b_procwatch_len++;
+}
+
+unsigned int
+b_procwatch_pid(int id)
+{
+	b_procwatch_ty *w = &b_procwatch[id];
+	if (b_procwatch_state != B_PROCWATCH_EVENT && b_procwatch_scan_time != g_time) {
+		if (unlikely(b_procwatch_scan_all() == -1))
+			return (unsigned int)-1;
+		b_procwatch_scan_time = g_time;
+	}
+	return w->pid;
+}
+
+void
+b_procwatch_invalidate(void)
+{
+	b_procwatch_scan_time = (unsigned int)-1;
+}
+
+int
+b_procwatch_evented(void)
+{
+	return b_procwatch_state == B_PROCWATCH_EVENT;
+}
+
+#endif /* HAVE_PROCFS */
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_PROCWATCH_H
+#	define B_PROCWATCH_H 1
+
+#	include "../macros.h"
+#	include "../dwmblocks-fast.h"
+
+#	ifdef HAVE_PROCFS
+
+/* ../blocks/procwatch.c */
+
+/* Maximum number of watched process names. */
+#		define B_PROCWATCH_MAX 16
+
+/* Watch processes named name. block is refreshed when one starts or exits.
+ * Return an id for b_procwatch_pid, or -1 on error. */
+int
+b_procwatch_add(const char *name, unsigned int name_len, g_func_ty block);
+/* Return the pid of a process named by id, 0 if there is none, or
+ * (unsigned int)-1 on error. */
+unsigned int
+b_procwatch_pid(int id);
+/* Forget the result of the last scan, e.g., because a process exited. */
+void
+b_procwatch_invalidate(void);
+/* Return non-zero if processes are tracked with proc connector events.
+ * Otherwise, b_procwatch_pid scans /proc on each call. */
+int
+b_procwatch_evented(void);
+
+#	endif /* HAVE_PROCFS */
+
+#endif /* B_PROCWATCH_H */
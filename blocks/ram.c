@@ -19,8 +19,6 @@
 #include "../config.h"
 
 #ifdef HAVE_PROCFS
-/* #ifdef HAVE_SYSINFO */
-/* #include <sys/sysinfo.h> */
 
 #	include <stdio.h>
 #	include <fcntl.h>
@@ -29,32 +27,65 @@
 #	include "../utils.h"
 #	include "../dwmblocks-fast.h"
 #	include "procfs.h"
+#	include "fdpool.h"
 
-static int fd_ram = -1;
-static char b_meminfo[B_PAGE_SIZE + 1];
-static unsigned int b_meminfo_time = (unsigned int)-1;
-static unsigned int b_meminfo_sz;
+#	if USE_RAM_SYSINFO && defined HAVE_SYSINFO
+#		include <sys/sysinfo.h>
+
+static struct sysinfo b_sysinfo;
+static unsigned int b_sysinfo_time = (unsigned int)-1;
 
 static int
-b_ram_init(const char *filename)
+b_sysinfo_read(struct sysinfo *info)
+{
+	if (g_time != b_sysinfo_time) {
+		b_sysinfo_time = g_time;
+		if (unlikely(sysinfo(info) != 0))
+			DIE(return -1);
+	}
+	return 0;
+}
+
+/* sysinfo has no MemAvailable, so approximate it with free and buffer
+ * RAM. The page cache is counted as used. */
+static ATTR_INLINE unsigned long long
+b_sysinfo_avail(const struct sysinfo *info)
 {
-	int fd = open(filename, O_RDONLY);
-	if (unlikely(fd < 0))
-		return -1;
-	return fd;
+	return ((unsigned long long)info->freeram + (unsigned long long)info->bufferram) * info->mem_unit;
 }
 
+static int
+b_read_ram_usage_percent(void)
+{
+	if (unlikely(b_sysinfo_read(&b_sysinfo) == -1))
+		DIE(return -1);
+	const unsigned long long total = (unsigned long long)b_sysinfo.totalram * b_sysinfo.mem_unit;
+	if (unlikely(total == 0))
+		DIE(return -1);
+	const int percent = 100 - (int)((long double)b_sysinfo_avail(&b_sysinfo) / (long double)total * (long double)100);
+	return percent;
+}
+
+static unsigned long long
+b_read_ram_usage_available(void)
+{
+	if (unlikely(b_sysinfo_read(&b_sysinfo) == -1))
+		DIE(return (unsigned long long)-1);
+	return b_sysinfo_avail(&b_sysinfo);
+}
+
+#	else /* MemAvailable from /proc/meminfo */
+
+static char b_meminfo[B_PAGE_SIZE + 1];
+static unsigned int b_meminfo_time = (unsigned int)-1;
+static unsigned int b_meminfo_sz;
+
 static int
 b_meminfo_read(char *meminfo, unsigned int meminfo_sz)
 {
 	if (g_time != b_meminfo_time) {
 		b_meminfo_time = g_time;
-		if (unlikely(fd_ram == -1)) {
-			fd_ram = b_ram_init("/proc/meminfo");
-			if (unlikely(fd_ram < 0))
-				DIE(return -1);
-		}
-		b_meminfo_sz = b_proc_read_filefd(meminfo, meminfo_sz, fd_ram);
+		b_meminfo_sz = b_fdpool_read(meminfo, meminfo_sz, "/proc/meminfo");
 		if (unlikely(b_meminfo_sz == (unsigned int)-1))
 			DIE(return -1);
 	}
@@ -106,6 +137,8 @@ b_read_ram_usage_available(void)
 	return avail * U_KIB;
 }
 
+#	endif /* USE_RAM_SYSINFO */
+
 char *
 b_write_ram_usage_percent(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
 {
@@ -20,10 +20,450 @@
 #include <unistd.h>
 #include <string.h>
 
+#include "../config.h"
 #include "../macros.h"
+#include "../dwmblocks-fast.h"
+#include "../blocks/shell.h"
 
 #if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
 
+#	ifdef HAVE_POSIX_SPAWN
+#		include <stdio.h>
+#		include <stdlib.h>
+#		include <errno.h>
+#		include <fcntl.h>
+#		include <poll.h>
+#		include <pthread.h>
+#		include <signal.h>
+#		include <spawn.h>
+#		include <time.h>
+#		include <sys/wait.h>
+#		ifdef HAVE_PIDFD_OPEN
+#			include <sys/syscall.h>
+#			ifndef SYS_pidfd_open
+#				undef HAVE_PIDFD_OPEN
+#			endif
+#		endif
+
+#		include "defer.h"
+
+extern char **environ;
+
+/* Words of a command that is run without the shell. */
+#		define B_SHELL_ARGV_MAX 16
+/* Commands whose words are kept. The others go through the shell. */
+#		define B_SHELL_CMDS_MAX 32
+
+typedef struct {
+	const char *cmd;
+	/* NULL-terminated, or argv[0] is NULL if cmd needs the shell. */
+	char *argv[B_SHELL_ARGV_MAX + 1];
+} b_shell_cmd_ty;
+
+static b_shell_cmd_ty b_shell_cmds[B_SHELL_CMDS_MAX];
+static unsigned int b_shell_cmds_len;
+/* Held from pipe to spawn, as shell blocks of the first pass run on
+ * threads, so that no other child inherits the write end of a pipe, which
+ * would hold off its EOF. */
+static pthread_mutex_t b_shell_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Return 1 if cmd is words of characters that the shell takes as is, e.g.,
+ * "sensors -u" but not "ls | wc -l", "$HOME/bin/x" or "a=1 b". */
+static int
+b_shell_is_simple(const char *cmd)
+{
+	for (const char *p = cmd; *p; ++p)
+		if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9')
+		      || *p == ' ' || *p == '\t' || *p == '_' || *p == '-' || *p == '.' || *p == '/'
+		      || *p == ',' || *p == ':' || *p == '+' || *p == '@' || *p == '%'))
+			return 0;
+	return 1;
+}
+
+/* Return 1 if word is a keyword or builtin that only the shell can run,
+ * e.g., "exec foo", "command -v pamixer" or "umask". */
+static int
+b_shell_is_builtin(const char *word)
+{
+	static const char *const builtins[] = {
+		/* Keywords. */
+		"case", "do", "done", "elif", "else", "esac", "fi", "for", "if", "in", "then", "until", "while",
+		/* Special builtins. */
+		".", ":", "break", "continue", "eval", "exec", "exit", "export", "readonly", "return", "set", "shift", "times", "trap", "unset",
+		/* Builtins that act on or look up through the shell. */
+		"alias", "bg", "cd", "command", "fc", "fg", "getopts", "hash", "jobs", "read", "type", "ulimit", "umask", "unalias", "wait",
+	};
+	for (unsigned int i = 0; i < sizeof(builtins) / sizeof(builtins[0]); ++i)
+		if (!strcmp(word, builtins[i]))
+			return 1;
+	return 0;
+}
+
+/* Split cmd into c->argv if it does not need the shell. */
+static void
+b_shell_cmd_init(b_shell_cmd_ty *c, const char *cmd)
+{
+	c->cmd = cmd;
+	c->argv[0] = NULL;
+	if (!b_shell_is_simple(cmd))
+		return;
+	char *words = strdup(cmd);
+	if (unlikely(words == NULL))
+		return;
+	unsigned int argc = 0;
+	for (char *p = words; *p;) {
+		while (*p == ' ' || *p == '\t')
+			*p++ = '\0';
+		if (*p == '\0')
+			break;
+		if (unlikely(argc == B_SHELL_ARGV_MAX)) {
+			free(words);
+			c->argv[0] = NULL;
+			return;
+		}
+		c->argv[argc++] = p;
+		while (*p && *p != ' ' && *p != '\t')
+			++p;
+	}
+	c->argv[argc] = NULL;
+	if (argc == 0 || b_shell_is_builtin(c->argv[0])) {
+		free(words);
+		c->argv[0] = NULL;
+	}
+}
+
+void
+b_shell_init(const char *cmd)
+{
+	for (unsigned int i = 0; i < b_shell_cmds_len; ++i)
+		if (b_shell_cmds[i].cmd == cmd)
+			return;
+	if (unlikely(b_shell_cmds_len == B_SHELL_CMDS_MAX))
+		return;
+	b_shell_cmd_init(&b_shell_cmds[b_shell_cmds_len++], cmd);
+}
+
+/* Return the words of cmd, split by b_shell_init, or NULL if it needs the
+ * shell or was not split. */
+static char *const *
+b_shell_argv(const char *cmd)
+{
+	for (unsigned int i = 0; i < b_shell_cmds_len; ++i)
+		if (b_shell_cmds[i].cmd == cmd)
+			return b_shell_cmds[i].argv[0] ? b_shell_cmds[i].argv : NULL;
+	return NULL;
+}
+
+/* Start cmd with its stdout on a pipe, straight into its binary unless it
+ * needs the shell. Return the read end of the pipe, or -1. */
+static int
+b_shell_spawn(const char *cmd, pid_t *pid)
+{
+	posix_spawn_file_actions_t fa;
+	posix_spawnattr_t attr;
+	sigset_t none;
+	int fds[2] = { -1, -1 };
+	int ret = -1;
+	if (unlikely(posix_spawn_file_actions_init(&fa) != 0))
+		return -1;
+	if (unlikely(posix_spawnattr_init(&attr) != 0)) {
+		posix_spawn_file_actions_destroy(&fa);
+		return -1;
+	}
+	/* Not the signals blocked by the main loop or the first pass. */
+	sigemptyset(&none);
+	posix_spawnattr_setsigmask(&attr, &none);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+	pthread_mutex_lock(&b_shell_lock);
+	char *const *argv = b_shell_argv(cmd);
+	if (unlikely(pipe(fds) == -1))
+		goto out;
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	/* dup2 clears FD_CLOEXEC of stdout. */
+	if (unlikely(posix_spawn_file_actions_adddup2(&fa, fds[1], STDOUT_FILENO) != 0))
+		goto out;
+	if (argv) {
+		ret = posix_spawnp(pid, argv[0], &fa, &attr, argv, environ);
+	} else {
+		char *const sh_argv[] = { (char *)"sh", (char *)"-c", (char *)cmd, NULL };
+		ret = posix_spawn(pid, "/bin/sh", &fa, &attr, sh_argv, environ);
+	}
+	if (unlikely(ret != 0)) {
+		fprintf(stderr, "dwmblocks-fast: cannot run \"%s\": %s\n", cmd, strerror(ret));
+		ret = -1;
+	}
+out:
+	pthread_mutex_unlock(&b_shell_lock);
+	if (fds[1] != -1)
+		close(fds[1]);
+	if (ret == -1 && fds[0] != -1) {
+		close(fds[0]);
+		fds[0] = -1;
+	}
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&fa);
+	return ret == -1 ? -1 : fds[0];
+}
+
+/* Return the milliseconds left of SHELL_TIMEOUT_MS since start. */
+static int
+b_shell_left(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return SHELL_TIMEOUT_MS - (int)((now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+/* Read the first line of output from fd into dst within SHELL_TIMEOUT_MS of
+ * start. Return its length, or -1 on timeout or error. */
+static ssize_t
+b_shell_read(int fd, char *dst, size_t size, const struct timespec *start)
+{
+	size_t len = 0;
+	int timeout = b_shell_left(start);
+	while (len < size) {
+		struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+		const int ret = poll(&pfd, 1, timeout);
+		if (unlikely(ret == 0))
+			return -1;
+		if (unlikely(ret == -1 && errno != EINTR))
+			return -1;
+		if (ret == 1) {
+			const ssize_t n = read(fd, dst + len, size - len);
+			if (n == 0)
+				break;
+			if (unlikely(n == -1)) {
+				if (errno == EINTR)
+					continue;
+				return -1;
+			}
+			len += (size_t)n;
+			if (memchr(dst + len - (size_t)n, '\n', (size_t)n))
+				break;
+		}
+		timeout = b_shell_left(start);
+		if (unlikely(timeout <= 0))
+			return -1;
+	}
+	return (ssize_t)len;
+}
+
+/* Reap pid, killed if it is still running SHELL_TIMEOUT_MS after start,
+ * e.g., "echo hi; sleep 5" once it printed its line. Return 1 if it was
+ * killed, 0 if it exited, or -1 on error. */
+static int
+b_shell_reap(pid_t pid, const struct timespec *start)
+{
+#		ifdef HAVE_PIDFD_OPEN
+	/* Readable once it exits. Not reaped yet, so the pid is still its. */
+	const int pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+	if (likely(pidfd != -1)) {
+		struct pollfd pfd = { .fd = pidfd, .events = POLLIN, .revents = 0 };
+		int left;
+		while ((left = b_shell_left(start)) > 0 && poll(&pfd, 1, left) == -1 && errno == EINTR)
+			;
+		close(pidfd);
+	}
+#		endif
+	/* Most commands exit right after their line. */
+	for (long ns = 50000;; ns = MIN(ns * 2, 16000000)) {
+		const pid_t ret = waitpid(pid, NULL, WNOHANG);
+		if (ret == pid)
+			return 0;
+		if (unlikely(ret == -1)) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		const int left = b_shell_left(start);
+		if (left <= 0)
+			break;
+		const struct timespec ts = { 0, MIN(ns, (long)left * 1000000) };
+		nanosleep(&ts, NULL);
+	}
+	kill(pid, SIGKILL);
+	while (waitpid(pid, NULL, 0) == -1)
+		if (unlikely(errno != EINTR))
+			return -1;
+	return 1;
+}
+
+/* Execute shell script. */
+char *
+b_write_shell(char *dst, unsigned int dst_size, const char *cmd, unsigned short *interval)
+{
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pid_t pid;
+	const int fd = b_shell_spawn(cmd, &pid);
+	/* Like a shell that does not find the command. */
+	if (unlikely(fd == -1)) {
+		*dst = '\0';
+		return dst;
+	}
+	ssize_t read_sz = b_shell_read(fd, dst, dst_size - 1, &start);
+	/* More output makes it exit on SIGPIPE. */
+	close(fd);
+	const int killed = b_shell_reap(pid, &start);
+	if (unlikely(killed == -1))
+		DIE(return NULL);
+	if (unlikely(read_sz == -1)) {
+		fprintf(stderr, "dwmblocks-fast: \"%s\" took over %d ms\n", cmd, SHELL_TIMEOUT_MS);
+		read_sz = 0;
+	} else if (unlikely(killed)) {
+		fprintf(stderr, "dwmblocks-fast: \"%s\" did not exit within %d ms\n", cmd, SHELL_TIMEOUT_MS);
+	}
+	/* Chop newline. */
+	char *end = (char *)memchr(dst, '\n', (size_t)read_sz);
+	/* Nul-terminate newline or end of string. */
+	dst = end ? end : dst + read_sz;
+	*dst = '\0';
+	(void)interval;
+	return dst;
+}
+
+/* Persistent scripts that are running or waiting to be restarted. */
+#		define B_SHELL_PERSIST_MAX 8
+/* Longest line kept of a persistent script. */
+#		define B_SHELL_PERSIST_LINE 64
+
+typedef struct {
+	const char *cmd;
+	/* Starts the script, and backs off when it keeps dying. */
+	b_defer_ty defer;
+	pid_t pid;
+	int fd;
+	unsigned int start_time;
+	unsigned short backoff;
+	/* The last complete line. */
+	char line[B_SHELL_PERSIST_LINE];
+	unsigned int line_len;
+	/* The line being read, cut at B_SHELL_PERSIST_LINE - 1. */
+	char next[B_SHELL_PERSIST_LINE];
+	unsigned int next_len;
+} b_shell_persist_ty;
+
+static b_shell_persist_ty b_shell_persists[B_SHELL_PERSIST_MAX];
+static unsigned int b_shell_persists_len;
+
+/* The script exited or closed its stdout. Reap it, and restart it through
+ * the deferred init, later each time it dies soon after being started. */
+static void
+b_shell_persist_died(b_shell_persist_ty *p)
+{
+	close(p->fd);
+	p->fd = -1;
+	p->next_len = 0;
+	/* A script that only closed its stdout. */
+	kill(p->pid, SIGKILL);
+	while (waitpid(p->pid, NULL, 0) == -1 && errno == EINTR)
+		;
+	if (g_time - p->start_time < B_DEFER_BACKOFF_MAX)
+		p->backoff = p->backoff ? MIN(p->backoff * 2, B_DEFER_BACKOFF_MAX) : 1;
+	else
+		p->backoff = 1;
+	fprintf(stderr, "dwmblocks-fast: \"%s\" exited, restarting in %u s\n", p->cmd, p->backoff);
+	p->defer.state = B_DEFER_IDLE;
+	p->defer.backoff = p->backoff;
+	p->defer.retry_time = g_time + p->backoff;
+	g_refresh(b_write_shell_persist, p->cmd);
+}
+
+/* Called from the main loop when the script printed something. */
+static int
+b_shell_persist_read(int fd, void *data)
+{
+	b_shell_persist_ty *p = (b_shell_persist_ty *)data;
+	char buf[512];
+	int changed = 0;
+	for (;;) {
+		const ssize_t n = read(fd, buf, sizeof(buf));
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1 && errno == EAGAIN)
+			break;
+		if (n <= 0) {
+			b_shell_persist_died(p);
+			break;
+		}
+		for (const char *s = buf, *end = buf + n; s < end;) {
+			const char *nl = (const char *)memchr(s, '\n', (size_t)(end - s));
+			const char *e = nl ? nl : end;
+			const unsigned int len = MIN((unsigned int)(e - s), (unsigned int)sizeof(p->next) - 1 - p->next_len);
+			memcpy(p->next + p->next_len, s, len);
+			p->next_len += len;
+			if (nl == NULL)
+				break;
+			/* Only the last line of a burst is shown. */
+			if (p->next_len != p->line_len || memcmp(p->next, p->line, p->next_len)) {
+				memcpy(p->line, p->next, p->next_len);
+				p->line_len = p->next_len;
+				changed = 1;
+			}
+			p->next_len = 0;
+			s = nl + 1;
+		}
+	}
+	if (changed)
+		g_refresh(b_write_shell_persist, p->cmd);
+	/* Deleted by b_shell_persist_died. */
+	return p->fd == -1 ? -1 : 0;
+}
+
+static int
+b_shell_persist_start(void *data)
+{
+	b_shell_persist_ty *p = (b_shell_persist_ty *)data;
+	p->fd = b_shell_spawn(p->cmd, &p->pid);
+	if (unlikely(p->fd == -1))
+		return -1;
+	fcntl(p->fd, F_SETFL, O_NONBLOCK);
+	if (unlikely(g_watch_add(p->fd, b_shell_persist_read, p) == -1)) {
+		close(p->fd);
+		p->fd = -1;
+		kill(p->pid, SIGKILL);
+		while (waitpid(p->pid, NULL, 0) == -1 && errno == EINTR)
+			;
+		return -1;
+	}
+	p->start_time = g_time;
+	return 0;
+}
+
+/* Run a script once and show each line it prints. */
+char *
+b_write_shell_persist(char *dst, unsigned int dst_size, const char *cmd, unsigned short *interval)
+{
+	b_shell_persist_ty *p = NULL;
+	for (unsigned int i = 0; i < b_shell_persists_len; ++i)
+		if (b_shell_persists[i].cmd == cmd) {
+			p = &b_shell_persists[i];
+			break;
+		}
+	if (p == NULL) {
+		if (unlikely(b_shell_persists_len == B_SHELL_PERSIST_MAX)) {
+			fprintf(stderr, "dwmblocks-fast: over %d persistent scripts, not running \"%s\"\n", B_SHELL_PERSIST_MAX, cmd);
+			*interval = (unsigned short)-1;
+			*dst = '\0';
+			return dst;
+		}
+		p = &b_shell_persists[b_shell_persists_len++];
+		p->cmd = cmd;
+		p->fd = -1;
+		p->defer = (b_defer_ty)B_DEFER_INIT(b_shell_persist_start, p, 0);
+	}
+	/* Run again on the next line, or when due to be restarted. */
+	if (b_defer_ready(&p->defer, b_write_shell_persist, cmd, interval))
+		*interval = (unsigned short)-1;
+	/* Keep the last line while the script is restarted. */
+	const unsigned int len = MIN(p->line_len, dst_size - 1);
+	memcpy(dst, p->line, len);
+	return dst + len;
+}
+
+#	else
+
 /* Execute shell script. */
 char *
 b_write_shell(char *dst, unsigned int dst_size, const char *cmd, unsigned short *interval)
@@ -50,4 +490,23 @@ b_write_shell(char *dst, unsigned int dst_size, const char *cmd, unsigned short
 	return dst;
 }
 
+#	endif /* HAVE_POSIX_SPAWN */
+
+char *
+b_write_shell_fields(char *dst, unsigned int dst_size, const char *cmd, unsigned short *interval)
+{
+	/* Given a buffer for all of the fields. */
+	return b_write_shell(dst, dst_size, cmd, interval);
+}
+
+char *
+b_write_shell_field(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
+{
+	*dst = '\0';
+	return dst;
+	(void)dst_size;
+	(void)unused;
+	(void)interval;
+}
+
 #endif
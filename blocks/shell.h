@@ -28,6 +28,27 @@
 char *
 b_write_shell(char *dst, unsigned int dst_size, const char *cmd, unsigned short *interval);
 
+/* Run cmd for a group of blocks: its first line is split on SHELL_FIELD_SEP
+ * into this block and the b_write_shell_field blocks right after it, which
+ * must have the same interval and signal. Done by the main loop. */
+char *
+b_write_shell_fields(char *dst, unsigned int dst_size, const char *cmd, unsigned short *interval);
+/* A field of the b_write_shell_fields before it. Renders nothing alone. */
+char *
+b_write_shell_field(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval);
+
+#	ifdef HAVE_POSIX_SPAWN
+/* Split cmd once, at startup, so that it is run without the shell if it
+ * does not need it. Other commands go through the shell. */
+void
+b_shell_init(const char *cmd);
+
+/* Start cmd once and show the last line it printed, updated as soon as it
+ * prints another. It is restarted, with backoff, when it exits. */
+char *
+b_write_shell_persist(char *dst, unsigned int dst_size, const char *cmd, unsigned short *interval);
+#	endif
+
 #endif
 
 #endif /* B_SHELL_H */
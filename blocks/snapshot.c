@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#include "../config.h"
+
+#ifdef HAVE_PROCFS
+
+#	include <fcntl.h>
+#	include <limits.h>
+#	include <string.h>
+#	include <time.h>
+#	include <unistd.h>
+
+#	include "../macros.h"
+#	include "../utils.h"
+#	include "cpu.h"
+#	include "powercap.h"
+#	include "procfs.h"
+#	include "snapshot.h"
+
+#	ifndef PATH_MAX
+#		define PATH_MAX 4096
+#	endif
+
+static char b_snapshot_path[PATH_MAX];
+static char b_snapshot_tmp[PATH_MAX];
+static char b_boot_id[64];
+static unsigned int b_boot_id_len;
+
+int
+b_snapshot_init(const char *dir)
+{
+	b_snapshot_path[0] = '\0';
+	if (dir == NULL || *dir == '\0')
+		return -1;
+	if (strlen(dir) + S_LEN(B_SNAPSHOT_NAME ".tmp") >= sizeof(b_snapshot_path))
+		return -1;
+	const unsigned int len = b_proc_read_file(b_boot_id, sizeof(b_boot_id), "/proc/sys/kernel/random/boot_id");
+	if (len == (unsigned int)-1 || len == 0 || b_boot_id[len - 1] != '\n')
+		return -1;
+	b_boot_id_len = len;
+	u_stpcpy_len(u_stpcpy(b_snapshot_path, dir), S_LITERAL(B_SNAPSHOT_NAME));
+	u_stpcpy_len(u_stpcpy(b_snapshot_tmp, dir), S_LITERAL(B_SNAPSHOT_NAME ".tmp"));
+	return 0;
+}
+
+int
+b_snapshot_read(void)
+{
+	if (b_snapshot_path[0] == '\0')
+		return -1;
+	char buf[4096];
+	const unsigned int len = b_proc_read_file(buf, sizeof(buf), b_snapshot_path);
+	/* Used once. */
+	unlink(b_snapshot_path);
+	if (len == (unsigned int)-1 || len < b_boot_id_len || memcmp(buf, b_boot_id, b_boot_id_len))
+		return -1;
+	const char *p = buf + b_boot_id_len;
+	if (strncmp(p, "time ", S_LEN("time ")))
+		return -1;
+	p += S_LEN("time ");
+	const unsigned long long then = u_strtoull10(p, &p);
+	struct timespec now;
+	if (clock_gettime(CLOCK_MONOTONIC, &now) != 0 || (unsigned long long)now.tv_sec < then || (unsigned long long)now.tv_sec - then > B_SNAPSHOT_AGE_MAX)
+		return -1;
+	int n = 0;
+	while ((p = strchr(p, '\n'))) {
+		++p;
+		if (!strncmp(p, "cpu ", S_LEN("cpu "))) {
+			if (b_cpu_usage_load(p + S_LEN("cpu ")) != -1)
+				++n;
+		}
+#	ifdef HAVE_POWERCAP
+		else if (!strncmp(p, "rapl ", S_LEN("rapl "))) {
+			b_powercap_load(p + S_LEN("rapl "));
+			++n;
+		}
+#	endif
+	}
+	return n;
+}
+
+/* Called from the SIGTERM handler: only async-signal-safe calls. */
+void
+b_snapshot_write(void)
+{
+	if (b_snapshot_path[0] == '\0')
+		return;
+	static char buf[4096];
+	char *p = u_stpcpy_len(buf, b_boot_id, b_boot_id_len);
+	struct timespec now;
+	if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+		return;
+	p = u_stpcpy_len(p, S_LITERAL("time "));
+	p = u_ulltoa_p((unsigned long long)now.tv_sec, p);
+	*p++ = '\n';
+	p = b_cpu_usage_save(p);
+#	ifdef HAVE_POWERCAP
+	p = b_powercap_save(p);
+#	endif
+	const int fd = open(b_snapshot_tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd == -1)
+		return;
+	const ssize_t len = p - buf;
+	const int ok = (write(fd, buf, (size_t)len) == len);
+	if (close(fd) != 0 || !ok || rename(b_snapshot_tmp, b_snapshot_path) == -1)
+		unlink(b_snapshot_tmp);
+}
+
+#endif /* HAVE_PROCFS */
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ * This file is part of dwmblocks-fast.
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided that
+ * the above copyright notice and this permission notice appear in all
+ * copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
+
+#ifndef B_SNAPSHOT_H
+#	define B_SNAPSHOT_H 1
+
+#	include "../macros.h"
+
+#	ifdef HAVE_PROCFS
+
+/* ../blocks/snapshot.c */
+
+/* The last samples of delta-based blocks, saved on exit so that a restart
+ * needs no priming:
+ *   [boot_id]
+ *   time [CLOCK_MONOTONIC seconds]
+ *   cpu ...
+ *   rapl ... */
+#		define B_SNAPSHOT_NAME "/dwmblocks-fast-snapshot"
+/* In seconds. Older samples are averaged over too long to show. */
+#		define B_SNAPSHOT_AGE_MAX 60
+
+/* Keep the snapshot in dir. Return 0, or -1 if it cannot be used, in which
+ * case b_snapshot_read and b_snapshot_write do nothing. */
+int
+b_snapshot_init(const char *dir);
+/* Restore the samples of the snapshot and remove it. Return the number of
+ * samples that were restored or ignored because one had been taken, or -1
+ * if the snapshot is missing, from another boot, or too old. */
+int
+b_snapshot_read(void);
+/* Save the last samples. Async-signal-safe. */
+void
+b_snapshot_write(void);
+
+#	endif /* HAVE_PROCFS */
+
+#endif /* B_SNAPSHOT_H */
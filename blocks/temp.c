@@ -16,55 +16,88 @@
  * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE. */
 
+#include <stdio.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <unistd.h>
 
 #include "../macros.h"
 #include "../utils.h"
 #include "../config.h"
+#include "fdpool.h"
+#include "hwmon.h"
+#include "temp.h"
+
+/* Parse a sysfs temperature in millidegrees, e.g., "-1500\n".
+ * Return -1 on error. */
+int
+b_temp_parse(const char *buf, unsigned int len, long *millidegrees)
+{
+	const char *p = buf;
+	const char *end = buf + len;
+	const int neg = (p < end && *p == '-');
+	p += neg;
+	if (unlikely(p == end || !u_isdigit(*p)))
+		return -1;
+	long n = 0;
+	for (; p < end && u_isdigit(*p); ++p)
+		n = n * 10 + (*p - '0');
+	*millidegrees = neg ? -n : n;
+	return 0;
+}
+
+/* Write whole degrees, truncated toward zero. */
+char *
+b_temp_write(char *dst, long millidegrees)
+{
+	const long degrees = millidegrees / 1000;
+	if (degrees < 0)
+		*dst++ = '-';
+	return u_utoa_p((unsigned int)(degrees < 0 ? -degrees : degrees), dst);
+}
 
 char *
 b_write_tempfd_internal(char *dst, unsigned int dst_size, int fd)
 {
-	/* Milidegrees = degrees * 1000 */
-	int read_sz = pread(fd, dst, S_LEN("100") + S_LEN("000") + S_LEN("\n"), 0);
-	if (unlikely(read_sz <= 3))
+	char buf[B_TEMP_BUF];
+	const ssize_t read_sz = pread(fd, buf, sizeof(buf), 0);
+	long millidegrees;
+	if (unlikely(read_sz <= 0 || b_temp_parse(buf, (unsigned int)read_sz, &millidegrees) == -1))
 		DIE(return NULL);
-	/* Don't read the newline. */
-	if (*(dst + read_sz - 1) == '\n')
-		--read_sz;
-	/* Don't read the milidegrees. */
-	read_sz -= S_LEN("000");
-	*(dst + read_sz) = '\0';
-	return dst + read_sz;
+	return b_temp_write(dst, millidegrees);
 	(void)dst_size;
 }
 
 char *
 b_write_temp_internal(char *dst, unsigned int dst_size, const char *temp_file)
 {
-	const int fd = open(temp_file, O_RDONLY);
-	if (unlikely(fd == -1))
-		DIE(return NULL);
-	/* Milidegrees = degrees * 1000 */
-	int read_sz = read(fd, dst, S_LEN("100") + S_LEN("000") + S_LEN("\n"));
-	if (unlikely(close(fd) == -1))
+	char buf[B_TEMP_BUF];
+	const ssize_t read_sz = b_fdpool_pread(temp_file, buf, sizeof(buf));
+	long millidegrees;
+	if (unlikely(read_sz <= 0 || b_temp_parse(buf, (unsigned int)read_sz, &millidegrees) == -1))
 		DIE(return NULL);
-	if (unlikely(read_sz <= 3))
-		DIE(return NULL);
-	/* Don't read the newline. */
-	if (*(dst + read_sz - 1) == '\n')
-		--read_sz;
-	/* Don't read the milidegrees. */
-	read_sz -= S_LEN("000");
-	*(dst + read_sz) = '\0';
-	return dst + read_sz;
+	return b_temp_write(dst, millidegrees);
 	(void)dst_size;
 }
 
 char *
 b_write_temp(char *dst, unsigned int dst_size, const char *temp_file, unsigned short *interval)
 {
+#ifdef HAVE_SYSFS
+	/* A hwmon sensor, e.g., k10temp:Tctl, or NULL for the CPU. */
+	if (temp_file == NULL || *temp_file != '/') {
+		const char *spec = temp_file;
+		temp_file = b_hwmon_path(spec);
+		if (unlikely(temp_file == NULL)) {
+			fputs("dwmblocks-fast: temperature sensor not found: ", stderr);
+			fputs(spec ? spec : "(cpu)", stderr);
+			fputc('\n', stderr);
+			/* Don't retry. */
+			*interval = (unsigned short)-1;
+			return dst;
+		}
+	}
+#endif
 	char *p = dst;
 	p = b_write_temp_internal(p, dst_size, temp_file);
 	if (unlikely(p == dst))
@@ -85,3 +118,77 @@ b_write_tempfd(char *dst, unsigned int dst_size, int fd, unsigned short *interva
 	(void)dst_size;
 	(void)interval;
 }
+
+#ifdef HAVE_SYSFS
+
+/* Sensors of a chip, resolved once for each arg. */
+static struct {
+	const char *chip;
+	const char *paths[B_TEMP_SENSORS_MAX];
+	unsigned int len;
+} b_temp_sets[8];
+static unsigned int b_temp_sets_len;
+
+/* Read all temperatures of chip. Return the number read, or -1 on error. */
+static int
+b_temp_read_all(const char *chip, long *sum, long *max)
+{
+	unsigned int i;
+	for (i = 0; i < b_temp_sets_len; ++i)
+		if (b_temp_sets[i].chip == chip)
+			break;
+	if (unlikely(i == b_temp_sets_len)) {
+		if (unlikely(i == sizeof(b_temp_sets) / sizeof(b_temp_sets[0])))
+			return -1;
+		b_temp_sets[i].chip = chip;
+		b_temp_sets[i].len = b_hwmon_temps(chip, b_temp_sets[i].paths, B_TEMP_SENSORS_MAX);
+		++b_temp_sets_len;
+	}
+	*sum = 0;
+	*max = LONG_MIN;
+	/* The fds stay open, so this is one pread per sensor, or none if
+	 * the fd pool prefetched them. */
+	for (unsigned int j = 0; j < b_temp_sets[i].len; ++j) {
+		char buf[B_TEMP_BUF];
+		const ssize_t read_sz = b_fdpool_pread(b_temp_sets[i].paths[j], buf, sizeof(buf));
+		long t;
+		if (unlikely(read_sz <= 0 || b_temp_parse(buf, (unsigned int)read_sz, &t) == -1))
+			return -1;
+		*sum += t;
+		*max = MAX(*max, t);
+	}
+	return (int)b_temp_sets[i].len;
+}
+
+static char *
+b_write_temp_agg(char *dst, const char *chip, unsigned short *interval, int avg)
+{
+	long sum, max;
+	const int n = b_temp_read_all(chip, &sum, &max);
+	if (unlikely(n == -1))
+		DIE(return NULL);
+	if (unlikely(n == 0)) {
+		fputs("dwmblocks-fast: no temperature sensors for: ", stderr);
+		fputs(chip ? chip : "(cpu)", stderr);
+		fputc('\n', stderr);
+		*interval = (unsigned short)-1;
+		return dst;
+	}
+	return b_temp_write(dst, avg ? sum / n : max);
+}
+
+char *
+b_write_temp_max(char *dst, unsigned int dst_size, const char *chip, unsigned short *interval)
+{
+	return b_write_temp_agg(dst, chip, interval, 0);
+	(void)dst_size;
+}
+
+char *
+b_write_temp_avg(char *dst, unsigned int dst_size, const char *chip, unsigned short *interval)
+{
+	return b_write_temp_agg(dst, chip, interval, 1);
+	(void)dst_size;
+}
+
+#endif /* HAVE_SYSFS */
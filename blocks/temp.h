@@ -25,6 +25,15 @@
 
 /* ../blocks/temp.c */
 
+/* Enough for any millidegree value. */
+#		define B_TEMP_BUF 24
+/* Maximum number of sensors read by b_write_temp_max and b_write_temp_avg. */
+#		define B_TEMP_SENSORS_MAX 128
+
+int
+b_temp_parse(const char *buf, unsigned int len, long *millidegrees);
+char *
+b_temp_write(char *dst, long millidegrees);
 int
 b_read_temp(const char *temp_file);
 char *
@@ -33,6 +42,15 @@ char *
 b_write_temp(char *dst, unsigned int dst_size, const char *temp_file, unsigned short *interval);
 char *
 b_write_tempfd(char *dst, unsigned int dst_size, int fd, unsigned short *interval);
+#		ifdef HAVE_SYSFS
+/* Hottest and average temperature of all sensors of all instances of a
+ * hwmon chip, e.g., "coretemp" on a dual-socket machine. A NULL chip
+ * means the CPU. */
+char *
+b_write_temp_max(char *dst, unsigned int dst_size, const char *chip, unsigned short *interval);
+char *
+b_write_temp_avg(char *dst, unsigned int dst_size, const char *chip, unsigned short *interval);
+#		endif
 
 #	endif /* HAVE_PROCFS */
 
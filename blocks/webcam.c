@@ -19,28 +19,188 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <errno.h>
 
 #include "../macros.h"
 #include "../utils.h"
 #include "../config.h"
+#include "../dwmblocks-fast.h"
 #include "procfs.h"
+#include "webcam.h"
+
+#ifdef HAVE_INOTIFY
+#	include <dirent.h>
+#	include <sys/inotify.h>
+#endif
 
 /* ../blocks/webcam.h */
 
 #ifdef HAVE_PROCFS
 
+#	define B_WEBCAM_DEV "/dev/video"
+
+typedef enum {
+	B_WEBCAM_UNINIT = 0,
+	/* Scan /proc/[pid]/fd on each call. */
+	B_WEBCAM_SCAN,
+	/* Count opens and closes with inotify. */
+	B_WEBCAM_NOTIFY
+} b_webcam_state_ty;
+
+static b_webcam_state_ty b_webcam_state;
+/* Number of open files of /dev/video*. */
+static unsigned int b_webcam_open;
+
+static int
+b_webcam_scan(void)
+{
+	const unsigned int count = b_proc_fd_count(S_LITERAL(B_WEBCAM_DEV));
+	if (unlikely(count == (unsigned int)-1))
+		return -1;
+	b_webcam_open = count;
+	return 0;
+}
+
+#	ifdef HAVE_INOTIFY
+
+static int b_webcam_fd = -1;
+/* Watch on /dev for devices being plugged in or removed. */
+static int b_webcam_dev_wd = -1;
+
+static int
+b_webcam_watch(const char *name)
+{
+	char fname[S_LEN("/dev/") + 256];
+	u_stpcpy(u_stpcpy_len(fname, S_LITERAL("/dev/")), name);
+	if (inotify_add_watch(b_webcam_fd, fname, IN_OPEN | IN_CLOSE) == -1)
+		/* Removed before we got to it. */
+		if (unlikely(errno != ENOENT))
+			return -1;
+	return 0;
+}
+
+static int
+b_webcam_watch_all(void)
+{
+	DIR *dp = opendir("/dev");
+	if (unlikely(dp == NULL))
+		return -1;
+	struct dirent *ep;
+	while ((ep = readdir(dp)))
+		if (!strncmp(ep->d_name, "video", S_LEN("video")))
+			if (unlikely(b_webcam_watch(ep->d_name) == -1)) {
+				closedir(dp);
+				return -1;
+			}
+	if (unlikely(closedir(dp) == -1))
+		return -1;
+	return 0;
+}
+
+static void
+b_webcam_notify_stop(void)
+{
+	close(b_webcam_fd);
+	b_webcam_fd = -1;
+	b_webcam_state = B_WEBCAM_SCAN;
+}
+
+static int
+b_webcam_read(int fd, void *unused)
+{
+	union {
+		struct inotify_event ev;
+		char buf[4096];
+	} u;
+	const unsigned int was_open = b_webcam_open;
+	int rescan = 0;
+	for (;;) {
+		const ssize_t read_sz = read(fd, u.buf, sizeof(u.buf));
+		if (read_sz == -1) {
+			if (likely(errno == EAGAIN))
+				break;
+			if (errno == EINTR)
+				continue;
+			goto fallback;
+		}
+		for (ssize_t off = 0; off < read_sz;) {
+			const struct inotify_event *ev = (const struct inotify_event *)(u.buf + off);
+			off += (ssize_t)sizeof(*ev) + ev->len;
+			if (ev->mask & IN_Q_OVERFLOW) {
+				/* Lost events, so the count is unreliable. */
+				rescan = 1;
+			} else if (ev->wd == b_webcam_dev_wd) {
+				if (!ev->len || strncmp(ev->name, "video", S_LEN("video")))
+					continue;
+				if (ev->mask & IN_CREATE)
+					if (unlikely(b_webcam_watch(ev->name) == -1))
+						goto fallback;
+				/* A removed device takes its opens with it. */
+				rescan = 1;
+			} else if (ev->mask & IN_OPEN) {
+				++b_webcam_open;
+			} else if (ev->mask & IN_CLOSE) {
+				/* Recount rather than decrement: an open
+				 * between the watch and the first scan is
+				 * counted by both. The fd is already out of
+				 * /proc when the close is reported. */
+				rescan = 1;
+			}
+		}
+	}
+	if (rescan)
+		if (unlikely(b_webcam_scan() == -1))
+			goto fallback;
+	if (!was_open != !b_webcam_open)
+		g_refresh(b_write_webcam_on, NULL);
+	return 0;
+fallback:
+	/* Scan on each run instead. */
+	b_webcam_notify_stop();
+	g_refresh(b_write_webcam_on, NULL);
+	return -1;
+	(void)unused;
+}
+
+static int
+b_webcam_notify_init(void)
+{
+	b_webcam_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (b_webcam_fd == -1)
+		return -1;
+	/* Watch /dev before the devices so that none are missed. */
+	b_webcam_dev_wd = inotify_add_watch(b_webcam_fd, "/dev", IN_CREATE | IN_DELETE);
+	if (b_webcam_dev_wd == -1 || b_webcam_watch_all() == -1 || g_watch_add(b_webcam_fd, b_webcam_read, NULL) == -1) {
+		b_webcam_notify_stop();
+		return -1;
+	}
+	b_webcam_state = B_WEBCAM_NOTIFY;
+	return 0;
+}
+
+#	endif /* HAVE_INOTIFY */
+
 char *
 b_write_webcam_on(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
 {
-	char buf[B_PAGE_SIZE + 1];
-	const unsigned int read_sz = b_proc_read_file(buf, sizeof(buf), "/proc/modules");
-	if (unlikely(read_sz == (unsigned int)-1))
-		DIE(return NULL);
-	if (u_strstr_len(buf, (size_t)read_sz, S_LITERAL("uvcvideo")))
-		dst = u_stpcpy_len(dst, S_LITERAL(ICON_WEBCAM_ON));
+	if (unlikely(b_webcam_state == B_WEBCAM_UNINIT)) {
+		b_webcam_state = B_WEBCAM_SCAN;
+#	ifdef HAVE_INOTIFY
+		b_webcam_notify_init();
+#	endif
+		/* Count the files opened before we started watching. */
+		if (unlikely(b_webcam_scan() == -1))
+			DIE(return NULL);
+	} else if (b_webcam_state == B_WEBCAM_SCAN) {
+		if (unlikely(b_webcam_scan() == -1))
+			DIE(return NULL);
+	}
+	/* Opens and closes trigger a refresh. No need to poll. */
+	*interval = (b_webcam_state == B_WEBCAM_NOTIFY) ? (unsigned short)-1 : INTERVAL_WEBCAM;
+	dst = u_stpcpy(dst, b_webcam_open ? ICON_WEBCAM_ON : ICON_WEBCAM_OFF);
 	return dst;
 	(void)dst_size;
-	(void)interval;
 	(void)unused;
 }
 
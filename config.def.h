@@ -19,20 +19,64 @@
 #	define CONFIG_H 1
 
 #	include "macros.h"
-#	include "cpu-temp-file.generated.h"
 
 /* Use libx11. Comment to disable. */
 #	define USE_X11 1
 
 /* Monitor audio volume, requires ALSA. Comment to disable. */
 #	define USE_ALSA 1
+/* Monitor audio volume through the PulseAudio or PipeWire server instead of
+ * ALSA, updated by its events. Set to 1 to enable. */
+#	define USE_PULSE 0
 
 /* Monitor Nvidia GPU, requires CUDA. Comment to disable. */
 #	define USE_CUDA 1
+
+/* Monitor AMD and Intel GPUs through the DRM drivers in sysfs. Comment to
+ * disable. */
+#	define USE_GPU_DRM 1
+/* Compute the usage of GPUs without gpu_busy_percent, e.g., Intel, from the
+ * busy time of the clients in /proc/[pid]/fdinfo. Each sample reads the fds
+ * of every process. */
+#	define USE_GPU_DRM_FDINFO 0
+/* Between the GPUs of a GPU block with .arg = "all". */
+#	define GPU_ALL_SEP "/"
+
+/* Load libX11, libasound and libnvidia-ml with dlopen on first use instead
+ * of linking them, so that one binary also runs on machines without them,
+ * e.g., without the Nvidia driver. Comment to link them, in which case,
+ * uncomment their LDFLAGS in config.mk. */
+#	define USE_DLOPEN 1
 #	define USE_NVSPEED 0
 
 #	define USE_CFAN 0
 
+/* Read RAM usage with one sysinfo(2) call instead of parsing /proc/meminfo.
+ * Faster, but the page cache is counted as used memory. Set to 0 for
+ * MemAvailable-accurate output. */
+#	define USE_RAM_SYSINFO 0
+
+/* Read the /proc and /sys files of the blocks due in a tick with one
+ * io_uring_enter instead of one pread each. Needs Linux 5.6. */
+#	define USE_IO_URING 0
+
+/* Refresh delta-based blocks (CPU usage, power) this long in milliseconds
+ * after their first sample, so that real values replace the ones of the
+ * first frame without waiting for the next tick. 0 to disable. */
+#	define INTERVAL_PRIME_MS 200
+
+/* Kill a shell block that has not printed its first line after this long
+ * in milliseconds, so that a hung script does not stall the bar. */
+#	define SHELL_TIMEOUT_MS 2000
+/* Between the fields printed by the command of a b_write_shell_fields, which
+ * are shown by it and the b_write_shell_field blocks after it. */
+#	define SHELL_FIELD_SEP '|'
+
+/* Save the last samples of delta-based blocks in $XDG_RUNTIME_DIR on exit,
+ * so that the first frame after a restart shows real values. Comment to
+ * disable. */
+#	define USE_SNAPSHOT 1
+
 /* May not work for older versions of CUDA, in which case, comment it out. */
 #	define USE_NVML_DEVICEGETTEMPERATUREV 1
 #	define NVML_HEADER                    "/opt/cuda/include/nvml.h"
@@ -40,6 +84,11 @@
 #	define ICON_WEBCAM_ON         "📸"
 #	define ICON_WEBCAM_OFF        ""
 
+/* Used only when inotify is unavailable. */
+#	define INTERVAL_WEBCAM        2
+/* Used only when inotify is unavailable, e.g., for /proc and /sys. */
+#	define INTERVAL_CAT           2
+
 #	define ICON_OBS_RECORDING_ON  "🔴 Rec"
 #	define ICON_OBS_RECORDING_OFF ""
 
@@ -4,15 +4,21 @@ CFLAGS_OPTIMIZE += -march=native
 # Link-time optimizations (comment to disable)
 LDFLAGS_OPTIMIZE += -flto
 
-# X11 (comment to disable)
-LDFLAGS_X11 += -lX11
+# X11, Alsa and NVML are loaded with dlopen when USE_DLOPEN is defined in
+# config.h. Otherwise, uncomment those that are enabled to link them.
 
-# Alsa (comment to disable)
-LDFLAGS_ALSA += -lasound
+# X11
+# LDFLAGS_X11 += -lX11
 
-# NVML (comment to disable)
-LIB_NVML = /opt/cuda/lib64
-LDFLAGS_CUDA += -L$(LIB_NVML) -lnvidia-ml
+# Alsa
+# LDFLAGS_ALSA += -lasound
+
+# NVML
+# LIB_NVML = /opt/cuda/lib64
+# LDFLAGS_CUDA += -L$(LIB_NVML) -lnvidia-ml
+
+# dlopen, part of libc since glibc 2.34 and on the BSDs (comment to disable)
+LDFLAGS_DL += -ldl
 
 # # FreeBSD (uncomment)
 # LDFLAGS_FREEBSD += -L/usr/local/lib -I/usr/local/include
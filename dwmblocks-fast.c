@@ -29,6 +29,8 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <stdint.h>
+#include <time.h>
+#include <pthread.h>
 #include <sys/select.h>
 
 /* Maximum user signal number.
@@ -47,9 +49,30 @@
 #include "blocks.h"
 #include "macros.h"
 #include "utils.h"
-#include "path.h"
 
 #include "dwmblocks-fast.h"
+#include "blocks/fdpool.h"
+#include "blocks/procfs.h"
+#include "blocks/cpu.h"
+#include "blocks/powercap.h"
+#include "blocks/shell.h"
+#include "blocks/snapshot.h"
+#include "blocks/dl.h"
+
+#ifdef USE_X11
+#	ifdef USE_DLOPEN
+/* libX11, resolved by g_init_x11. */
+static struct {
+	Display *(*XOpenDisplay)(_Xconst char *);
+	int (*XChangeProperty)(Display *, Window, Atom, Atom, int, int, _Xconst unsigned char *, int);
+	int (*XFlush)(Display *);
+	int (*XCloseDisplay)(Display *);
+} g_x11;
+#		define G_X11(fn) (g_x11.fn)
+#	else
+#		define G_X11(fn) (fn)
+#	endif
+#endif
 unsigned int g_time;
 
 #if defined _POSIX_REALTIME_SIGNALS && (_POSIX_REALTIME_SIGNALS > 0)
@@ -72,6 +95,13 @@ unsigned int g_time;
 /* Do not change. */
 #define INTERVAL_UPDATE 1
 
+/* Maximum number of fds watched by the main loop. */
+#define G_WATCH_MAX 32
+
+/* Maximum number of blocks filled by one b_write_shell_fields, itself
+ * included. */
+#define G_FIELDS_MAX 8
+
 typedef enum {
 	G_WRITE_STATUSBAR = 0,
 	G_WRITE_STDOUT
@@ -92,6 +122,8 @@ static struct {
 	const char *pad_right;
 } b_statuses[LEN(g_blocks)];
 static unsigned char b_signals[LEN(g_blocks)];
+/* Blocks requested by g_refresh. */
+static unsigned char b_refreshes[LEN(g_blocks)];
 
 static char g_statusblocks[LEN(g_blocks)][G_STATUSBLOCKLEN];
 static char g_status_str[G_STATUSLEN];
@@ -108,6 +140,16 @@ static unsigned int g_status_str_len;
 #define B_TOSTATUS(idx)         (b_tostatus_idxs[(idx)])
 #define B_STATUSBLOCKS_LEN(idx) (b_statusblocks_len[(idx)])
 #define B_SIGNAL(idx)           (b_signals[(idx)])
+#define B_REFRESH(idx)          (b_refreshes[(idx)])
+
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+/* The block runs the command of a group, or is filled by it. */
+#	define B_IS_FIELDS(idx) (B_FUNC(idx) == b_write_shell_fields)
+#	define B_IS_FIELD(idx)  (B_FUNC(idx) == b_write_shell_field)
+#else
+#	define B_IS_FIELDS(idx) 0
+#	define B_IS_FIELD(idx)  0
+#endif
 
 #if HAVE_RT_SIGNALS
 static void
@@ -115,6 +157,10 @@ g_handler_sig_dummy(int num);
 #endif
 static int
 g_getcmds(void);
+static void
+g_profile_mark(const char *phase, unsigned int idx, const char *arg);
+static void
+g_prime_refresh(void);
 static int
 g_getcmds_sig(unsigned int signal);
 static int
@@ -152,11 +198,22 @@ static unsigned char g_status_idx[LEN(g_blocks)];
 static sigset_t sigset_rt;
 static sigset_t sigset_empty;
 
+static struct {
+	int fd;
+	g_watch_ty func;
+	void *data;
+} g_watches[G_WATCH_MAX];
+static unsigned int g_watches_len;
+static int g_refresh_pending;
+/* When the delta-based blocks are refreshed after their first sample. */
+static struct timespec g_prime_due;
+static int g_prime_pending;
+
 /* Run command or execute C function. */
 static ATTR_INLINE char *
-g_getcmd(char *dst, char *(*func)(char *dst, unsigned int dst_len, const char *arg, unsigned short *interval), const char *arg, unsigned short *interval)
+g_getcmd(char *dst, unsigned int dst_size, char *(*func)(char *dst, unsigned int dst_len, const char *arg, unsigned short *interval), const char *arg, unsigned short *interval)
 {
-	return func(dst, sizeof(g_statusblocks[0]), arg, interval);
+	return func(dst, dst_size, arg, interval);
 }
 
 int
@@ -172,6 +229,12 @@ compare_interval_and_signal(const void *a, const void *b)
 		return 1;
 	if (p->signal < q->signal)
 		return -1;
+	/* Keep the order of the config, e.g., of the blocks of a
+	 * b_write_shell_fields, as qsort is not stable. */
+	if (p->internal_tostatus_idx > q->internal_tostatus_idx)
+		return 1;
+	if (p->internal_tostatus_idx < q->internal_tostatus_idx)
+		return -1;
 	return 0;
 }
 
@@ -197,11 +260,30 @@ b_init(void)
 		B_PAD_RIGHT(B_TOSTATUS(i)) = g_blocks[i].pad_right;
 		B_SIGNAL(i) = g_blocks[i].signal;
 	}
+	/* Fields follow their command, which they are updated with. */
+	for (unsigned int i = 0, n = 0; i < LEN(g_blocks); ++i) {
+		if (!B_IS_FIELD(i)) {
+			n = 1;
+			continue;
+		}
+		if (unlikely(i == 0 || !(B_IS_FIELDS(i - 1) || B_IS_FIELD(i - 1))
+		             || B_INTERVAL(i) != B_INTERVAL(i - 1) || B_SIGNAL(i) != B_SIGNAL(i - 1)
+		             || ++n > G_FIELDS_MAX)) {
+			fprintf(stderr, "dwmblocks-fast: b_write_shell_field must follow a b_write_shell_fields with the same interval and signal, up to %d blocks.\n", G_FIELDS_MAX);
+			DIE(return -1);
+		}
+	}
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO && defined HAVE_POSIX_SPAWN
+	/* Split the commands once, instead of on their first run. */
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i)
+		if (B_FUNC(i) == b_write_shell || B_IS_FIELDS(i) || B_FUNC(i) == b_write_shell_persist)
+			b_shell_init(B_ARG(i));
+#endif
 	return 0;
 }
 
 /* Run commands or functions according to their interval. */
-static void
+static int
 g_getcmds_init(void)
 {
 	memcpy(g_status_str, S_LITERAL(G_STATUS_PAD_LEFT));
@@ -216,46 +298,230 @@ g_getcmds_init(void)
 	/* Sort blocks from their intervals. */
 	qsort(g_blocks, LEN(g_blocks), sizeof(g_blocks[0]), compare_interval_and_signal);
 	/* Initialize all statusblockss. */
-	b_init();
+	if (unlikely(b_init() == -1))
+		DIE(return -1);
+	return 0;
+}
+
+/* Store the output of block i and mark the statusbar if it changed. */
+static ATTR_INLINE void
+g_getcmd_store(unsigned int i, const char *tmp, const char *tmp_e)
+{
+	const unsigned int tmp_len = tmp_e - tmp;
+	/* Check if there has been change. */
+	if (tmp_len == B_STATUSBLOCKS_LEN(B_TOSTATUS(i))) {
+		if (!memcmp(tmp, g_statusblocks[B_TOSTATUS(i)], tmp_len))
+			return;
+	} else {
+		++g_status_changed_len;
+	}
+	/* Get the latest change. */
+	u_stpcpy_len(g_statusblocks[B_TOSTATUS(i)], tmp, tmp_len);
+	B_STATUSBLOCKS_LEN(B_TOSTATUS(i)) = tmp_len;
+	/* Mark change. */
+	++g_status_changed;
+	/* Get latest rightmost. */
+	g_status_start_idx = MIN(g_status_start_idx, B_TOSTATUS(i));
+}
+
+/* Store the output of block i, split on SHELL_FIELD_SEP into the fields
+ * after it if it is a b_write_shell_fields. Each block is still marked
+ * only if its own part changed. */
+static void
+g_getcmd_store_fields(unsigned int i, const char *tmp, const char *tmp_e)
+{
+	if (likely(!B_IS_FIELDS(i))) {
+		g_getcmd_store(i, tmp, tmp_e);
+		return;
+	}
+	for (;; ++i) {
+		const char *sep = (const char *)memchr(tmp, SHELL_FIELD_SEP, (size_t)(tmp_e - tmp));
+		const char *e = sep ? sep : tmp_e;
+		/* Missing fields are empty, and extra ones are dropped. */
+		g_getcmd_store(i, tmp, tmp + MIN((size_t)(e - tmp), sizeof(g_statusblocks[0]) - 1));
+		tmp = sep ? sep + 1 : tmp_e;
+		if (i + 1 == LEN(g_blocks) || !B_IS_FIELD(i + 1))
+			break;
+	}
+}
+
+/* Run a block and mark the statusbar if its output changed. */
+static ATTR_INLINE int
+g_getcmd_update(unsigned int i)
+{
+	/* Skip blocks with NULL function pointer. */
+	if (unlikely(B_FUNC(i) == NULL))
+		return 0;
+	/* Updated along with their b_write_shell_fields. */
+	if (B_IS_FIELD(i))
+		return 0;
+#if USE_IO_URING && defined HAVE_IO_URING
+	b_fdpool_block = i;
+#endif
+	char tmp[sizeof(g_statusblocks[0]) * G_FIELDS_MAX];
+	/* Get the result of g_getcmd. */
+	const char *tmp_e = g_getcmd(tmp, B_IS_FIELDS(i) ? sizeof(tmp) : sizeof(g_statusblocks[0]), B_FUNC(i), B_ARG(i), &B_SLEEP(i));
+#if USE_IO_URING && defined HAVE_IO_URING
+	/* Reads from watches and signals are not charged to a block. */
+	b_fdpool_block = (unsigned int)-1;
+#endif
+	if (unlikely(tmp_e == NULL))
+		DIE(return -1);
+	g_getcmd_store_fields(i, tmp, tmp_e);
+	return 0;
 }
 
 /* Run commands or functions according to their interval. */
 static int
 g_getcmds(void)
 {
+#if USE_IO_URING && defined HAVE_IO_URING
+	/* Batch the reads of the blocks that are due. */
+	unsigned long long due = 0;
+	for (unsigned int i = 0; i < LEN(g_blocks) && i < 64; ++i)
+		if (B_SLEEP(i) == 0)
+			due |= 1ULL << i;
+	if (due)
+		b_fdpool_prefetch(due);
+#endif
 	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
 		/* Check if needs update. */
 		if (B_SLEEP(i)-- > 0)
 			continue;
 		B_SLEEP(i) = B_INTERVAL(i) - 1;
-		/* Skip blocks with NULL function pointer. */
-		if (unlikely(B_FUNC(i) == NULL))
-			continue;
 		/* May need update. */
-		char tmp[sizeof(g_statusblocks[0])];
-		/* Get the result of g_getcmd. */
-		const char *tmp_e = g_getcmd(tmp, B_FUNC(i), B_ARG(i), &B_SLEEP(i));
-		if (unlikely(tmp_e == NULL))
+		if (unlikely(g_getcmd_update(i) == -1))
 			DIE(return -1);
-		const unsigned int tmp_len = tmp_e - tmp;
-		/* Check if there has been change. */
-		if (tmp_len == B_STATUSBLOCKS_LEN(B_TOSTATUS(i))) {
-			if (!memcmp(tmp, g_statusblocks[B_TOSTATUS(i)], tmp_len))
-				continue;
-		} else {
-			++g_status_changed_len;
-		}
-		/* Get the latest change. */
-		u_stpcpy_len(g_statusblocks[B_TOSTATUS(i)], tmp, tmp_len);
-		B_STATUSBLOCKS_LEN(B_TOSTATUS(i)) = tmp_len;
-		/* Mark change. */
-		++g_status_changed;
-		/* Get latest rightmost. */
-		g_status_start_idx = MIN(g_status_start_idx, B_TOSTATUS(i));
 	}
 	return 0;
 }
 
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+/* A shell block of the first pass, run on its own thread. */
+typedef struct {
+	pthread_t thread;
+	unsigned int idx;
+	int started;
+	unsigned short interval;
+	char *end;
+	char buf[sizeof(g_statusblocks[0]) * G_FIELDS_MAX];
+} g_first_ty;
+
+static void *
+g_first_thread(void *data)
+{
+	g_first_ty *f = (g_first_ty *)data;
+	f->end = g_getcmd(f->buf, B_IS_FIELDS(f->idx) ? sizeof(f->buf) : sizeof(g_statusblocks[0]), B_FUNC(f->idx), B_ARG(f->idx), &f->interval);
+	return NULL;
+}
+#endif
+
+/* Same as g_getcmds, for the first iteration, in which every block is due.
+ * Shell blocks, which only wait for their child, run on threads while the
+ * C blocks run here, so that the first frame takes as long as the slowest
+ * block instead of all of them. C blocks stay on this thread as they share
+ * the state of their modules, e.g., the fd pool; slow library inits are
+ * already deferred to helper threads. */
+static int
+g_getcmds_first(void)
+{
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+	g_first_ty first[LEN(g_blocks)];
+	/* Signals are for the main thread. */
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
+		B_SLEEP(i) = B_INTERVAL(i) - 1;
+		first[i].started = 0;
+		if (B_FUNC(i) != b_write_shell && !B_IS_FIELDS(i))
+			continue;
+		first[i].idx = i;
+		first[i].interval = B_SLEEP(i);
+		/* Else, run it here. */
+		first[i].started = !pthread_create(&first[i].thread, NULL, g_first_thread, &first[i]);
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
+		if (first[i].started)
+			continue;
+		if (unlikely(g_getcmd_update(i) == -1))
+			DIE(return -1);
+		g_profile_mark("block", B_TOSTATUS(i), B_ARG(i));
+	}
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
+		if (!first[i].started)
+			continue;
+		pthread_join(first[i].thread, NULL);
+		if (unlikely(first[i].end == NULL))
+			DIE(return -1);
+		B_SLEEP(i) = first[i].interval;
+		g_getcmd_store_fields(i, first[i].buf, first[i].end);
+		g_profile_mark("block (thread)", B_TOSTATUS(i), B_ARG(i));
+	}
+#else
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
+		B_SLEEP(i) = B_INTERVAL(i) - 1;
+		if (unlikely(g_getcmd_update(i) == -1))
+			DIE(return -1);
+		g_profile_mark("block", B_TOSTATUS(i), B_ARG(i));
+	}
+#endif
+	return 0;
+}
+
+/* Same as g_getcmds but executed for blocks requested by g_refresh. */
+static int
+g_getcmds_refresh(void)
+{
+	g_refresh_pending = 0;
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
+		if (likely(B_REFRESH(i) == 0))
+			continue;
+		B_REFRESH(i) = 0;
+		if (unlikely(g_getcmd_update(i) == -1))
+			DIE(return -1);
+	}
+	return 0;
+}
+
+void
+g_refresh(g_func_ty func, const char *arg)
+{
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
+		if (likely(B_FUNC(i) != func))
+			continue;
+		if (arg && B_ARG(i) != arg && (B_ARG(i) == NULL || strcmp(B_ARG(i), arg)))
+			continue;
+		B_REFRESH(i) = 1;
+		g_refresh_pending = 1;
+	}
+}
+
+int
+g_watch_add(int fd, g_watch_ty func, void *data)
+{
+	if (unlikely(fd < 0 || fd >= FD_SETSIZE))
+		return -1;
+	if (unlikely(g_watches_len == LEN(g_watches)))
+		return -1;
+	g_watches[g_watches_len].fd = fd;
+	g_watches[g_watches_len].func = func;
+	g_watches[g_watches_len].data = data;
+	++g_watches_len;
+	return 0;
+}
+
+void
+g_watch_del(int fd)
+{
+	for (unsigned int i = 0; i < g_watches_len; ++i)
+		if (g_watches[i].fd == fd) {
+			g_watches[i] = g_watches[--g_watches_len];
+			return;
+		}
+}
+
 /* Same as g_getcmds but executed when receiving a signal. */
 static int
 g_getcmds_sig(unsigned int signal)
@@ -268,7 +534,13 @@ g_getcmds_sig(unsigned int signal)
 			continue;
 		if (unlikely(B_FUNC(i) == NULL))
 			continue;
-		const char *end = g_getcmd(g_statusblocks[B_TOSTATUS(i)], B_FUNC(i), B_ARG(i), &B_SLEEP(i));
+		/* Split into the fields that follow it, which share its signal. */
+		if (B_IS_FIELDS(i) || B_IS_FIELD(i)) {
+			if (unlikely(g_getcmd_update(i) == -1))
+				DIE(return -1);
+			continue;
+		}
+		const char *end = g_getcmd(g_statusblocks[B_TOSTATUS(i)], sizeof(g_statusblocks[0]), B_FUNC(i), B_ARG(i), &B_SLEEP(i));
 		if (unlikely(end == NULL))
 			DIE(return -1);
 		B_STATUSBLOCKS_LEN(B_TOSTATUS(i)) = end - g_statusblocks[B_TOSTATUS(i)];
@@ -380,12 +652,80 @@ g_status_get(char *dst)
 	return dst;
 }
 
-static ATTR_INLINE void
+/* Sleep for secs or until a signal arrives. Watched fds that become
+ * readable in the meantime are dispatched without ending the sleep. */
+static int
 g_sleep(unsigned int secs)
 {
-	/* Atomically unblock signals and sleep.  pselect restores the
-	 * original (blocked) signal mask when it returns. */
-	pselect(0, NULL, NULL, NULL, &(struct timespec ){ .tv_sec = secs, .tv_nsec = 0 }, &sigset_empty);
+	struct timespec end;
+	if (unlikely(clock_gettime(CLOCK_MONOTONIC, &end) != 0))
+		DIE(return -1);
+	end.tv_sec += secs;
+	for (;;) {
+		/* Blocks may also ask for a refresh while being updated, e.g.,
+		 * when a scan notices that a process exited. */
+		if (g_refresh_pending) {
+			if (unlikely(g_getcmds_refresh() == -1))
+				DIE(return -1);
+			if (g_status_changed)
+				if (unlikely(g_status_write(g_status_str) == -1))
+					DIE(return -1);
+		}
+		struct timespec now;
+		if (unlikely(clock_gettime(CLOCK_MONOTONIC, &now) != 0))
+			DIE(return -1);
+		/* Wake up early for the refresh scheduled by g_prime. */
+		const int prime = g_prime_pending && (g_prime_due.tv_sec < end.tv_sec || (g_prime_due.tv_sec == end.tv_sec && g_prime_due.tv_nsec < end.tv_nsec));
+		const struct timespec *wake = prime ? &g_prime_due : &end;
+		struct timespec left;
+		left.tv_sec = wake->tv_sec - now.tv_sec;
+		left.tv_nsec = wake->tv_nsec - now.tv_nsec;
+		if (left.tv_nsec < 0) {
+			left.tv_nsec += 1000000000L;
+			--left.tv_sec;
+		}
+		if (left.tv_sec < 0) {
+			if (!prime)
+				return 0;
+			g_prime_refresh();
+			continue;
+		}
+		fd_set fds;
+		int nfds = 0;
+		FD_ZERO(&fds);
+		for (unsigned int i = 0; i < g_watches_len; ++i) {
+			FD_SET(g_watches[i].fd, &fds);
+			nfds = MAX(nfds, g_watches[i].fd + 1);
+		}
+		/* Atomically unblock signals and sleep.  pselect restores the
+		 * original (blocked) signal mask when it returns. */
+		const int ret = pselect(nfds, &fds, NULL, NULL, &left, &sigset_empty);
+		if (ret == 0) {
+			if (!prime)
+				return 0;
+			g_prime_refresh();
+			continue;
+		}
+		if (ret == -1) {
+			/* Let the main loop handle the signal. */
+			if (likely(errno == EINTR))
+				return 0;
+			DIE(return -1);
+		}
+		/* Go backwards, as g_watch_del moves the last watch into the
+		 * removed one. A callback may remove any watch, e.g., all fds
+		 * of a card, so one that was moved down after being dispatched
+		 * must not run again: clear its fd first. */
+		for (unsigned int i = g_watches_len; i-- > 0;) {
+			if (i >= g_watches_len || !FD_ISSET(g_watches[i].fd, &fds))
+				continue;
+			const int fd = g_watches[i].fd;
+			FD_CLR(fd, &fds);
+			if (g_watches[i].func(fd, g_watches[i].data) == -1)
+				g_watch_del(fd);
+		}
+	}
+	return 0;
 }
 
 #ifdef USE_X11
@@ -393,13 +733,24 @@ static ATTR_INLINE int
 g_XStoreNameLen(Display *dpy, Window w, const char *name, int len)
 {
 	/* Directly use XChangeProperty to save a strlen. */
-	return XChangeProperty(dpy, w, XA_WM_NAME, XA_STRING, 8, PropModeReplace, (_Xconst unsigned char *)name, len);
+	return G_X11(XChangeProperty)(dpy, w, XA_WM_NAME, XA_STRING, 8, PropModeReplace, (_Xconst unsigned char *)name, len);
 }
 
 static int
 g_init_x11(void)
 {
-	g_dpy = XOpenDisplay(NULL);
+#	ifdef USE_DLOPEN
+	void *h = b_dl_open("libX11.so.6");
+	if (unlikely(h == NULL
+	             || B_DL_SYM(h, g_x11, XOpenDisplay) == -1
+	             || B_DL_SYM(h, g_x11, XChangeProperty) == -1
+	             || B_DL_SYM(h, g_x11, XFlush) == -1
+	             || B_DL_SYM(h, g_x11, XCloseDisplay) == -1)) {
+		fprintf(stderr, "dwmblocks-fast: Failed to load libX11.so.6.\n");
+		DIE(return -1);
+	}
+#	endif
+	g_dpy = G_X11(XOpenDisplay)(NULL);
 	if (unlikely(g_dpy == NULL)) {
 		fprintf(stderr, "dwmblocks-fast: Failed to open display.\n");
 		DIE(return -1);
@@ -415,7 +766,7 @@ static void
 g_status_write_x11(const char *status, int status_len)
 {
 	g_XStoreNameLen(g_dpy, g_win_root, status, status_len);
-	XFlush(g_dpy);
+	G_X11(XFlush)(g_dpy);
 }
 #endif
 
@@ -451,40 +802,140 @@ g_status_write(char *status)
 	return 0;
 }
 
-/* Update hwmon/hwmon[0-9]* and thermal/thermal_zone[0-9]* to point to
- * the real file, given that the number may change between reboots. */
-static int
-g_paths_sysfs_resolve(void)
+/* Delta-based blocks print nothing useful until they have a previous
+ * sample, so take one before the first frame. */
+static const struct {
+	g_func_ty func;
+	int (*prime)(void);
+} g_primes[] = {
+#ifdef HAVE_PROCFS
+	{ b_write_cpu_usage, b_cpu_usage_prime },
+#endif
+#ifdef HAVE_POWERCAP
+	{ b_write_cpu_usage_power, b_powercap_prime },
+	{ b_write_power, b_powercap_prime },
+#endif
+	{ NULL, NULL }
+};
+
+#if defined USE_SNAPSHOT && defined HAVE_PROCFS
+#	define G_SNAPSHOT 1
+#endif
+
+static void
+g_prime(void)
 {
-	for (unsigned int i = 0; i < LEN(g_blocks); ++i) {
-		if (g_blocks[i].arg && (strstr(g_blocks[i].arg, "/sys/"))) {
-			const char *p = path_sysfs_resolve(g_blocks[i].arg);
-			if (unlikely(p == NULL))
-				DIE(return -1);
-			if (p != g_blocks[i].arg) {
-				DBG(fprintf(stderr, "%s:%d:%s: %s doesn't exist, resolved to %s (which is malloc'd).\n", __FILE__, __LINE__, ASSERT_FUNC, g_blocks[i].arg, p));
-				/* Set new path. */
-				g_blocks[i].arg = p;
-			} else {
-				DBG(fprintf(stderr, "%s:%d:%s %s exists.\n", __FILE__, __LINE__, ASSERT_FUNC, p));
-			}
+#ifdef G_SNAPSHOT
+	if (b_snapshot_init(getenv("XDG_RUNTIME_DIR")) == 0)
+		b_snapshot_read();
+#endif
+	int primed = 0;
+	for (unsigned int i = 0; i < LEN(g_blocks); ++i)
+		for (unsigned int j = 0; g_primes[j].func != NULL; ++j)
+			/* Errors are left to the block. */
+			if (B_FUNC(i) == g_primes[j].func && g_primes[j].prime() == 1)
+				primed = 1;
+	/* Do not hold back the first frame: show it now and refresh these
+	 * blocks once the interval has passed, from g_sleep. */
+	if (primed && INTERVAL_PRIME_MS > 0 && clock_gettime(CLOCK_MONOTONIC, &g_prime_due) == 0) {
+		g_prime_due.tv_sec += INTERVAL_PRIME_MS / 1000;
+		g_prime_due.tv_nsec += (INTERVAL_PRIME_MS % 1000) * 1000000L;
+		if (g_prime_due.tv_nsec >= 1000000000L) {
+			g_prime_due.tv_nsec -= 1000000000L;
+			++g_prime_due.tv_sec;
+		}
+		g_prime_pending = 1;
+	}
+}
+
+static void
+g_prime_refresh(void)
+{
+	g_prime_pending = 0;
+	for (unsigned int j = 0; g_primes[j].func != NULL; ++j)
+		g_refresh(g_primes[j].func, NULL);
+}
+
+/* --profile-startup: print the time of each startup phase and of the first
+ * sample of each block to stderr, and exit after the first frame. */
+static int g_profile;
+static struct timespec g_profile_start;
+static struct timespec g_profile_last;
+
+static unsigned long long
+g_profile_us(const struct timespec *start, const struct timespec *end)
+{
+	return (unsigned long long)((end->tv_sec - start->tv_sec) * 1000000LL + (end->tv_nsec - start->tv_nsec) / 1000);
+}
+
+/* Print "startup: phase[ idx[ arg]]: +[since last mark] us, [since main] us". */
+static void
+g_profile_mark(const char *phase, unsigned int idx, const char *arg)
+{
+	if (likely(!g_profile))
+		return;
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	char buf[256];
+	char *p = u_stpcpy(u_stpcpy_len(buf, S_LITERAL("startup: ")), phase);
+	if (idx != (unsigned int)-1) {
+		*p++ = ' ';
+		p = u_utoa_p(idx, p);
+		if (arg && strlen(arg) < 64) {
+			*p++ = ' ';
+			p = u_stpcpy(p, arg);
 		}
 	}
+	p = u_stpcpy_len(p, S_LITERAL(": +"));
+	p = u_ulltoa_p(g_profile_us(&g_profile_last, &now), p);
+	p = u_stpcpy_len(p, S_LITERAL(" us, "));
+	p = u_ulltoa_p(g_profile_us(&g_profile_start, &now), p);
+	p = u_stpcpy_len(p, S_LITERAL(" us\n"));
+	const ssize_t ret = write(STDERR_FILENO, buf, (size_t)(p - buf));
+	(void)ret;
+	/* Exclude the cost of printing. */
+	clock_gettime(CLOCK_MONOTONIC, &g_profile_last);
+}
+
+static void
+g_profile_init(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &g_profile_start);
+	g_profile_last = g_profile_start;
+}
+
+/* First iteration of the main loop, timing each block. */
+static int
+g_profile_first_frame(void)
+{
+	if (unlikely(g_getcmds_first() == -1))
+		DIE(return -1);
+	if (g_status_changed)
+		if (unlikely(g_status_write(g_status_str) == -1))
+			DIE(return -1);
+	g_profile_mark("first frame", (unsigned int)-1, NULL);
 	return 0;
 }
 
 static int
 g_status_init(void)
 {
-	if (unlikely(g_paths_sysfs_resolve() == -1))
-		DIE(return -1);
 #ifdef USE_X11
-	if (unlikely(g_init_x11() == -1))
-		DIE(return -1);
+	/* Not needed to print to stdout. */
+	if (g_write_dst == G_WRITE_STATUSBAR) {
+		if (unlikely(g_init_x11() == -1))
+			DIE(return -1);
+		g_profile_mark("x11", (unsigned int)-1, NULL);
+	}
 #endif
-	g_getcmds_init();
+	if (unlikely(g_getcmds_init() == -1))
+		DIE(return -1);
+	g_profile_mark("init", (unsigned int)-1, NULL);
+	g_prime();
+	g_profile_mark("prime", (unsigned int)-1, NULL);
 	if (unlikely(g_init_signals() == -1))
 		DIE(return -1);
+	g_profile_mark("signals", (unsigned int)-1, NULL);
 	return 0;
 }
 
@@ -492,7 +943,8 @@ static void
 g_status_cleanup(void)
 {
 #ifdef USE_X11
-	XCloseDisplay(g_dpy);
+	if (g_dpy)
+		G_X11(XCloseDisplay)(g_dpy);
 #endif
 }
 
@@ -500,6 +952,8 @@ g_status_cleanup(void)
 static int
 g_status_mainloop(void)
 {
+	if (unlikely(g_profile))
+		return g_profile_first_frame();
 	for (;;) {
 		const sig_atomic_t mask = g_signal_mask;
 		g_signal_mask = 0;
@@ -513,6 +967,9 @@ g_status_mainloop(void)
 						if (unlikely(g_getcmds_sig(s) == -1))
 							DIE(return -1);
 			}
+		} else if (unlikely(g_time == 0)) {
+			if (unlikely(g_getcmds_first() == -1))
+				DIE(return -1);
 		} else {
 			if (unlikely(g_getcmds() == -1))
 				DIE(return -1);
@@ -524,7 +981,8 @@ g_status_mainloop(void)
 #ifdef TEST
 		return 0;
 #endif
-		g_sleep(INTERVAL_UPDATE);
+		if (unlikely(g_sleep(INTERVAL_UPDATE) == -1))
+			DIE(return -1);
 	}
 	return 0;
 }
@@ -559,6 +1017,9 @@ g_handler_sig(int signum)
 static void
 g_handler_term(int signum)
 {
+#ifdef G_SNAPSHOT
+	b_snapshot_write();
+#endif
 	write(STDERR_FILENO, S_LITERAL("Exiting!\n"));;
 	_Exit(EXIT_SUCCESS);
 	(void)signum;
@@ -575,13 +1036,18 @@ g_handler_restart(int signum)
 int
 main(int argc, char **argv)
 {
-#ifdef USE_X11
 	/* Handle command line arguments. */
-	for (int i = 0; i < argc; ++i)
+	for (int i = 1; i < argc; ++i) {
+#ifdef USE_X11
 		/* Check if printing to stdout. */
 		if (!strcmp("-p", argv[i]))
 			g_write_dst = G_WRITE_STDOUT;
 #endif
+		if (!strcmp("--profile-startup", argv[i])) {
+			g_profile = 1;
+			g_profile_init();
+		}
+	}
 	if (unlikely(g_status_init() == -1))
 		DIE(return EXIT_FAILURE);
 	if (unlikely(g_status_mainloop() == -1))
@@ -3,4 +3,24 @@
 
 extern unsigned int g_time;
 
+typedef char *(*g_func_ty)(char *dst, unsigned int dst_len, const char *arg, unsigned short *interval);
+
+/* Called by the main loop when fd is readable.
+ * Return -1 to stop watching fd. */
+typedef int (*g_watch_ty)(int fd, void *data);
+
+/* Watch fd for readability in the main loop, which lets blocks be
+ * updated by events instead of polling. */
+int
+g_watch_add(int fd, g_watch_ty func, void *data);
+/* Stop watching fd. May be called from any watch callback, also for the
+ * fds of other watches. */
+void
+g_watch_del(int fd);
+
+/* Rerun the blocks with func and arg (NULL matches any arg) when the
+ * main loop handles the current event. */
+void
+g_refresh(g_func_ty func, const char *arg);
+
 #endif /* DWMBLOCKS_FAST_H */
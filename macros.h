@@ -117,6 +117,10 @@
 #		define HAVE_FILENO 1
 #	endif
 
+#	if (_POSIX_C_SOURCE - 0) >= 200112L
+#		define HAVE_POSIX_SPAWN 1
+#	endif
+
 #	if XGLIBC_PREREQ(2, 10) && (_POSIX_C_SOURCE - 0) >= 200809L \
 	|| defined _GNU_SOURCE
 #		define HAVE_STPCPY 1
@@ -264,6 +268,18 @@
 #		if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 24)
 #			define HAVE_POWERCAP 1
 #		endif
+#		if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 15)
+#			define HAVE_PROC_CONNECTOR 1
+#		endif
+#		if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 3, 0)
+#			define HAVE_PIDFD_OPEN 1
+#		endif
+#		if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 27)
+#			define HAVE_INOTIFY 1
+#		endif
+#		if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+#			define HAVE_IO_URING 1
+#		endif
 #	endif
 
 #endif /* MACROS_H */
@@ -0,0 +1,375 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ *
+ * Micro-benchmarks for the hot paths of block functions.
+ *
+ * Each benchmark reports the mean wall-clock cost of one call in
+ * nanoseconds, so that alternative backends can be compared on the
+ * same machine.
+ *
+ * Build:
+ *   cc -o tests/bench-bin tests/bench.c \
+ *      $(OBJS) $(REQ) $(LDFLAGS)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/sysinfo.h>
+#include <sys/wait.h>
+
+#include "../blocks/procfs.h"
+#include "../blocks/fdpool.h"
+#include "../blocks/shell.h"
+#include "../dwmblocks-fast.h"
+#include "../utils.h"
+
+/* Satisfy extern references from block object files. */
+unsigned int g_time;
+
+int
+g_watch_add(int fd, g_watch_ty func, void *data)
+{
+	return -1;
+	(void)fd;
+	(void)func;
+	(void)data;
+}
+
+void
+g_watch_del(int fd)
+{
+	(void)fd;
+}
+
+void
+g_refresh(g_func_ty func, const char *arg)
+{
+	(void)func;
+	(void)arg;
+}
+
+extern char *b_write_ram_usage_percent(char *dst, unsigned int dst_size,
+                                       const char *unused, unsigned short *interval);
+
+#define BENCH_ITERS 20000
+
+static unsigned long long
+bench_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/* Run fn iters times and return the mean cost of one call in ns. */
+static double
+bench_run(const char *name, void (*fn)(void), unsigned int iters)
+{
+	/* Warm up caches and lazily opened fds. */
+	fn();
+	const unsigned long long start = bench_now_ns();
+	for (unsigned int i = 0; i < iters; ++i)
+		fn();
+	const double ns = (double)(bench_now_ns() - start) / (double)iters;
+	printf("  %-44s %10.0f ns/call\n", name, ns);
+	return ns;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Bench 1 — RAM: /proc/meminfo parse vs sysinfo(2)                  */
+/* ------------------------------------------------------------------ */
+
+static int bench_meminfo_fd = -1;
+static volatile unsigned long long bench_sink;
+
+static void
+bench_ram_meminfo(void)
+{
+	char buf[B_PAGE_SIZE + 1];
+	const unsigned int sz = b_proc_read_filefd(buf, sizeof(buf), bench_meminfo_fd);
+	struct b_proc_iter iter;
+	b_proc_iter_init(&iter, buf, sz);
+	const char *key, *val;
+	unsigned int key_len, val_len;
+	unsigned long long total = 0, avail = 0;
+	while (b_proc_iter_next(&iter, &key, &key_len, &val, &val_len, ':')) {
+		if (key_len == S_LEN("MemTotal") && !memcmp(key, "MemTotal", S_LEN("MemTotal"))) {
+			total = u_atoull10(val);
+		} else if (key_len == S_LEN("MemAvailable") && !memcmp(key, "MemAvailable", S_LEN("MemAvailable"))) {
+			avail = u_atoull10(val);
+			break;
+		}
+	}
+	bench_sink = total - avail;
+}
+
+static void
+bench_ram_sysinfo(void)
+{
+	struct sysinfo info;
+	sysinfo(&info);
+	bench_sink = (unsigned long long)info.totalram - info.freeram - info.bufferram;
+}
+
+static void
+bench_ram_block(void)
+{
+	char buf[32];
+	unsigned short interval;
+	/* Defeat the per-tick cache. */
+	++g_time;
+	b_write_ram_usage_percent(buf, sizeof(buf), NULL, &interval);
+}
+
+static void
+bench_ram(void)
+{
+	printf("  [bench 1] RAM usage\n");
+	bench_meminfo_fd = open("/proc/meminfo", O_RDONLY);
+	if (bench_meminfo_fd == -1) {
+		printf("  SKIP (no /proc/meminfo)\n");
+		return;
+	}
+	const double meminfo = bench_run("pread + parse /proc/meminfo", bench_ram_meminfo, BENCH_ITERS);
+	const double sys = bench_run("sysinfo(2)", bench_ram_sysinfo, BENCH_ITERS);
+	bench_run("b_write_ram_usage_percent (configured)", bench_ram_block, BENCH_ITERS);
+	printf("  sysinfo speedup: %.1fx\n\n", meminfo / sys);
+	close(bench_meminfo_fd);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Bench 2 — /proc: one readdir per name vs one getdents64 pass      */
+/* ------------------------------------------------------------------ */
+
+static const char *const bench_proc_names[] = { "obs", "obs-ffmpeg-mux", "dwmb-absent-1", "dwmb-absent-2", "dwmb-absent-3" };
+#define BENCH_PROC_N (sizeof(bench_proc_names) / sizeof(bench_proc_names[0]))
+static unsigned int bench_proc_names_len[BENCH_PROC_N];
+
+/* The scanner as it was before b_proc_exist_many: readdir and
+ * open/read/close of every comm, once per name. */
+static unsigned int
+bench_proc_exist_readdir(const char *name, unsigned int name_len)
+{
+	DIR *dp = opendir("/proc");
+	if (dp == NULL)
+		return (unsigned int)-1;
+	unsigned int ret = 0;
+	struct dirent *ep;
+	char path[64];
+	char comm[32];
+	while ((ep = readdir(dp))) {
+		if (ep->d_name[0] < '0' || ep->d_name[0] > '9')
+			continue;
+		snprintf(path, sizeof(path), "/proc/%s/comm", ep->d_name);
+		const int fd = open(path, O_RDONLY);
+		if (fd == -1)
+			continue;
+		const ssize_t n = read(fd, comm, sizeof(comm));
+		close(fd);
+		if (n == (ssize_t)name_len + 1 && !memcmp(comm, name, name_len)) {
+			ret = (unsigned int)atoi(ep->d_name);
+			break;
+		}
+	}
+	closedir(dp);
+	return ret;
+}
+
+static void
+bench_proc_per_name(void)
+{
+	for (unsigned int i = 0; i < BENCH_PROC_N; ++i)
+		bench_sink += bench_proc_exist_readdir(bench_proc_names[i], bench_proc_names_len[i]);
+}
+
+static void
+bench_proc_many(void)
+{
+	unsigned int pids[BENCH_PROC_N];
+	b_proc_exist_many(bench_proc_names, bench_proc_names_len, BENCH_PROC_N, pids);
+	bench_sink += pids[0];
+}
+
+static void
+bench_proc(void)
+{
+	printf("  [bench 2] /proc scan for %u names\n", (unsigned int)BENCH_PROC_N);
+	for (unsigned int i = 0; i < BENCH_PROC_N; ++i)
+		bench_proc_names_len[i] = (unsigned int)strlen(bench_proc_names[i]);
+	/* BENCH_NPROC=5000 populates /proc with idle children. */
+	const char *env = getenv("BENCH_NPROC");
+	const unsigned int nproc = env ? (unsigned int)atoi(env) : 0;
+	pid_t *children = nproc ? calloc(nproc, sizeof(pid_t)) : NULL;
+	unsigned int nchildren = 0;
+	for (; nchildren < nproc && children; ++nchildren) {
+		const pid_t pid = fork();
+		if (pid == -1)
+			break;
+		if (pid == 0) {
+			pause();
+			_exit(0);
+		}
+		children[nchildren] = pid;
+	}
+	if (nchildren)
+		printf("  (%u extra processes)\n", nchildren);
+	const double per_name = bench_run("readdir + open/read/close per name", bench_proc_per_name, BENCH_ITERS / 200);
+	const double many = bench_run("b_proc_exist_many (one getdents64 pass)", bench_proc_many, BENCH_ITERS / 200);
+	printf("  batched speedup: %.1fx\n\n", per_name / many);
+	for (unsigned int i = 0; i < nchildren; ++i)
+		kill(children[i], SIGKILL);
+	for (unsigned int i = 0; i < nchildren; ++i)
+		waitpid(children[i], NULL, 0);
+	free(children);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Bench 3 — small kernel file: open/read/close vs fd pool pread     */
+/* ------------------------------------------------------------------ */
+
+#define BENCH_READ_FILE "/proc/loadavg"
+
+static void
+bench_read_open(void)
+{
+	char buf[128];
+	bench_sink += b_proc_read_file(buf, sizeof(buf), BENCH_READ_FILE);
+}
+
+static void
+bench_read_fdpool(void)
+{
+	char buf[128];
+	bench_sink += b_fdpool_read(buf, sizeof(buf), BENCH_READ_FILE);
+}
+
+static void
+bench_read(void)
+{
+	printf("  [bench 3] read %s\n", BENCH_READ_FILE);
+	const double open_read = bench_run("open + read + close", bench_read_open, BENCH_ITERS);
+	const double pool = bench_run("b_fdpool_read (pread)", bench_read_fdpool, BENCH_ITERS);
+	printf("  fd pool speedup: %.1fx\n\n", open_read / pool);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Bench 4 — one tick of reads: pread each vs io_uring prefetch      */
+/* ------------------------------------------------------------------ */
+
+static const char *const bench_tick_files[] = { "/proc/stat", "/proc/meminfo", "/proc/loadavg", "/proc/uptime" };
+#define BENCH_TICK_N (sizeof(bench_tick_files) / sizeof(bench_tick_files[0]))
+
+static void
+bench_tick_pread(void)
+{
+	char buf[B_PAGE_SIZE + 1];
+	for (unsigned int i = 0; i < BENCH_TICK_N; ++i)
+		bench_sink += b_fdpool_read(buf, sizeof(buf), bench_tick_files[i]);
+}
+
+#if USE_IO_URING && defined HAVE_IO_URING
+static void
+bench_tick_uring(void)
+{
+	char buf[B_PAGE_SIZE + 1];
+	++g_time;
+	b_fdpool_prefetch(1);
+	for (unsigned int i = 0; i < BENCH_TICK_N; ++i)
+		bench_sink += b_fdpool_read(buf, sizeof(buf), bench_tick_files[i]);
+}
+#endif
+
+static void
+bench_tick(void)
+{
+	printf("  [bench 4] one tick of %u reads\n", (unsigned int)BENCH_TICK_N);
+#if USE_IO_URING && defined HAVE_IO_URING
+	/* Let the pool learn the files of "block" 0. */
+	b_fdpool_block = 0;
+	const double each = bench_run("pread per file", bench_tick_pread, BENCH_ITERS);
+	const double uring = bench_run("b_fdpool_prefetch (one io_uring_enter)", bench_tick_uring, BENCH_ITERS);
+	printf("  io_uring speedup: %.1fx\n\n", each / uring);
+#else
+	bench_run("pread per file", bench_tick_pread, BENCH_ITERS);
+	printf("  SKIP io_uring (USE_IO_URING is 0)\n\n");
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/*  Bench 5 — shell block: popen vs posix_spawn                       */
+/* ------------------------------------------------------------------ */
+
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+static void
+bench_shell_popen(void)
+{
+	char buf[32];
+	FILE *fp = popen("echo 1", "r");
+	if (fp == NULL)
+		return;
+	bench_sink += (unsigned long long)read(fileno(fp), buf, sizeof(buf));
+	pclose(fp);
+}
+
+static void
+bench_shell_sh(void)
+{
+	char buf[32];
+	unsigned short interval;
+	/* The quotes need the shell. */
+	bench_sink += (unsigned long long)(b_write_shell(buf, sizeof(buf), "echo '1'", &interval) - buf);
+}
+
+static const char bench_shell_cmd[] = "echo 1";
+
+static void
+bench_shell_direct(void)
+{
+	char buf[32];
+	unsigned short interval;
+	bench_sink += (unsigned long long)(b_write_shell(buf, sizeof(buf), bench_shell_cmd, &interval) - buf);
+}
+#endif
+
+static void
+bench_shell(void)
+{
+	printf("  [bench 5] shell block running echo\n");
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+	const double popen_ns = bench_run("popen (fork + sh -c)", bench_shell_popen, BENCH_ITERS / 40);
+	bench_run("b_write_shell, needs sh", bench_shell_sh, BENCH_ITERS / 40);
+#	if defined HAVE_POSIX_SPAWN
+	b_shell_init(bench_shell_cmd);
+#	endif
+	const double direct = bench_run("b_write_shell, direct exec", bench_shell_direct, BENCH_ITERS / 40);
+	printf("  direct exec speedup: %.1fx\n\n", popen_ns / direct);
+#else
+	printf("  SKIP (no popen)\n\n");
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/*  main                                                              */
+/* ------------------------------------------------------------------ */
+
+int
+main(void)
+{
+	printf("dwmblocks-fast benchmarks\n");
+	printf("=========================\n\n");
+
+	bench_ram();
+	bench_proc();
+	bench_read();
+	bench_tick();
+	bench_shell();
+
+	return 0;
+}
@@ -0,0 +1,323 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ *
+ * Stand-in for libasound with a "Master" and a "Capture" element, for
+ * tests/test-edge-cases.c. Built as tests/stubs/libasound.so.2 and found
+ * through LD_LIBRARY_PATH by the dlopen of blocks/audio-alsa.c.
+ *
+ * Each mixer polls on a pipe that stub_alsa_set writes to, as another
+ * application changing the volume would. Like in libasound, the values
+ * seen through a mixer are only updated by snd_mixer_handle_events.
+ */
+
+#include "../config.h"
+
+#ifdef USE_ALSA
+#	include <stdlib.h>
+#	include <string.h>
+#	include <unistd.h>
+#	include <fcntl.h>
+#	include <alsa/asoundlib.h>
+
+#	define STUB_ELEMS 2
+
+static const char *const stub_names[STUB_ELEMS] = { "Master", "Capture" };
+
+/* The card. */
+static long stub_vol[STUB_ELEMS] = { 50, 30 };
+static int stub_sw[STUB_ELEMS] = { 1, 1 };
+
+struct snd_mixer_elem {
+	long vol;
+	int sw;
+	snd_mixer_elem_callback_t callback;
+	void *private_data;
+};
+
+struct snd_mixer {
+	int fds[2];
+	struct snd_mixer_elem elems[STUB_ELEMS];
+	snd_mixer_t *next;
+};
+
+struct snd_mixer_selem_id {
+	char name[32];
+};
+
+static snd_mixer_t *stub_mixers;
+
+/* Number of mixers opened and of snd_mixer_handle_events calls so far. */
+unsigned int stub_alsa_opens;
+unsigned int stub_alsa_events;
+/* The card is unplugged. */
+static int stub_unplugged;
+
+/* Set the element name of the card, and notify every mixer. */
+void
+stub_alsa_set(const char *name, long vol, int sw)
+{
+	for (unsigned int i = 0; i < STUB_ELEMS; ++i)
+		if (!strcmp(stub_names[i], name)) {
+			stub_vol[i] = vol;
+			stub_sw[i] = sw;
+		}
+	for (snd_mixer_t *m = stub_mixers; m; m = m->next)
+		if (write(m->fds[1], "", 1) == -1)
+			abort();
+}
+
+/* Unplug the card, or plug it back in. Like a real card, the fds of its
+ * mixers stay readable once it is gone. */
+void
+stub_alsa_unplug(int unplugged)
+{
+	stub_unplugged = unplugged;
+	for (snd_mixer_t *m = stub_mixers; m; m = m->next)
+		if (write(m->fds[1], "", 1) == -1)
+			abort();
+}
+
+/* The fd of the last opened mixer, or -1. */
+int
+stub_alsa_fd(void)
+{
+	return stub_mixers ? stub_mixers->fds[0] : -1;
+}
+
+int
+snd_mixer_open(snd_mixer_t **mixer, int mode)
+{
+	/* -ENODEV */
+	if (stub_unplugged)
+		return -19;
+	snd_mixer_t *m = calloc(1, sizeof(*m));
+	if (m == NULL)
+		return -12;
+	if (pipe(m->fds) == -1) {
+		free(m);
+		return -24;
+	}
+	fcntl(m->fds[0], F_SETFL, O_NONBLOCK);
+	for (unsigned int i = 0; i < STUB_ELEMS; ++i) {
+		m->elems[i].vol = stub_vol[i];
+		m->elems[i].sw = stub_sw[i];
+	}
+	m->next = stub_mixers;
+	stub_mixers = m;
+	++stub_alsa_opens;
+	*mixer = m;
+	return 0;
+	(void)mode;
+}
+
+int
+snd_mixer_close(snd_mixer_t *mixer)
+{
+	for (snd_mixer_t **p = &stub_mixers; *p; p = &(*p)->next)
+		if (*p == mixer) {
+			*p = mixer->next;
+			break;
+		}
+	close(mixer->fds[0]);
+	close(mixer->fds[1]);
+	free(mixer);
+	return 0;
+}
+
+int
+snd_mixer_attach(snd_mixer_t *mixer, const char *name)
+{
+	return 0;
+	(void)mixer;
+	(void)name;
+}
+
+int
+snd_mixer_selem_register(snd_mixer_t *mixer, struct snd_mixer_selem_regopt *options, snd_mixer_class_t **classp)
+{
+	return 0;
+	(void)mixer;
+	(void)options;
+	(void)classp;
+}
+
+int
+snd_mixer_load(snd_mixer_t *mixer)
+{
+	return 0;
+	(void)mixer;
+}
+
+int
+snd_mixer_selem_id_malloc(snd_mixer_selem_id_t **ptr)
+{
+	*ptr = calloc(1, sizeof(**ptr));
+	return *ptr ? 0 : -12;
+}
+
+void
+snd_mixer_selem_id_free(snd_mixer_selem_id_t *obj)
+{
+	free(obj);
+}
+
+void
+snd_mixer_selem_id_set_index(snd_mixer_selem_id_t *obj, unsigned int val)
+{
+	(void)obj;
+	(void)val;
+}
+
+void
+snd_mixer_selem_id_set_name(snd_mixer_selem_id_t *obj, const char *val)
+{
+	strncpy(obj->name, val, sizeof(obj->name) - 1);
+}
+
+snd_mixer_elem_t *
+snd_mixer_find_selem(snd_mixer_t *mixer, const snd_mixer_selem_id_t *id)
+{
+	for (unsigned int i = 0; i < STUB_ELEMS; ++i)
+		if (!strcmp(stub_names[i], id->name))
+			return &mixer->elems[i];
+	return NULL;
+}
+
+int
+snd_mixer_selem_get_playback_volume_range(snd_mixer_elem_t *elem, long *min, long *max)
+{
+	*min = 0;
+	*max = 100;
+	return 0;
+	(void)elem;
+}
+
+int
+snd_mixer_selem_get_capture_volume_range(snd_mixer_elem_t *elem, long *min, long *max)
+{
+	*min = 0;
+	*max = 100;
+	return 0;
+	(void)elem;
+}
+
+int
+snd_mixer_selem_has_playback_switch(snd_mixer_elem_t *elem)
+{
+	return 1;
+	(void)elem;
+}
+
+int
+snd_mixer_selem_has_capture_switch(snd_mixer_elem_t *elem)
+{
+	return 1;
+	(void)elem;
+}
+
+int
+snd_mixer_handle_events(snd_mixer_t *mixer)
+{
+	++stub_alsa_events;
+	if (stub_unplugged) {
+		for (unsigned int i = 0; i < STUB_ELEMS; ++i)
+			if (mixer->elems[i].callback)
+				mixer->elems[i].callback(&mixer->elems[i], SND_CTL_EVENT_MASK_REMOVE);
+		return -19;
+	}
+	char buf[64];
+	while (read(mixer->fds[0], buf, sizeof(buf)) > 0)
+		;
+	int n = 0;
+	for (unsigned int i = 0; i < STUB_ELEMS; ++i) {
+		snd_mixer_elem_t *elem = &mixer->elems[i];
+		if (elem->vol == stub_vol[i] && elem->sw == stub_sw[i])
+			continue;
+		elem->vol = stub_vol[i];
+		elem->sw = stub_sw[i];
+		if (elem->callback)
+			elem->callback(elem, SND_CTL_EVENT_MASK_VALUE);
+		++n;
+	}
+	return n;
+}
+
+int
+snd_mixer_selem_get_playback_volume(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, long *value)
+{
+	*value = elem->vol;
+	return 0;
+	(void)channel;
+}
+
+int
+snd_mixer_selem_get_capture_volume(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, long *value)
+{
+	*value = elem->vol;
+	return 0;
+	(void)channel;
+}
+
+int
+snd_mixer_selem_get_playback_switch(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, int *value)
+{
+	*value = elem->sw;
+	return 0;
+	(void)channel;
+}
+
+int
+snd_mixer_selem_get_capture_switch(snd_mixer_elem_t *elem, snd_mixer_selem_channel_id_t channel, int *value)
+{
+	*value = elem->sw;
+	return 0;
+	(void)channel;
+}
+
+int
+snd_mixer_poll_descriptors_count(snd_mixer_t *mixer)
+{
+	return 1;
+	(void)mixer;
+}
+
+int
+snd_mixer_poll_descriptors(snd_mixer_t *mixer, struct pollfd *pfds, unsigned int space)
+{
+	if (space < 1)
+		return 0;
+	pfds[0].fd = mixer->fds[0];
+	pfds[0].events = POLLIN;
+	pfds[0].revents = 0;
+	return 1;
+}
+
+void
+snd_mixer_elem_set_callback(snd_mixer_elem_t *obj, snd_mixer_elem_callback_t val)
+{
+	obj->callback = val;
+}
+
+void *
+snd_mixer_elem_get_callback_private(const snd_mixer_elem_t *obj)
+{
+	return obj->private_data;
+}
+
+void
+snd_mixer_elem_set_callback_private(snd_mixer_elem_t *obj, void *val)
+{
+	obj->private_data = val;
+}
+
+const char *
+snd_strerror(int errnum)
+{
+	(void)errnum;
+	return "stub";
+}
+
+#else
+/* ISO C forbids an empty translation unit. */
+typedef int stub_alsa_unused;
+#endif
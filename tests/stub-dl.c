@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ *
+ * Stand-in for an optional library, loaded by tests/test-edge-cases.c
+ * through blocks/dl.c. Built as tests/libdwmblocks-stub.so.
+ */
+
+/* Versioned like nvmlInit_v2. */
+int
+b_stub_answer_v2(void)
+{
+	return 42;
+}
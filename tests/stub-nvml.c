@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ *
+ * Stand-in for libnvidia-ml with two GPUs that counts device queries, for
+ * tests/test-edge-cases.c. Built as tests/stubs/libnvidia-ml.so.1 and
+ * found through LD_LIBRARY_PATH by the dlopen of blocks/gpu-nvidia.c.
+ */
+
+#include "../config.h"
+
+#ifdef USE_CUDA
+#	include <stdint.h>
+#	include <string.h>
+#	include NVML_HEADER
+
+#	define STUB_DEVICES 2
+
+/* Number of device queries so far. */
+unsigned int stub_nvml_calls;
+/* Number of nvmlInit calls to fail, as if the driver were not loaded. */
+unsigned int stub_nvml_init_fails;
+
+static unsigned int
+stub_idx(nvmlDevice_t dev)
+{
+	return (unsigned int)(uintptr_t)dev - 1;
+}
+
+nvmlReturn_t
+nvmlInit(void)
+{
+	if (stub_nvml_init_fails) {
+		--stub_nvml_init_fails;
+		return NVML_ERROR_NOT_SUPPORTED;
+	}
+	return NVML_SUCCESS;
+}
+
+nvmlReturn_t
+nvmlShutdown(void)
+{
+	return NVML_SUCCESS;
+}
+
+const char *
+nvmlErrorString(nvmlReturn_t result)
+{
+	(void)result;
+	return "stub";
+}
+
+nvmlReturn_t
+nvmlDeviceGetCount(unsigned int *count)
+{
+	*count = STUB_DEVICES;
+	return NVML_SUCCESS;
+}
+
+nvmlReturn_t
+nvmlDeviceGetHandleByIndex(unsigned int idx, nvmlDevice_t *dev)
+{
+	*dev = (nvmlDevice_t)(uintptr_t)(idx + 1);
+	return NVML_SUCCESS;
+}
+
+nvmlReturn_t
+nvmlDeviceGetUUID(nvmlDevice_t dev, char *uuid, unsigned int length)
+{
+	if (length < sizeof("GPU-stub-0"))
+		return NVML_ERROR_INSUFFICIENT_SIZE;
+	memcpy(uuid, "GPU-stub-0", sizeof("GPU-stub-0"));
+	uuid[sizeof("GPU-stub-0") - 2] = (char)('0' + stub_idx(dev));
+	return NVML_SUCCESS;
+}
+
+/* 40 and 41 degrees. */
+nvmlReturn_t
+nvmlDeviceGetTemperatureV(nvmlDevice_t dev, nvmlTemperature_t *temp)
+{
+	++stub_nvml_calls;
+	temp->temperature = 40 + (int)stub_idx(dev);
+	return NVML_SUCCESS;
+}
+
+nvmlReturn_t
+nvmlDeviceGetTemperature(nvmlDevice_t dev, nvmlTemperatureSensors_t sensor, unsigned int *temp)
+{
+	++stub_nvml_calls;
+	*temp = 40 + stub_idx(dev);
+	(void)sensor;
+	return NVML_SUCCESS;
+}
+
+/* 10% and 20%. */
+nvmlReturn_t
+nvmlDeviceGetUtilizationRates(nvmlDevice_t dev, nvmlUtilization_t *utilization)
+{
+	++stub_nvml_calls;
+	utilization->gpu = 10 * (stub_idx(dev) + 1);
+	utilization->memory = 0;
+	return NVML_SUCCESS;
+}
+
+/* 25% used. */
+nvmlReturn_t
+nvmlDeviceGetMemoryInfo(nvmlDevice_t dev, nvmlMemory_t *memory)
+{
+	++stub_nvml_calls;
+	memory->total = 1000;
+	memory->free = 750;
+	memory->used = 250;
+	(void)dev;
+	return NVML_SUCCESS;
+}
+
+/* 100 W, or 150 W through the average power field. */
+nvmlReturn_t
+nvmlDeviceGetPowerUsage(nvmlDevice_t dev, unsigned int *power)
+{
+	++stub_nvml_calls;
+	*power = 100000;
+	(void)dev;
+	return NVML_SUCCESS;
+}
+
+#	ifdef NVML_FI_DEV_POWER_AVERAGE
+nvmlReturn_t
+nvmlDeviceGetFieldValues(nvmlDevice_t dev, int n, nvmlFieldValue_t *values)
+{
+	++stub_nvml_calls;
+	for (int i = 0; i < n; ++i) {
+		values[i].nvmlReturn = (values[i].fieldId == NVML_FI_DEV_POWER_AVERAGE) ? NVML_SUCCESS : NVML_ERROR_NOT_SUPPORTED;
+		values[i].value.uiVal = 150000;
+	}
+	(void)dev;
+	return NVML_SUCCESS;
+}
+#	endif
+
+#else
+/* ISO C forbids an empty translation unit. */
+typedef int stub_nvml_unused;
+#endif
@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ *
+ * Stand-in for a PulseAudio server with one sink and one source, for
+ * tests/test-edge-cases.c. Built as tests/stubs/stub-pulse.
+ *
+ *   stub-pulse SOCKET
+ *
+ * Serves one client of the native protocol on SOCKET. Lines on stdin of
+ * the form "sink VOL MUTED" or "source VOL MUTED" change the volume in
+ * percent and the mute, and send the client a change event. Exits on EOF
+ * of stdin or of the client.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define HEADER_LEN 20
+#define CHANNEL_CONTROL 0xFFFFFFFFU
+#define VOLUME_NORM 0x10000U
+
+enum {
+	COMMAND_ERROR = 0,
+	COMMAND_REPLY = 2,
+	COMMAND_AUTH = 8,
+	COMMAND_SET_CLIENT_NAME = 9,
+	COMMAND_GET_SINK_INFO = 21,
+	COMMAND_GET_SOURCE_INFO = 23,
+	COMMAND_SUBSCRIBE = 35,
+	COMMAND_SUBSCRIBE_EVENT = 66
+};
+
+#define EVENT_CHANGE 0x0010U
+
+/* The sink is 0 and the source is 1, which is also their facility. */
+static struct {
+	const char *name;
+	unsigned int vol;
+	int muted;
+} devs[2] = { { "stub-sink", 50, 0 }, { "stub-source", 30, 0 } };
+
+static int client = -1;
+static int subscribed;
+static unsigned char in[1 << 16];
+static unsigned int in_len;
+
+static uint32_t
+be32(const unsigned char *p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static unsigned char *
+put_be32(unsigned char *p, uint32_t v)
+{
+	*p++ = (unsigned char)(v >> 24);
+	*p++ = (unsigned char)(v >> 16);
+	*p++ = (unsigned char)(v >> 8);
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+static unsigned char *
+put_u32(unsigned char *p, uint32_t v)
+{
+	*p++ = 'L';
+	return put_be32(p, v);
+}
+
+static unsigned char *
+put_str(unsigned char *p, const char *s)
+{
+	*p++ = 't';
+	const size_t len = strlen(s) + 1;
+	memcpy(p, s, len);
+	return p + len;
+}
+
+static void
+send_packet(unsigned char *pkt, unsigned char *end)
+{
+	unsigned char *p = put_be32(pkt, (uint32_t)(end - pkt - HEADER_LEN));
+	p = put_be32(p, CHANNEL_CONTROL);
+	memset(p, 0, 12);
+	if (write(client, pkt, (size_t)(end - pkt)) != end - pkt)
+		exit(1);
+}
+
+static void
+reply_info(uint32_t tag, unsigned int idx)
+{
+	unsigned char pkt[512];
+	unsigned char *p = put_u32(pkt + HEADER_LEN, COMMAND_REPLY);
+	p = put_u32(p, tag);
+	p = put_u32(p, idx);
+	p = put_str(p, devs[idx].name);
+	p = put_str(p, "Stub device");
+	/* s16le, stereo, 48 kHz. */
+	*p++ = 'a';
+	*p++ = 3;
+	*p++ = 2;
+	p = put_be32(p, 48000);
+	*p++ = 'm';
+	*p++ = 2;
+	*p++ = 1;
+	*p++ = 2;
+	p = put_u32(p, 0);
+	*p++ = 'v';
+	*p++ = 2;
+	const uint32_t vol = devs[idx].vol * VOLUME_NORM / 100;
+	p = put_be32(p, vol);
+	p = put_be32(p, vol);
+	*p++ = devs[idx].muted ? '1' : '0';
+	/* The rest of the info, which clients skip. */
+	p = put_u32(p, 0);
+	p = put_str(p, "stub-monitor");
+	send_packet(pkt, p);
+}
+
+static void
+handle(const unsigned char *p, const unsigned char *end)
+{
+	if (end - p < 10 || p[0] != 'L' || p[5] != 'L')
+		exit(1);
+	const uint32_t command = be32(p + 1);
+	const uint32_t tag = be32(p + 6);
+	unsigned char pkt[64];
+	unsigned char *q = put_u32(pkt + HEADER_LEN, COMMAND_REPLY);
+	q = put_u32(q, tag);
+	switch (command) {
+	case COMMAND_AUTH:
+		q = put_u32(q, 35);
+		break;
+	case COMMAND_SET_CLIENT_NAME:
+		q = put_u32(q, 7);
+		break;
+	case COMMAND_SUBSCRIBE:
+		subscribed = 1;
+		break;
+	case COMMAND_GET_SINK_INFO:
+		reply_info(tag, 0);
+		return;
+	case COMMAND_GET_SOURCE_INFO:
+		reply_info(tag, 1);
+		return;
+	default:
+		q = put_u32(pkt + HEADER_LEN, COMMAND_ERROR);
+		q = put_u32(q, tag);
+		q = put_u32(q, 1);
+		break;
+	}
+	send_packet(pkt, q);
+}
+
+static void
+change(const char *line)
+{
+	char which[16];
+	unsigned int vol;
+	int muted;
+	if (sscanf(line, "%15s %u %d", which, &vol, &muted) != 3)
+		return;
+	const unsigned int idx = strcmp(which, "sink") ? 1 : 0;
+	devs[idx].vol = vol;
+	devs[idx].muted = muted;
+	if (client == -1 || !subscribed)
+		return;
+	unsigned char pkt[64];
+	unsigned char *p = put_u32(pkt + HEADER_LEN, COMMAND_SUBSCRIBE_EVENT);
+	p = put_u32(p, CHANNEL_CONTROL);
+	p = put_u32(p, idx | EVENT_CHANGE);
+	p = put_u32(p, idx);
+	send_packet(pkt, p);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc != 2)
+		return 2;
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	strncpy(addr.sun_path, argv[1], sizeof(addr.sun_path) - 1);
+	const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(argv[1]);
+	if (server == -1 || bind(server, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(server, 1) == -1)
+		return 1;
+	char line[64];
+	unsigned int line_len = 0;
+	for (;;) {
+		struct pollfd pfds[2] = { { .fd = 0, .events = POLLIN }, { .fd = client == -1 ? server : client, .events = POLLIN } };
+		if (poll(pfds, 2, -1) == -1)
+			break;
+		if (pfds[0].revents) {
+			const ssize_t n = read(0, line + line_len, sizeof(line) - 1 - line_len);
+			if (n <= 0)
+				break;
+			line_len += (unsigned int)n;
+			line[line_len] = '\0';
+			char *nl;
+			while ((nl = strchr(line, '\n'))) {
+				*nl = '\0';
+				change(line);
+				line_len -= (unsigned int)(nl + 1 - line);
+				memmove(line, nl + 1, line_len + 1);
+			}
+		}
+		if (!pfds[1].revents)
+			continue;
+		if (client == -1) {
+			client = accept(server, NULL, NULL);
+			continue;
+		}
+		const ssize_t n = read(client, in + in_len, sizeof(in) - in_len);
+		if (n <= 0)
+			break;
+		in_len += (unsigned int)n;
+		unsigned int off = 0;
+		while (in_len - off >= HEADER_LEN && in_len - off - HEADER_LEN >= be32(in + off)) {
+			const uint32_t len = be32(in + off);
+			handle(in + off + HEADER_LEN, in + off + HEADER_LEN + len);
+			off += HEADER_LEN + len;
+		}
+		memmove(in, in + off, in_len - off);
+		in_len -= off;
+	}
+	unlink(argv[1]);
+	return 0;
+}
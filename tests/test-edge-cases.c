@@ -19,13 +19,99 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
+#include <fcntl.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 
 #include "../blocks/procfs.h"
+#include "../blocks/procwatch.h"
+#include "../blocks/hwmon.h"
+#include "../blocks/temp.h"
+#include "../blocks/powercap.h"
+#include "../blocks/cpu.h"
+#include "../blocks/defer.h"
+#include "../blocks/dl.h"
+#include "../blocks/gpu.h"
+#include "../blocks/gpu-drm.h"
+#include "../blocks/audio.h"
+#include "../blocks/shell.h"
+#include "../blocks/cat.h"
+#include "../blocks/fdpool.h"
+#include "../blocks/snapshot.h"
+#include "../dwmblocks-fast.h"
 #include "../utils.h"
 
 /* Satisfy extern reference from block object files. */
 unsigned int g_time;
 
+/* The main loop is not linked, so record watched fds for the tests to
+ * dispatch themselves. */
+static struct {
+	int fd;
+	g_watch_ty func;
+	void *data;
+} test_watches[8];
+static unsigned int test_watches_len;
+static unsigned int test_refreshes;
+
+int
+g_watch_add(int fd, g_watch_ty func, void *data)
+{
+	if (test_watches_len == sizeof(test_watches) / sizeof(test_watches[0]))
+		return -1;
+	test_watches[test_watches_len].fd = fd;
+	test_watches[test_watches_len].func = func;
+	test_watches[test_watches_len].data = data;
+	++test_watches_len;
+	return 0;
+}
+
+void
+g_watch_del(int fd)
+{
+	for (unsigned int i = 0; i < test_watches_len; ++i)
+		if (test_watches[i].fd == fd)
+			test_watches[i] = test_watches[--test_watches_len];
+}
+
+void
+g_refresh(g_func_ty func, const char *arg)
+{
+	++test_refreshes;
+	(void)func;
+	(void)arg;
+}
+
+/* Dispatch watched fds that become readable within timeout_ms. */
+static void
+test_watches_dispatch(int timeout_ms)
+{
+	struct pollfd pfds[8];
+	for (unsigned int i = 0; i < test_watches_len; ++i) {
+		pfds[i].fd = test_watches[i].fd;
+		pfds[i].events = POLLIN;
+	}
+	const unsigned int n = test_watches_len;
+	if (poll(pfds, n, timeout_ms) <= 0)
+		return;
+	/* Like select, a hang up counts as readable. A callback may remove
+	 * other watches, so look each fd up again. */
+	for (unsigned int j = n; j-- > 0;) {
+		if (!(pfds[j].revents & (POLLIN | POLLHUP)))
+			continue;
+		for (unsigned int i = 0; i < test_watches_len; ++i)
+			if (test_watches[i].fd == pfds[j].fd) {
+				if (test_watches[i].func(test_watches[i].fd, test_watches[i].data) == -1)
+					g_watch_del(pfds[j].fd);
+				break;
+			}
+	}
+}
+
 /* Block function prototypes */
 extern char *b_write_date(char *dst, unsigned int dst_size,
                           const char *unused, unsigned short *interval);
@@ -41,9 +127,6 @@ extern char *b_write_disk_usage_percent(char *dst, unsigned int dst_size,
                                         const char *path, unsigned short *interval);
 extern char *b_write_disk_usage_free(char *dst, unsigned int dst_size,
                                      const char *path, unsigned short *interval);
-extern unsigned long long b_cpu_energy_diff(unsigned long long curr,
-                                            unsigned long long last,
-                                            unsigned long long max_range_uj);
 
 static int nfail;
 
@@ -266,16 +349,16 @@ test_u_strtoull10(void)
 static int
 test_cpu_energy_wrap(void)
 {
-	printf("  [edge 8] b_cpu_energy_diff across RAPL wrap            ... ");
+	printf("  [edge 8] b_powercap_energy_diff across RAPL wrap       ... ");
 	const unsigned long long max_range = 262143328850ULL;
 
 	/* normal: counter increased */
-	const unsigned long long d1 = b_cpu_energy_diff(100000150000ULL, 100000000000ULL, max_range);
+	const unsigned long long d1 = b_powercap_energy_diff(100000150000ULL, 100000000000ULL, max_range);
 	CHECK(d1 == 150000ULL, "normal delta wrong");
 
 	/* wrap: last near max, curr just past 0 */
 	const unsigned long long last_wrap = 262143300000ULL;
-	const unsigned long long d2 = b_cpu_energy_diff(30000000ULL, last_wrap, max_range);
+	const unsigned long long d2 = b_powercap_energy_diff(30000000ULL, last_wrap, max_range);
 	CHECK(d2 == 30000000ULL + (max_range - last_wrap), "wrap delta wrong");
 	/* naive u64 subtraction would be 2^64 - last + curr (huge); must stay small */
 	CHECK(d2 < 1000000000ULL, "wrap delta must stay small and positive");
@@ -285,11 +368,11 @@ test_cpu_energy_wrap(void)
 	CHECK(watts >= 0, "power must never be negative");
 
 	/* delta must never exceed the counter range */
-	const unsigned long long d3 = b_cpu_energy_diff(5, max_range - 5, max_range);
+	const unsigned long long d3 = b_powercap_energy_diff(5, max_range - 5, max_range);
 	CHECK(d3 > 0 && d3 <= max_range, "wrap delta must be positive and <= max range");
 
 	/* equal snapshots */
-	CHECK(b_cpu_energy_diff(123, 123, max_range) == 0, "equal values -> 0");
+	CHECK(b_powercap_energy_diff(123, 123, max_range) == 0, "equal values -> 0");
 
 	if (d1 == 150000ULL && d2 == 30000000ULL + (max_range - last_wrap) && watts >= 0)
 		printf("PASS (wrap delta=%llu uJ, %d W)\n", d2, watts);
@@ -298,6 +381,1246 @@ test_cpu_energy_wrap(void)
 	return 0;
 }
 
+/* ------------------------------------------------------------------ */
+/*  Test 9 — procwatch follows a process by name                      */
+/* ------------------------------------------------------------------ */
+
+static char *
+test_dummy_block(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
+{
+	return dst;
+	(void)dst_size;
+	(void)unused;
+	(void)interval;
+}
+
+static int
+test_procwatch(void)
+{
+	printf("  [edge 9] procwatch tracks a named process             ... ");
+	const int nfail_before = nfail;
+	const int id = b_procwatch_add(S_LITERAL("dwmb-test-pw"), test_dummy_block);
+	CHECK(id != -1, "expected a watch id");
+	CHECK(b_procwatch_pid(id) == 0, "no process should match yet");
+	const pid_t pid = fork();
+	if (pid == 0) {
+		prctl(PR_SET_NAME, "dwmb-test-pw");
+		pause();
+		_exit(0);
+	}
+	/* Wait for the rename event, or for the name to show up in /proc.
+	 * Scans are cached per tick, so advance g_time as the main loop does. */
+	unsigned int found = 0;
+	for (int i = 0; i < 50 && found != (unsigned int)pid; ++i) {
+		test_watches_dispatch(20);
+		++g_time;
+		found = b_procwatch_pid(id);
+	}
+	CHECK(found == (unsigned int)pid, "expected the child's pid");
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+	unsigned int gone = found;
+	for (int i = 0; i < 50 && gone != 0; ++i) {
+		test_watches_dispatch(20);
+		++g_time;
+		gone = b_procwatch_pid(id);
+	}
+	CHECK(gone == 0, "expected the pid to be cleared after exit");
+	CHECK(b_procwatch_add(S_LITERAL("dwmb-test-pw"), test_dummy_block) == id, "same name and block share a watch");
+	/* Duplicate names are matched once and all get the pid. */
+	char comm[32];
+	const unsigned int comm_len = b_proc_read_file(comm, sizeof(comm), "/proc/self/comm");
+	if (comm_len != (unsigned int)-1 && comm_len && comm[comm_len - 1] == '\n') {
+		const char *names[3] = { comm, "dwmb-test-none", comm };
+		const unsigned int names_len[3] = { comm_len - 1, S_LEN("dwmb-test-none"), comm_len - 1 };
+		unsigned int pids[3];
+		CHECK(b_proc_exist_many(names, names_len, 3, pids) == 0 && pids[0] && pids[2] == pids[0] && pids[1] == 0, "duplicate names share the pid");
+	}
+	if (nfail == nfail_before)
+		printf("PASS (%s)\n", b_procwatch_evented() ? "events" : "scan");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Test 10 — b_proc_fd_count counts fds by link target               */
+/* ------------------------------------------------------------------ */
+
+static int
+test_proc_fd_count(void)
+{
+	printf("  [edge 10] b_proc_fd_count counts open files           ... ");
+	char path[] = "/tmp/dwmb-test-fd-XXXXXX";
+	const int fd1 = mkstemp(path);
+	CHECK(fd1 != -1, "mkstemp failed");
+	if (fd1 == -1) {
+		printf("FAIL\n");
+		return 0;
+	}
+	const unsigned int one = b_proc_fd_count(path, (unsigned int)strlen(path));
+	const int fd2 = open(path, O_RDONLY);
+	const unsigned int two = b_proc_fd_count(path, (unsigned int)strlen(path));
+	close(fd2);
+	close(fd1);
+	unlink(path);
+	const unsigned int zero = b_proc_fd_count(path, (unsigned int)strlen(path));
+	CHECK(one == 1, "expected one open fd");
+	CHECK(two == 2, "expected two open fds");
+	CHECK(zero == 0, "expected no open fds after close");
+	if (one == 1 && two == 2 && zero == 0)
+		printf("PASS\n");
+	else
+		printf("FAIL (%u, %u, %u)\n", one, two, zero);
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Test 11 — hwmon sensors by chip:label on a fixture sysfs           */
+/* ------------------------------------------------------------------ */
+
+static int
+test_path_endswith(const char *path, const char *suffix)
+{
+	if (path == NULL)
+		return 0;
+	const size_t len = strlen(path);
+	const size_t suffix_len = strlen(suffix);
+	return len >= suffix_len && !strcmp(path + len - suffix_len, suffix);
+}
+
+static int
+test_hwmon(void)
+{
+	printf("  [edge 11] hwmon sensors by chip:label                 ... ");
+	const int nfail_before = nfail;
+	char runtime_dir[] = "/tmp/dwmb-test-run-XXXXXX";
+	CHECK(mkdtemp(runtime_dir) != NULL, "mkdtemp failed");
+	setenv("XDG_RUNTIME_DIR", runtime_dir, 1);
+	setenv("DWMBLOCKS_FAST_SYSFS", "tests/fixtures/sys", 1);
+	/* A cache from before the chips were renumbered: hwmon0 is now nvme,
+	 * and its temp1_input exists. */
+	char cache[256];
+	snprintf(cache, sizeof(cache), "%s/dwmblocks-fast-hwmon", runtime_dir);
+	char boot_id[64];
+	const unsigned int boot_id_sz = b_proc_read_file(boot_id, sizeof(boot_id), "/proc/sys/kernel/random/boot_id");
+	FILE *fp = fopen(cache, "w");
+	if (fp && boot_id_sz != (unsigned int)-1) {
+		fprintf(fp, "%s%s\nk10temp\ttemp1\tTctl\t%s/class/hwmon/hwmon0/temp1_input\n", boot_id, b_sysfs_root(), b_sysfs_root());
+		fclose(fp);
+	}
+	CHECK(test_path_endswith(b_hwmon_path("k10temp:Tctl"), "/hwmon1/temp1_input"), "k10temp:Tctl, not the renumbered cache");
+	CHECK(test_path_endswith(b_hwmon_path("nvme:Sensor 1"), "/hwmon0/temp2_input"), "label with a space");
+	CHECK(test_path_endswith(b_hwmon_path("acpitz:temp1"), "/hwmon2/temp1_input"), "unlabeled sensor");
+	CHECK(test_path_endswith(b_hwmon_path("amdgpu"), "/hwmon10/temp1_input"), "chip without label");
+	/* coretemp is preferred over k10temp. */
+	CHECK(test_path_endswith(b_hwmon_path(NULL), "/hwmon3/temp1_input"), "CPU auto-detection");
+	CHECK(b_hwmon_path("k10temp:nope") == NULL, "unknown label");
+	char buf[16];
+	unsigned short interval = 2;
+	char *end = b_write_temp(buf, sizeof(buf), "k10temp:Tccd1", &interval);
+	CHECK(end && end - buf == 2 && !memcmp(buf, "47", 2), "b_write_temp by spec");
+	/* The index was cached for the next start. */
+	char cache_buf[4096];
+	const unsigned int cache_sz = b_proc_read_file(cache_buf, sizeof(cache_buf), cache);
+	CHECK(cache_sz != (unsigned int)-1 && strstr(cache_buf, "k10temp\ttemp1\tTctl\t"), "expected the index to be cached");
+	unlink(cache);
+	rmdir(runtime_dir);
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Test 12 — max/avg over all coretemp sensors, signed millidegrees  */
+/* ------------------------------------------------------------------ */
+
+static int
+test_temp_agg(void)
+{
+	printf("  [edge 12] temperature max/avg across sensors          ... ");
+	const int nfail_before = nfail;
+	/* Relies on DWMBLOCKS_FAST_SYSFS from test 11. Two coretemp chips:
+	 * 61000 58000 63500 and 55000 -1500 500. */
+	char buf[16];
+	unsigned short interval = 2;
+	char *end = b_write_temp_max(buf, sizeof(buf), "coretemp", &interval);
+	CHECK(end && end - buf == 2 && !memcmp(buf, "63", 2), "max of both sockets");
+	end = b_write_temp_avg(buf, sizeof(buf), NULL, &interval);
+	CHECK(end && end - buf == 2 && !memcmp(buf, "39", 2), "average of the CPU chip");
+	end = b_write_temp(buf, sizeof(buf), "coretemp:Core 2", &interval);
+	CHECK(end && end - buf == 2 && !memcmp(buf, "-1", 2), "negative millidegrees");
+	end = b_write_temp(buf, sizeof(buf), "coretemp:Core 3", &interval);
+	CHECK(end && end - buf == 1 && buf[0] == '0', "below one degree");
+	long t;
+	CHECK(b_temp_parse(S_LITERAL("123456789\n"), &t) == 0 && t == 123456789, "long values");
+	CHECK(b_temp_parse(S_LITERAL("\n"), &t) == -1, "empty value");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Test 13 — RAPL zones from a fixture powercap tree                 */
+/* ------------------------------------------------------------------ */
+
+static int
+test_powercap(void)
+{
+	printf("  [edge 13] powercap enumerates RAPL domains            ... ");
+	const int nfail_before = nfail;
+	/* Relies on DWMBLOCKS_FAST_SYSFS from test 11: two packages, a core
+	 * zone, two dram zones, and an intel-rapl-mmio mirror to skip. */
+	CHECK(b_powercap_sample() == 5, "expected 5 zones");
+	++g_time;
+	CHECK(b_powercap_sample() == 5, "expected 5 zones");
+	/* The counters did not move. */
+	CHECK(b_powercap_watts("package") == 0, "package");
+	CHECK(b_powercap_watts(NULL) == 0, "NULL means package");
+	CHECK(b_powercap_watts("dram") == 0, "dram over both sockets");
+	CHECK(b_powercap_watts("core") == 0, "core");
+	CHECK(b_powercap_watts("psys") < 0, "missing domain");
+	char buf[16];
+	unsigned short interval = 2;
+	char *end = b_write_power(buf, sizeof(buf), "psys", &interval);
+	CHECK(end == buf && interval == (unsigned short)-1, "missing domain stops the block");
+	end = b_write_power(buf, sizeof(buf), "dram", &interval);
+	CHECK(end && end - buf == 1 && buf[0] == '0', "dram watts");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 14 — priming and snapshots of delta-based blocks              */
+/* ------------------------------------------------------------------ */
+
+static int
+test_prime(void)
+{
+	printf("  [edge 14] first samples and their snapshot            ... ");
+	const int nfail_before = nfail;
+	/* Two packages, a core zone, two dram zones, and an intel-rapl-mmio
+	 * mirror to skip. */
+	setenv("DWMBLOCKS_FAST_SYSFS", "tests/fixtures/sys", 1);
+	const int cpu = b_cpu_usage_prime();
+	CHECK(cpu == 0 || cpu == 1, "cpu: first sample");
+	CHECK(b_cpu_usage_prime() == 0, "cpu: already primed");
+	char buf[1024];
+	char *end = b_cpu_usage_save(buf);
+	*end = '\0';
+	CHECK(!strncmp(buf, "cpu ", S_LEN("cpu ")) && end[-1] == '\n', "cpu: saved line");
+	const int rapl = b_powercap_prime();
+	CHECK(rapl == 0 || rapl == 1, "powercap: first sample");
+	CHECK(b_powercap_prime() == 0, "powercap: already primed");
+	end = b_powercap_save(buf);
+	*end = '\0';
+	CHECK(strstr(buf, "rapl intel-rapl:0 100000000000 ") != NULL, "powercap: package-0");
+	CHECK(strstr(buf, "intel-rapl-mmio") == NULL, "powercap: mmio skipped");
+	unsigned int lines = 0;
+	for (const char *p = buf; (p = strchr(p, '\n')); ++p)
+		++lines;
+	CHECK(lines == 5, "powercap: one line per zone");
+	/* Loading onto a primed zone keeps the fresher sample. */
+	b_powercap_load("intel-rapl:0 1 1 1");
+	end = b_powercap_save(buf);
+	*end = '\0';
+	CHECK(strstr(buf, "rapl intel-rapl:0 100000000000 ") != NULL, "powercap: primed zone kept");
+	char dst[16];
+	unsigned short interval = 2;
+	end = b_write_cpu_usage(dst, sizeof(dst), NULL, &interval);
+	CHECK(end != NULL && end > dst, "cpu usage after priming");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 15 — deferred init retries with backoff, or on a helper thread */
+/* ------------------------------------------------------------------ */
+
+static unsigned int test_defer_calls;
+
+/* Succeed on the call number in data. */
+static int
+test_defer_fn(void *data)
+{
+	return (++test_defer_calls < *(unsigned int *)data) ? -1 : 0;
+}
+
+static int
+test_defer(void)
+{
+	printf("  [edge 15] deferred init without blocking the loop      ... ");
+	const int nfail_before = nfail;
+	unsigned short interval;
+	unsigned int need = 3;
+	b_defer_ty sync = B_DEFER_INIT(test_defer_fn, &need, 0);
+	test_defer_calls = 0;
+	CHECK(b_defer_ready(&sync, b_write_time, NULL, &interval) == 0 && interval == 1, "first failure retries in 1 s");
+	CHECK(b_defer_ready(&sync, b_write_time, NULL, &interval) == 0 && test_defer_calls == 1, "no retry while backing off");
+	g_time += 1;
+	CHECK(b_defer_ready(&sync, b_write_time, NULL, &interval) == 0 && interval == 2, "second failure retries in 2 s");
+	g_time += 2;
+	CHECK(b_defer_ready(&sync, b_write_time, NULL, &interval) == 1 && test_defer_calls == 3, "third call succeeds");
+	CHECK(b_defer_ready(&sync, b_write_time, NULL, &interval) == 1 && test_defer_calls == 3, "done once");
+	need = 2;
+	b_defer_ty async = B_DEFER_INIT(test_defer_fn, &need, 1);
+	test_defer_calls = 0;
+	const unsigned int refreshes = test_refreshes;
+	CHECK(b_defer_ready(&async, b_write_time, NULL, &interval) == 0 && interval == (unsigned short)-1, "block stops while the thread runs");
+	/* Other tests' watches may wake the poll first. */
+	for (unsigned int i = 0; i < 100 && test_refreshes == refreshes; ++i)
+		test_watches_dispatch(10);
+	CHECK(test_refreshes == refreshes + 1 && test_defer_calls == 1, "failed thread refreshes the block");
+	CHECK(b_defer_ready(&async, b_write_time, NULL, &interval) == 0 && interval == 1, "failed thread backs off");
+	g_time += 1;
+	CHECK(b_defer_ready(&async, b_write_time, NULL, &interval) == 0 && interval == (unsigned short)-1, "retry on the thread");
+	CHECK(b_defer_ready(&async, b_write_date, NULL, &interval) == 0, "second waiter");
+	for (unsigned int i = 0; i < 100 && test_refreshes == refreshes + 1; ++i)
+		test_watches_dispatch(10);
+	CHECK(test_refreshes == refreshes + 3, "both waiters refreshed");
+	CHECK(b_defer_ready(&async, b_write_time, NULL, &interval) == 1 && test_defer_calls == 2, "thread succeeded");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 16 — optional libraries through dlopen, against a stub         */
+/* ------------------------------------------------------------------ */
+
+static int
+test_dl(void)
+{
+	printf("  [edge 16] dlopen of optional libraries                ... ");
+#ifdef USE_DLOPEN
+	const int nfail_before = nfail;
+	CHECK(b_dl_open("libdwmblocks-absent.so.1") == NULL, "missing library");
+	void *h = b_dl_open("./tests/libdwmblocks-stub.so");
+	CHECK(h != NULL, "stub loads");
+	if (h) {
+#	define b_stub_answer b_stub_answer_v2
+		struct {
+			int (*b_stub_answer)(void);
+			int (*b_stub_absent)(void);
+		} stub = { NULL, NULL };
+		CHECK(B_DL_SYM(h, stub, b_stub_answer) == 0, "versioned symbol");
+		CHECK(stub.b_stub_answer && stub.b_stub_answer() == 42, "call through the table");
+		CHECK(B_DL_SYM(h, stub, b_stub_absent) == -1 && stub.b_stub_absent == NULL, "missing symbol");
+#	undef b_stub_answer
+	}
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (USE_DLOPEN is not defined)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 17 — GPU blocks of one tick share one NVML pass               */
+/* ------------------------------------------------------------------ */
+
+static int
+test_gpu_sample(void)
+{
+	printf("  [edge 17] one NVML query per metric per device per tick ... ");
+#if defined USE_CUDA && defined USE_DLOPEN && !USE_NVSPEED
+	const int nfail_before = nfail;
+	char buf[32];
+	unsigned short interval;
+	/* tests/stubs/libnvidia-ml.so.1, through LD_LIBRARY_PATH. */
+	void *h = b_dl_open("libnvidia-ml.so.1");
+	unsigned int *calls = NULL;
+	if (h == NULL || b_dl_sym(h, "stub_nvml_calls", &calls, sizeof(calls)) == -1) {
+		printf("SKIP (stub NVML not loaded)\n");
+		return 0;
+	}
+	const unsigned int refreshes = test_refreshes;
+	char *p;
+#	ifdef B_GPU_DRM
+	/* The fixture GPUs of test 11 are found while NVML fails. */
+	setenv("DWMBLOCKS_FAST_SYSFS", "tests/fixtures/sys", 1);
+	unsigned int *init_fails = NULL;
+	if (b_dl_sym(h, "stub_nvml_init_fails", &init_fails, sizeof(init_fails)) == 0)
+		*init_fails = 1;
+#	endif
+	CHECK(b_write_gpu_temp(buf, sizeof(buf), NULL, &interval) == buf, "empty while initializing");
+	for (unsigned int i = 0; i < 100 && test_refreshes == refreshes; ++i)
+		test_watches_dispatch(10);
+	CHECK(test_refreshes == refreshes + 1, "init refreshes the block");
+#	ifdef B_GPU_DRM
+	++g_time;
+	interval = 2;
+	p = b_write_gpu_temp(buf, sizeof(buf), "0", &interval);
+	*p = '\0';
+	CHECK(!strcmp(buf, "52") && interval == 2, "DRM GPUs shown while NVML is retried");
+	for (unsigned int i = 0; i < 100 && test_refreshes == refreshes + 1; ++i)
+		test_watches_dispatch(10);
+	CHECK(test_refreshes == refreshes + 2, "NVML retry refreshes the block");
+	/* NVML GPUs come first again. */
+	p = b_write_gpu_temp(buf, sizeof(buf), "0", &interval);
+	*p = '\0';
+	CHECK(!strcmp(buf, "40"), "NVML GPUs after the retry");
+#	endif
+	for (unsigned int round = 0; round < 2; ++round) {
+		++g_time;
+		unsigned int before = *calls;
+		p = b_write_gpu_temp(buf, sizeof(buf), NULL, &interval);
+		*p = '\0';
+#	ifndef B_GPU_DRM
+		/* Otherwise, the fixture GPUs of test 11 are averaged in. */
+		CHECK(!strcmp(buf, "40"), "average temperature");
+#	endif
+		p = b_write_gpu_usage(buf, sizeof(buf), NULL, &interval);
+		*p = '\0';
+#	ifndef B_GPU_DRM
+		CHECK(!strcmp(buf, "15"), "average usage");
+#	endif
+		p = b_write_gpu_usage_vram(buf, sizeof(buf), NULL, &interval);
+		*p = '\0';
+#	ifndef B_GPU_DRM
+		CHECK(!strcmp(buf, "25"), "average vram");
+#	endif
+		p = b_write_gpu_usage_power(buf, sizeof(buf), NULL, &interval);
+		*p = '\0';
+#	ifndef B_GPU_DRM
+		CHECK(!strcmp(buf, "300"), "total average power");
+#	endif
+		CHECK(*calls - before == 4 * 2, "one query per metric per device");
+		before = *calls;
+		b_write_gpu_temp(buf, sizeof(buf), NULL, &interval);
+		b_write_gpu_usage(buf, sizeof(buf), NULL, &interval);
+		b_write_gpu_usage_vram(buf, sizeof(buf), NULL, &interval);
+		b_write_gpu_usage_power(buf, sizeof(buf), NULL, &interval);
+		CHECK(*calls == before, "no queries for the rest of the tick");
+	}
+	/* NVML GPUs come first, before those of the fixture sysfs. */
+	p = b_write_gpu_temp(buf, sizeof(buf), "GPU-stub-1", &interval);
+	*p = '\0';
+	CHECK(!strcmp(buf, "41"), "GPU by UUID");
+	p = b_write_gpu_usage(buf, sizeof(buf), "0", &interval);
+	*p = '\0';
+	CHECK(!strcmp(buf, "10"), "GPU by index");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (needs USE_CUDA and USE_DLOPEN without USE_NVSPEED)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 18 — DRM GPUs on a fixture sysfs, and their fdinfo            */
+/* ------------------------------------------------------------------ */
+
+static int
+test_gpu_drm(void)
+{
+	printf("  [edge 18] DRM GPUs from sysfs and fdinfo              ... ");
+#ifdef B_GPU_DRM
+	const int nfail_before = nfail;
+	static const char fdinfo[] = "pos:\t0\n"
+	                             "flags:\t02100002\n"
+	                             "drm-driver:\ti915\n"
+	                             "drm-client-id:\t42\n"
+	                             "drm-pdev:\t0000:00:02.0\n"
+	                             "drm-total-system:\t0\n"
+	                             "drm-engine-render:\t25662044495 ns\n"
+	                             "drm-engine-copy:\t0 ns\n"
+	                             "drm-engine-video:\t1000 ns\n"
+	                             "drm-engine-capacity-video:\t2\n";
+	b_gpu_drm_client_ty client;
+	CHECK(b_gpu_drm_fdinfo_parse(fdinfo, sizeof(fdinfo) - 1, &client) == 0, "DRM fdinfo");
+	CHECK(client.client_id == 42 && !strcmp(client.pdev, "0000:00:02.0"), "client and device");
+	CHECK(client.engines_len == 3, "engines, not their capacity");
+	CHECK(!strcmp(client.engines[0].name, "render") && client.engines[0].ns == 25662044495ULL, "render busy time");
+	CHECK(!strcmp(client.engines[2].name, "video") && client.engines[2].ns == 1000 && client.engines[2].capacity == 2, "video capacity");
+	CHECK(b_gpu_drm_fdinfo_parse(S_LITERAL("pos:\t0\nflags:\t02\n"), &client) == -1, "not a DRM fd");
+	/* Relies on DWMBLOCKS_FAST_SYSFS from test 11: an amdgpu, an
+	 * integrated Intel GPU with nothing in sysfs, an Nvidia GPU read
+	 * through NVML and a discrete Intel GPU with only its energy. */
+	b_gpu_dev_ty devs[B_GPU_MAX];
+	memset(devs, 0, sizeof(devs));
+	const int n = b_gpu_drm.init(devs, B_GPU_MAX);
+	CHECK(n == 2 + USE_GPU_DRM_FDINFO, "cards read through DRM");
+	if (n > 0) {
+		for (int i = 0; i < n; ++i)
+			devs[i].needed = (unsigned int)-1;
+		b_gpu_drm.sample(devs, B_GPU_BIT(B_GPU_MON_TEMP) | B_GPU_BIT(B_GPU_MON_VRAM) | B_GPU_BIT(B_GPU_MON_POWER_USAGE));
+		CHECK(!strcmp(devs[0].id, "0000:03:00.0") && !strcmp(devs[n - 1].id, "0000:04:00.0"), "PCI slots as ids");
+		CHECK(devs[0].temp == 52 && devs[0].vram == 25 && devs[0].power == 45, "amdgpu sensors");
+		CHECK(devs[n - 1].temp == 0 && devs[n - 1].vram == 0 && devs[n - 1].power == 0, "no power before the second energy sample");
+		b_gpu_drm.sample(devs, B_GPU_BIT(B_GPU_MON_USAGE));
+		CHECK(devs[0].usage == 37, "amdgpu gpu_busy_percent");
+	}
+#	ifndef USE_CUDA
+	/* The blocks, with the fixture GPUs alone. */
+	char buf[32];
+	unsigned short interval;
+	const unsigned int refreshes = test_refreshes;
+	b_write_gpu_temp(buf, sizeof(buf), NULL, &interval);
+	for (unsigned int i = 0; i < 100 && test_refreshes == refreshes; ++i)
+		test_watches_dispatch(10);
+	++g_time;
+	/* Only the amdgpu has a temperature and VRAM. */
+	*b_write_gpu_temp(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, "52"), "average temperature");
+	*b_write_gpu_usage_vram(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, "25"), "average vram");
+	*b_write_gpu_usage_power(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, "45"), "total power");
+	CHECK(n > 0 && devs[0].has == (unsigned int)(B_GPU_BIT(B_GPU_MON_TEMP) | B_GPU_BIT(B_GPU_MON_USAGE) | B_GPU_BIT(B_GPU_MON_VRAM) | B_GPU_BIT(B_GPU_MON_POWER_USAGE)), "amdgpu metrics");
+	CHECK(n > 0 && devs[n - 1].has == B_GPU_BIT(B_GPU_MON_POWER_USAGE), "energy only");
+#	endif
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (USE_GPU_DRM is not defined)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 19 — GPU selection by arg                                     */
+/* ------------------------------------------------------------------ */
+
+static int
+test_gpu_sel(void)
+{
+	printf("  [edge 19] GPU blocks select GPUs by arg               ... ");
+#if defined B_GPU_DRM && !defined USE_CUDA && !USE_NVSPEED
+	const int nfail_before = nfail;
+	char buf[32];
+	unsigned short interval;
+	/* Relies on the fixture GPUs of test 18: the amdgpu at 0000:03:00.0,
+	 * and an idle Intel GPU at 0000:04:00.0. */
+	const unsigned int refreshes = test_refreshes;
+	if (b_write_gpu_temp(buf, sizeof(buf), "0", &interval) == buf)
+		for (unsigned int i = 0; i < 100 && test_refreshes == refreshes; ++i)
+			test_watches_dispatch(10);
+	++g_time;
+	*b_write_gpu_temp(buf, sizeof(buf), "0", &interval) = '\0';
+	CHECK(!strcmp(buf, "52"), "by index");
+	*b_write_gpu_temp(buf, sizeof(buf), "max", &interval) = '\0';
+	CHECK(!strcmp(buf, "52"), "hottest");
+	/* The GPUs without a temperature sensor are left out. */
+	*b_write_gpu_temp(buf, sizeof(buf), "all", &interval) = '\0';
+	CHECK(!strcmp(buf, "52"), "every GPU");
+	*b_write_gpu_usage_power(buf, sizeof(buf), "all", &interval) = '\0';
+	CHECK(!strcmp(buf, "45" GPU_ALL_SEP "0"), "power of every GPU");
+	*b_write_gpu_usage_power(buf, sizeof(buf), "max", &interval) = '\0';
+	CHECK(!strcmp(buf, "45"), "most power");
+	*b_write_gpu_usage_vram(buf, sizeof(buf), "0000:03:00.0", &interval) = '\0';
+	CHECK(!strcmp(buf, "25"), "by PCI slot");
+	*b_write_gpu_usage_power(buf, sizeof(buf), "0000:04", &interval) = '\0';
+	CHECK(!strcmp(buf, "0"), "by prefix");
+	interval = 2;
+	CHECK(b_write_gpu_temp(buf, sizeof(buf), "0000:04", &interval) == buf && interval == (unsigned short)-1, "no such metric");
+	interval = 2;
+	CHECK(b_write_gpu_temp(buf, sizeof(buf), "9", &interval) == buf && interval == (unsigned short)-1, "no such index");
+	interval = 2;
+	CHECK(b_write_gpu_temp(buf, sizeof(buf), "GPU-absent", &interval) == buf && interval == (unsigned short)-1, "no such id");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (needs USE_GPU_DRM without USE_CUDA)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 20 — volume changes refresh the block through the mixer fds   */
+/* ------------------------------------------------------------------ */
+
+static int
+test_alsa_watch(void)
+{
+	printf("  [edge 20] mixer events refresh the volume block       ... ");
+#if defined USE_ALSA && defined USE_DLOPEN && !USE_PULSE
+	const int nfail_before = nfail;
+	char buf[32];
+	unsigned short interval;
+	/* tests/stubs/libasound.so.2, through LD_LIBRARY_PATH. */
+	void *h = b_dl_open("libasound.so.2");
+	void (*set)(const char *, long, int) = NULL;
+	if (h == NULL || b_dl_sym(h, "stub_alsa_set", &set, sizeof(set)) == -1) {
+		printf("SKIP (stub ALSA not loaded)\n");
+		return 0;
+	}
+	unsigned int refreshes = test_refreshes;
+	CHECK(b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf, "empty while opening");
+	for (unsigned int i = 0; i < 100 && test_refreshes == refreshes; ++i)
+		test_watches_dispatch(10);
+	CHECK(test_refreshes == refreshes + 1, "open refreshes the block");
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_SPEAKER_ON " 50"), "initial volume");
+	/* Another application changes the volume. */
+	refreshes = test_refreshes;
+	set("Master", 70, 1);
+	test_watches_dispatch(100);
+	CHECK(test_refreshes == refreshes + 1, "volume change refreshes the block");
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_SPEAKER_ON " 70"), "new volume");
+	refreshes = test_refreshes;
+	set("Master", 70, 0);
+	test_watches_dispatch(100);
+	CHECK(test_refreshes == refreshes + 1, "mute refreshes the block");
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_SPEAKER_OFF " 70"), "muted");
+	/* Nothing changed. */
+	refreshes = test_refreshes;
+	test_watches_dispatch(10);
+	CHECK(test_refreshes == refreshes, "no refresh without events");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (needs USE_ALSA and USE_DLOPEN without USE_PULSE)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 21 — speaker and mic share the mixer of their card            */
+/* ------------------------------------------------------------------ */
+
+static int
+test_alsa_shared(void)
+{
+	printf("  [edge 21] one mixer and event pass for every element  ... ");
+#if defined USE_ALSA && defined USE_DLOPEN && !USE_PULSE
+	const int nfail_before = nfail;
+	char buf[32];
+	unsigned short interval;
+	void *h = b_dl_open("libasound.so.2");
+	void (*set)(const char *, long, int) = NULL;
+	unsigned int *opens = NULL, *events = NULL;
+	if (h == NULL || b_dl_sym(h, "stub_alsa_set", &set, sizeof(set)) == -1
+	    || b_dl_sym(h, "stub_alsa_opens", &opens, sizeof(opens)) == -1
+	    || b_dl_sym(h, "stub_alsa_events", &events, sizeof(events)) == -1) {
+		printf("SKIP (stub ALSA not loaded)\n");
+		return 0;
+	}
+	/* The mixer opened by test 20 for the speaker. */
+	const unsigned int opens_before = *opens;
+	*b_write_mic_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_MIC_ON " 30"), "mic without opening a mixer");
+	CHECK(*opens == opens_before, "no second mixer");
+	unsigned int refreshes = test_refreshes;
+	unsigned int events_before = *events;
+	set("Master", 20, 1);
+	set("Capture", 40, 0);
+	test_watches_dispatch(100);
+	CHECK(*events - events_before == 1, "one event pass for both elements");
+	CHECK(test_refreshes == refreshes + 2, "both blocks refreshed");
+	events_before = *events;
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_SPEAKER_ON " 20"), "speaker volume");
+	*b_write_mic_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_MIC_OFF " 40"), "mic volume and mute");
+	CHECK(*events == events_before, "reads do not handle events");
+	refreshes = test_refreshes;
+	set("Capture", 45, 0);
+	test_watches_dispatch(100);
+	CHECK(test_refreshes == refreshes + 1, "only the changed block refreshed");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (needs USE_ALSA and USE_DLOPEN without USE_PULSE)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 22 — PulseAudio backend against a stand-in server            */
+/* ------------------------------------------------------------------ */
+
+/* Wait for the next refresh, e.g., of a deferred init or a server event. */
+static ATTR_MAYBE_UNUSED int
+test_wait_refresh(void)
+{
+	const unsigned int refreshes = test_refreshes;
+	for (unsigned int i = 0; i < 100 && test_refreshes == refreshes; ++i)
+		test_watches_dispatch(10);
+	return test_refreshes != refreshes;
+}
+
+static int
+test_pulse(void)
+{
+	printf("  [edge 22] volume from PulseAudio events               ... ");
+#if USE_PULSE
+	const int nfail_before = nfail;
+	char buf[32];
+	unsigned short interval;
+	char path[64], server[80];
+	snprintf(path, sizeof(path), "/tmp/dwmblocks-fast-test-pulse-%d", (int)getpid());
+	snprintf(server, sizeof(server), "unix:%s", path);
+	setenv("PULSE_SERVER", server, 1);
+	int ctl[2];
+	if (pipe(ctl) == -1) {
+		printf("SKIP (pipe failed)\n");
+		return 0;
+	}
+	const pid_t pid = fork();
+	if (pid == 0) {
+		dup2(ctl[0], 0);
+		close(ctl[1]);
+		execl("tests/stubs/stub-pulse", "stub-pulse", path, (char *)NULL);
+		_exit(127);
+	}
+	close(ctl[0]);
+	for (unsigned int i = 0; i < 100 && access(path, F_OK) == -1; ++i)
+		usleep(10000);
+	CHECK(b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf, "empty while connecting");
+	CHECK(test_wait_refresh(), "connect refreshes the block");
+	CHECK(b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf && interval == (unsigned short)-1, "empty until the volume arrives");
+	CHECK(test_wait_refresh(), "the volume refreshes the block");
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_SPEAKER_ON " 50"), "speaker volume");
+	/* Queried along with the speaker, but may be read after it. */
+	for (unsigned int i = 0; i < 3 && b_write_mic_vol(buf, sizeof(buf), NULL, &interval) == buf; ++i)
+		test_wait_refresh();
+	*b_write_mic_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_MIC_ON " 30"), "mic volume");
+	/* Another application changes the volume. */
+	if (write(ctl[1], "sink 70 1\n", S_LEN("sink 70 1\n")) == -1)
+		++nfail;
+	CHECK(test_wait_refresh(), "change event refreshes the block");
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(!strcmp(buf, ICON_AUDIO_SPEAKER_OFF " 70"), "new volume and mute");
+	/* The server exits. */
+	close(ctl[1]);
+	waitpid(pid, NULL, 0);
+	CHECK(test_wait_refresh(), "disconnect refreshes the block");
+	CHECK(b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf, "empty while reconnecting");
+	/* Join the failed reconnect. */
+	test_wait_refresh();
+	unsetenv("PULSE_SERVER");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (USE_PULSE is 0)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 23 — shell blocks with and without the shell                  */
+/* ------------------------------------------------------------------ */
+
+static int
+test_shell_spawn(void)
+{
+	printf("  [edge 23] shell blocks spawn directly or through sh   ... ");
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+	const int nfail_before = nfail;
+	char buf[32];
+	unsigned short interval;
+	static const char direct[] = "echo  direct   exec";
+#	if defined HAVE_POSIX_SPAWN
+	b_shell_init(direct);
+#	endif
+	*b_write_shell(buf, sizeof(buf), direct, &interval) = '\0';
+	CHECK(!strcmp(buf, "direct exec"), "words without the shell");
+	*b_write_shell(buf, sizeof(buf), "echo piped | tr d D", &interval) = '\0';
+	CHECK(!strcmp(buf, "pipeD"), "pipe through the shell");
+	*b_write_shell(buf, sizeof(buf), "printf 'one\\ntwo\\n'", &interval) = '\0';
+	CHECK(!strcmp(buf, "one"), "first line only");
+	*b_write_shell(buf, sizeof(buf), "seq 100", &interval) = '\0';
+	CHECK(!strcmp(buf, "1"), "first line of a long output");
+	/* Run again, from the same words. */
+	*b_write_shell(buf, sizeof(buf), direct, &interval) = '\0';
+	CHECK(!strcmp(buf, "direct exec"), "second run");
+	CHECK(b_write_shell(buf, sizeof(buf), "dwmblocks-fast-absent-command", &interval) == buf, "missing command renders empty");
+	/* Plain words, but only the shell runs them. */
+	static const char exec_cmd[] = "exec echo hi";
+	static const char umask_cmd[] = "umask";
+#	if defined HAVE_POSIX_SPAWN
+	b_shell_init(exec_cmd);
+	b_shell_init(umask_cmd);
+#	endif
+	*b_write_shell(buf, sizeof(buf), exec_cmd, &interval) = '\0';
+	CHECK(!strcmp(buf, "hi"), "exec through the shell");
+	*b_write_shell(buf, sizeof(buf), umask_cmd, &interval) = '\0';
+	CHECK(strlen(buf) == 4 && buf[0] == '0', "umask through the shell");
+#	if defined HAVE_POSIX_SPAWN
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	CHECK(b_write_shell(buf, sizeof(buf), "sleep 10", &interval) == buf, "hung command renders empty");
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	CHECK(end.tv_sec - start.tv_sec < SHELL_TIMEOUT_MS / 1000 + 2, "hung command is killed");
+	/* Hung after its line. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	*b_write_shell(buf, sizeof(buf), "echo hi; sleep 10", &interval) = '\0';
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	CHECK(!strcmp(buf, "hi"), "line of a command that does not exit");
+	CHECK(end.tv_sec - start.tv_sec < SHELL_TIMEOUT_MS / 1000 + 2, "command that does not exit is killed");
+#	endif
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (no popen)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 24 — persistent scripts update per line and are restarted    */
+/* ------------------------------------------------------------------ */
+
+static int
+test_shell_persist(void)
+{
+	printf("  [edge 24] persistent script, per line and restarted   ... ");
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO && defined HAVE_POSIX_SPAWN
+	const int nfail_before = nfail;
+	/* Blocks are found by the pointer of their arg. */
+	static const char *const cmd = "printf fir; sleep 0.1; echo st; sleep 0.1; echo second; sleep 0.1";
+	char buf[32];
+	unsigned short interval = 0;
+	CHECK(b_write_shell_persist(buf, sizeof(buf), cmd, &interval) == buf && interval == (unsigned short)-1, "started, empty until a line");
+	CHECK(test_wait_refresh(), "a line refreshes the block");
+	*b_write_shell_persist(buf, sizeof(buf), cmd, &interval) = '\0';
+	CHECK(!strcmp(buf, "first"), "line split over two writes");
+	CHECK(test_wait_refresh(), "the next line refreshes the block");
+	*b_write_shell_persist(buf, sizeof(buf), cmd, &interval) = '\0';
+	CHECK(!strcmp(buf, "second"), "next line");
+	CHECK(test_wait_refresh(), "exit refreshes the block");
+	*b_write_shell_persist(buf, sizeof(buf), cmd, &interval) = '\0';
+	CHECK(!strcmp(buf, "second") && interval == 1, "last line kept while backing off");
+	++g_time;
+	*b_write_shell_persist(buf, sizeof(buf), cmd, &interval) = '\0';
+	CHECK(interval == (unsigned short)-1, "restarted");
+	CHECK(test_wait_refresh() && test_wait_refresh() && test_wait_refresh(), "restarted script runs to its exit");
+	*b_write_shell_persist(buf, sizeof(buf), cmd, &interval) = '\0';
+	CHECK(interval == 2, "backoff doubles when it keeps dying");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (no posix_spawn)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 25 — one command for a group of blocks                       */
+/* ------------------------------------------------------------------ */
+
+static int
+test_shell_fields(void)
+{
+	printf("  [edge 25] shell fields read past one block            ... ");
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+	const int nfail_before = nfail;
+	/* The main loop gives room for every field. */
+	char buf[256];
+	unsigned short interval;
+	*b_write_shell_fields(buf, sizeof(buf), "echo '12345678901234567890123456789012|second|third'", &interval) = '\0';
+	CHECK(!strcmp(buf, "12345678901234567890123456789012|second|third"), "whole line");
+	CHECK(b_write_shell_field(buf, sizeof(buf), NULL, &interval) == buf && *buf == '\0', "a field alone is empty");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (no popen)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 26 — cat blocks read again on inotify events only            */
+/* ------------------------------------------------------------------ */
+
+static int
+test_cat_watch(void)
+{
+	printf("  [edge 26] cat block follows writes and renames        ... ");
+#ifdef HAVE_INOTIFY
+	const int nfail_before = nfail;
+	char dir[64], file[80], tmp[80];
+	snprintf(dir, sizeof(dir), "/tmp/dwmblocks-fast-test-cat-%d", (int)getpid());
+	snprintf(file, sizeof(file), "%s/status", dir);
+	snprintf(tmp, sizeof(tmp), "%s/status.tmp", dir);
+	if (mkdir(dir, 0700) == -1) {
+		printf("SKIP (mkdir failed)\n");
+		return 0;
+	}
+	char buf[32];
+	unsigned short interval = 0;
+	CHECK(b_write_cat_watch(buf, sizeof(buf), file, &interval) == buf && interval == (unsigned short)-1, "absent file is empty and watched");
+	/* Written in place. */
+	FILE *fp = fopen(file, "w");
+	if (fp) {
+		fputs("first\n", fp);
+		fclose(fp);
+	}
+	CHECK(test_wait_refresh(), "close after write refreshes the block");
+	*b_write_cat_watch(buf, sizeof(buf), file, &interval) = '\0';
+	CHECK(!strcmp(buf, "first"), "written file");
+	/* Replaced by a rename. */
+	fp = fopen(tmp, "w");
+	if (fp) {
+		fputs("second\n", fp);
+		fclose(fp);
+	}
+	const unsigned int refreshes = test_refreshes;
+	CHECK(rename(tmp, file) == 0 && test_wait_refresh(), "rename refreshes the block");
+	*b_write_cat_watch(buf, sizeof(buf), file, &interval) = '\0';
+	CHECK(!strcmp(buf, "second"), "renamed file");
+	/* Not for the close of the temporary file. */
+	CHECK(test_refreshes - refreshes == 1, "other files are ignored");
+	unlink(file);
+	CHECK(test_wait_refresh(), "removal refreshes the block");
+	CHECK(b_write_cat_watch(buf, sizeof(buf), file, &interval) == buf, "removed file is empty");
+	rmdir(dir);
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (no inotify)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 27 — io_uring prefetch of the files of due blocks            */
+/* ------------------------------------------------------------------ */
+
+static int
+test_fdpool_prefetch(void)
+{
+	printf("  [edge 27] io_uring prefetch is used once per tick     ... ");
+#if USE_IO_URING && defined HAVE_IO_URING
+	const int nfail_before = nfail;
+	static char path_block[] = "/tmp/dwmb-test-pre-XXXXXX";
+	static char path_other[] = "/tmp/dwmb-test-pre-XXXXXX";
+	const int fd_block = mkstemp(path_block);
+	const int fd_other = mkstemp(path_other);
+	if (fd_block == -1 || fd_other == -1) {
+		printf("SKIP (mkstemp failed)\n");
+		return 0;
+	}
+	char buf[16];
+	if (pwrite(fd_block, "abc", 3, 0) != 3 || pwrite(fd_other, "abc", 3, 0) != 3)
+		++nfail;
+	/* Learn which block reads which file. */
+	b_fdpool_block = 5;
+	CHECK(b_fdpool_read(buf, sizeof(buf), path_block) == 3, "read by block 5");
+	/* As reset by the main loop after the block ran. */
+	b_fdpool_block = (unsigned int)-1;
+	CHECK(b_fdpool_read(buf, sizeof(buf), path_other) == 3, "read outside of a block");
+	++g_time;
+	b_fdpool_prefetch(~0ULL);
+	/* Changed after the prefetch. */
+	if (pwrite(fd_block, "xyz", 3, 0) != 3 || pwrite(fd_other, "xyz", 3, 0) != 3)
+		++nfail;
+	CHECK(b_fdpool_read(buf, sizeof(buf), path_block) == 3 && !strcmp(buf, "abc"), "prefetched data of the block");
+	CHECK(b_fdpool_read(buf, sizeof(buf), path_block) == 3 && !strcmp(buf, "xyz"), "prefetched data is used once");
+	CHECK(b_fdpool_read(buf, sizeof(buf), path_other) == 3 && !strcmp(buf, "xyz"), "files read outside of a block are not prefetched");
+	/* Not due. */
+	++g_time;
+	b_fdpool_prefetch(1ULL << 4);
+	if (pwrite(fd_block, "123", 3, 0) != 3)
+		++nfail;
+	CHECK(b_fdpool_read(buf, sizeof(buf), path_block) == 3 && !strcmp(buf, "123"), "blocks not due are not prefetched");
+	close(fd_block);
+	close(fd_other);
+	unlink(path_block);
+	unlink(path_other);
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (USE_IO_URING is 0)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 28 — snapshot of delta-based blocks across a restart          */
+/* ------------------------------------------------------------------ */
+
+static int
+test_snapshot_put(const char *path, const char *boot_id, unsigned long long time, const char *lines)
+{
+	FILE *fp = fopen(path, "w");
+	if (fp == NULL)
+		return -1;
+	fprintf(fp, "%stime %llu\n%s", boot_id, time, lines);
+	return fclose(fp);
+}
+
+static int
+test_snapshot(void)
+{
+	printf("  [edge 28] snapshot is saved, checked, and used once   ... ");
+	const int nfail_before = nfail;
+	char dir[] = "/tmp/dwmb-test-snap-XXXXXX";
+	char boot_id[64];
+	const unsigned int boot_id_len = b_proc_read_file(boot_id, sizeof(boot_id), "/proc/sys/kernel/random/boot_id");
+	struct timespec now;
+	if (mkdtemp(dir) == NULL || boot_id_len == (unsigned int)-1 || boot_id_len == 0 || clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+		printf("SKIP (no tmp dir or boot_id)\n");
+		return 0;
+	}
+	char path[sizeof(dir) + S_LEN(B_SNAPSHOT_NAME)];
+	u_stpcpy_len(u_stpcpy(path, dir), S_LITERAL(B_SNAPSHOT_NAME));
+	/* The text after "cpu " is checked even if a sample was taken. */
+	b_cpu_usage_prime();
+	CHECK(b_cpu_usage_load("100 50\n") == 1, "cpu: primed sample kept");
+	CHECK(b_cpu_usage_load("100 50") == 1, "cpu: last line");
+	CHECK(b_cpu_usage_load("50 100\n") == -1, "cpu: more busy than total");
+	CHECK(b_cpu_usage_load("100\n") == -1, "cpu: one field");
+	CHECK(b_cpu_usage_load("100 50 7\n") == -1, "cpu: three fields");
+	CHECK(b_cpu_usage_load("x 50\n") == -1, "cpu: not a number");
+	CHECK(b_cpu_usage_load(" 50\n") == -1, "cpu: empty field");
+	/* Without $XDG_RUNTIME_DIR. */
+	CHECK(b_snapshot_init(NULL) == -1 && b_snapshot_read() == -1, "no dir");
+	CHECK(b_snapshot_init("") == -1 && b_snapshot_read() == -1, "empty dir");
+	CHECK(b_snapshot_init(dir) == 0, "init");
+	CHECK(b_snapshot_read() == -1, "missing");
+	/* Roundtrip of the samples taken by test 14, or here. */
+	setenv("DWMBLOCKS_FAST_SYSFS", "tests/fixtures/sys", 1);
+	b_powercap_prime();
+	char before[1024];
+	*b_powercap_save(b_cpu_usage_save(before)) = '\0';
+	b_snapshot_write();
+	char buf[4096];
+	const unsigned int len = b_proc_read_file(buf, sizeof(buf), path);
+	CHECK(len != (unsigned int)-1 && len > boot_id_len && !memcmp(buf, boot_id, boot_id_len), "written with the boot_id");
+	CHECK(len != (unsigned int)-1 && !strncmp(buf + boot_id_len, "time ", S_LEN("time ")), "written with the time");
+	CHECK(len != (unsigned int)-1 && strstr(buf, before) != NULL, "written with the samples");
+	CHECK(b_snapshot_read() == 6, "cpu and 5 zones");
+	CHECK(access(path, F_OK) == -1, "used once");
+	char after[1024];
+	*b_powercap_save(b_cpu_usage_save(after)) = '\0';
+	CHECK(!strcmp(before, after), "primed samples kept");
+	/* Rejected as a whole. */
+	CHECK(test_snapshot_put(path, "00000000-0000-0000-0000-000000000000\n", (unsigned long long)now.tv_sec, "cpu 100 50\n") == 0, "put");
+	CHECK(b_snapshot_read() == -1 && access(path, F_OK) == -1, "other boot");
+	if (now.tv_sec > B_SNAPSHOT_AGE_MAX) {
+		CHECK(test_snapshot_put(path, boot_id, (unsigned long long)(now.tv_sec - B_SNAPSHOT_AGE_MAX - 1), "cpu 100 50\n") == 0, "put");
+		CHECK(b_snapshot_read() == -1 && access(path, F_OK) == -1, "too old");
+	}
+	CHECK(test_snapshot_put(path, boot_id, (unsigned long long)now.tv_sec + 3600, "cpu 100 50\n") == 0, "put");
+	CHECK(b_snapshot_read() == -1, "from the future");
+	/* Malformed lines are skipped. */
+	CHECK(test_snapshot_put(path, boot_id, (unsigned long long)now.tv_sec, "cpu 50 100\nfoo 1\ncpu 100 50\n") == 0, "put");
+	CHECK(b_snapshot_read() == 1, "one good line");
+	unlink(path);
+	rmdir(dir);
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 29 — blocks that waited on a deferred init tick again         */
+/* ------------------------------------------------------------------ */
+
+static b_defer_ty test_waiter_defer;
+
+static char *
+test_waiter_block(char *dst, unsigned int dst_size, const char *arg, unsigned short *interval)
+{
+	if (!b_defer_ready(&test_waiter_defer, test_waiter_block, arg, interval))
+		return dst;
+	*dst++ = 'x';
+	return dst;
+	(void)dst_size;
+}
+
+static int
+test_defer_waiters(void)
+{
+	printf("  [edge 29] deferred waiters tick again after the init  ... ");
+	const int nfail_before = nfail;
+	unsigned int need = 1;
+	test_waiter_defer = (b_defer_ty)B_DEFER_INIT(test_defer_fn, &need, 1);
+	test_defer_calls = 0;
+	/* Two blocks with the same function and arg, as B_SLEEP(i) of each. */
+	unsigned short sleep_a = 1, sleep_b = 1;
+	char buf[4];
+	CHECK(test_waiter_block(buf, sizeof(buf), NULL, &sleep_a) == buf && sleep_a == (unsigned short)-1, "first block stops");
+	CHECK(test_waiter_block(buf, sizeof(buf), NULL, &sleep_b) == buf && sleep_b == (unsigned short)-1, "second block stops");
+	CHECK(test_waiter_defer.waiters_len == 2, "one waiter per block");
+	const unsigned int refreshes = test_refreshes;
+	/* Watches of other tests may refresh their blocks too. */
+	for (unsigned int i = 0; i < 100 && test_waiter_defer.state != B_DEFER_DONE; ++i)
+		test_watches_dispatch(10);
+	CHECK(test_waiter_defer.state == B_DEFER_DONE && test_refreshes >= refreshes + 2, "both blocks refreshed");
+	/* What the refresh runs leaves the interval alone. */
+	CHECK(test_waiter_block(buf, sizeof(buf), NULL, &sleep_a) == buf + 1 && sleep_a == 0, "first block due on the next tick");
+	CHECK(test_waiter_block(buf, sizeof(buf), NULL, &sleep_b) == buf + 1 && sleep_b == 0, "second block due on the next tick");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 30 — an unplugged card is no longer watched, then reopened    */
+/* ------------------------------------------------------------------ */
+
+#if defined USE_ALSA && defined USE_DLOPEN && !USE_PULSE
+static int
+test_watched(int fd)
+{
+	for (unsigned int i = 0; i < test_watches_len; ++i)
+		if (test_watches[i].fd == fd)
+			return 1;
+	return 0;
+}
+
+#endif
+
+static int
+test_alsa_unplug(void)
+{
+	printf("  [edge 30] unplugged card stops its watches and reopens ... ");
+#if defined USE_ALSA && defined USE_DLOPEN && !USE_PULSE
+	const int nfail_before = nfail;
+	char buf[32];
+	unsigned short interval;
+	void *h = b_dl_open("libasound.so.2");
+	void (*unplug)(int) = NULL;
+	int (*mixer_fd)(void) = NULL;
+	unsigned int *events = NULL;
+	if (h == NULL || b_dl_sym(h, "stub_alsa_unplug", &unplug, sizeof(unplug)) == -1
+	    || b_dl_sym(h, "stub_alsa_fd", &mixer_fd, sizeof(mixer_fd)) == -1
+	    || b_dl_sym(h, "stub_alsa_events", &events, sizeof(events)) == -1) {
+		printf("SKIP (stub ALSA not loaded)\n");
+		return 0;
+	}
+	/* Open the mixer unless an earlier test did. */
+	if (b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf)
+		test_wait_refresh();
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(buf[0] != '\0', "opened");
+	const int fd = mixer_fd();
+	CHECK(test_watched(fd), "fds of the card watched");
+	const unsigned int refreshes = test_refreshes;
+	unplug(1);
+	test_watches_dispatch(100);
+	CHECK(test_refreshes > refreshes, "removal refreshes the block");
+	CHECK(!test_watched(fd), "fds of the card no longer watched");
+	/* A spinning watch would handle events again. */
+	const unsigned int events_before = *events;
+	test_watches_dispatch(10);
+	CHECK(*events == events_before, "no events from the gone card");
+	CHECK(b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf, "empty while reopening");
+	test_wait_refresh();
+	CHECK(b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf, "card still gone");
+	/* Plugged back in, once the backoff is over. */
+	unplug(0);
+	g_time += B_DEFER_BACKOFF_MAX;
+	if (b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) == buf)
+		test_wait_refresh();
+	*b_write_speaker_vol(buf, sizeof(buf), NULL, &interval) = '\0';
+	CHECK(buf[0] != '\0', "reopened");
+	CHECK(test_watched(mixer_fd()), "watched again");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (needs USE_ALSA and USE_DLOPEN without USE_PULSE)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Edge 31 — procwatch moves to another instance on a rename          */
+/* ------------------------------------------------------------------ */
+
+static void
+test_procwatch_rename(int sig)
+{
+	prctl(PR_SET_NAME, "dwmb-test-pw3");
+	(void)sig;
+}
+
+static int
+test_procwatch_comm(void)
+{
+	printf("  [edge 31] procwatch follows another instance on rename ... ");
+	const int nfail_before = nfail;
+	const int id = b_procwatch_add(S_LITERAL("dwmb-test-pw2"), test_dummy_block);
+	CHECK(id != -1, "expected a watch id");
+	pid_t pids[2];
+	for (unsigned int i = 0; i < 2; ++i) {
+		pids[i] = fork();
+		if (pids[i] == 0) {
+			signal(SIGUSR1, test_procwatch_rename);
+			prctl(PR_SET_NAME, "dwmb-test-pw2");
+			for (;;)
+				pause();
+		}
+	}
+	unsigned int found = 0;
+	for (int i = 0; i < 50 && found != (unsigned int)pids[0] && found != (unsigned int)pids[1]; ++i) {
+		test_watches_dispatch(20);
+		++g_time;
+		found = b_procwatch_pid(id);
+	}
+	CHECK(found == (unsigned int)pids[0] || found == (unsigned int)pids[1], "expected a child's pid");
+	/* The tracked one is renamed, the other one keeps running. */
+	const pid_t other = found == (unsigned int)pids[0] ? pids[1] : pids[0];
+	kill((pid_t)found, SIGUSR1);
+	unsigned int now = found;
+	for (int i = 0; i < 50 && now != (unsigned int)other; ++i) {
+		test_watches_dispatch(20);
+		++g_time;
+		now = b_procwatch_pid(id);
+	}
+	CHECK(now == (unsigned int)other, "expected the pid of the other instance");
+	for (unsigned int i = 0; i < 2; ++i) {
+		kill(pids[i], SIGKILL);
+		waitpid(pids[i], NULL, 0);
+	}
+	if (nfail == nfail_before)
+		printf("PASS (%s)\n", b_procwatch_evented() ? "events" : "scan");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
 /* ------------------------------------------------------------------ */
 /*  main                                                              */
 /* ------------------------------------------------------------------ */
@@ -316,6 +1639,29 @@ main(void)
 	test_procfs_iterator();
 	test_u_strtoull10();
 	test_cpu_energy_wrap();
+	test_procwatch();
+	test_proc_fd_count();
+	test_hwmon();
+	test_temp_agg();
+	test_powercap();
+	test_prime();
+	test_defer();
+	test_dl();
+	test_gpu_sample();
+	test_gpu_drm();
+	test_gpu_sel();
+	test_alsa_watch();
+	test_alsa_shared();
+	test_pulse();
+	test_shell_spawn();
+	test_shell_persist();
+	test_shell_fields();
+	test_cat_watch();
+	test_fdpool_prefetch();
+	test_snapshot();
+	test_defer_waiters();
+	test_alsa_unplug();
+	test_procwatch_comm();
 
 	printf("\n%s: %s\n",
 	       nfail ? "FAIL" : "PASS",
@@ -0,0 +1,308 @@
+/* SPDX-License-Identifier: ISC */
+/* Copyright 2025-2026 James Tirta Halim <tirtajames45 at gmail dot com>
+ *
+ * Tests of the main loop: dwmblocks-fast.c is included with the blocks
+ * below in place of blocks.h.
+ *
+ * Tests:
+ *   1. Split of the first line into the fields
+ *   2. Layouts of fields rejected by b_init
+ *   3. Watches removed by the callback of another watch
+ *
+ * NOTE: b_init fails through DIE, which aborts, so each layout is
+ * checked in a child.
+ *
+ * Build:
+ *   cc -o tests/test-mainloop-bin tests/test-mainloop.c $(OBJS) $(REQ) $(LDFLAGS)
+ */
+
+#include "../config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../blocks-struct.h"
+#include "../blocks/shell.h"
+
+static char *
+test_block(char *dst, unsigned int dst_size, const char *unused, unsigned short *interval)
+{
+	*dst = '\0';
+	return dst;
+	(void)dst_size;
+	(void)unused;
+	(void)interval;
+}
+
+#define TEST_BLOCKS 10
+
+/* Used by dwmblocks-fast.c instead of the ones of blocks.h. */
+#define BLOCKS_H 1
+static g_block_ty g_blocks[TEST_BLOCKS];
+
+#define main g_main
+#include "../dwmblocks-fast.c"
+#undef main
+
+static int nfail;
+
+#define CHECK(cond, msg) do {                                   \
+        if (!(cond)) {                                          \
+                fprintf(stderr, "  FAIL  %s:%d: %s\n",          \
+                        __FILE__, __LINE__, msg);               \
+                ++nfail;                                        \
+        }                                                       \
+} while (0)
+
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+
+/* Fill g_blocks with the first n blocks of layout, followed by plain
+ * blocks, as blocks.h would. */
+static void
+test_layout(const g_block_ty *layout, unsigned int n)
+{
+	static const g_block_ty plain = { .func = test_block, .pad_left = "", .pad_right = "", .interval = 1 };
+	for (unsigned int i = 0; i < TEST_BLOCKS; ++i)
+		memcpy(&g_blocks[i], i < n ? &layout[i] : &plain, sizeof(g_blocks[0]));
+}
+
+/* Return 1 if g_getcmds_init accepts the blocks. */
+static int
+test_init_ok(void)
+{
+	const pid_t pid = fork();
+	if (pid == -1)
+		return -1;
+	if (pid == 0) {
+		/* Only the exit status matters. */
+		if (freopen("/dev/null", "w", stderr) == NULL)
+			_exit(2);
+		_exit(g_getcmds_init() == 0 ? 0 : 1);
+	}
+	int status;
+	while (waitpid(pid, &status, 0) == -1)
+		;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Return 1 if block i shows s. */
+static int
+test_shows(unsigned int i, const char *s)
+{
+	return B_STATUSBLOCKS_LEN(B_TOSTATUS(i)) == strlen(s)
+	       && !memcmp(g_statusblocks[B_TOSTATUS(i)], s, strlen(s));
+}
+
+/* Store s, with '|' for SHELL_FIELD_SEP, as the output of block i. */
+static void
+test_store(unsigned int i, const char *s)
+{
+	char buf[sizeof(g_statusblocks[0]) * G_FIELDS_MAX];
+	const size_t len = strlen(s);
+	for (size_t j = 0; j < len; ++j)
+		buf[j] = s[j] == '|' ? SHELL_FIELD_SEP : s[j];
+	g_status_changed = 0;
+	g_status_start_idx = LEN(g_blocks);
+	g_getcmd_store_fields(i, buf, buf + len);
+}
+
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Test 1 — split of the first line into the fields                   */
+/* ------------------------------------------------------------------ */
+
+static int
+test_fields_split(void)
+{
+	printf("  [test 1] output split into the fields                 ... ");
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+	const int nfail_before = nfail;
+	const g_block_ty layout[] = {
+		{ .func = b_write_shell_fields, .arg = "true", .pad_left = "", .pad_right = "", .interval = 5 },
+		{ .func = b_write_shell_field, .pad_left = "", .pad_right = "", .interval = 5 },
+		{ .func = b_write_shell_field, .pad_left = "", .pad_right = "", .interval = 5 },
+	};
+	test_layout(layout, LEN(layout));
+	CHECK(g_getcmds_init() == 0, "fields accepted");
+	/* Sorted after the plain blocks, which have a shorter interval. */
+	const unsigned int i = TEST_BLOCKS - LEN(layout);
+	CHECK(B_IS_FIELDS(i) && B_IS_FIELD(i + 1) && B_IS_FIELD(i + 2), "order of the group kept");
+	test_store(i, "a|b|c");
+	CHECK(test_shows(i, "a") && test_shows(i + 1, "b") && test_shows(i + 2, "c"), "one part per field");
+	CHECK(g_status_changed == 3, "every field marked");
+	test_store(i, "a|x|c");
+	CHECK(test_shows(i, "a") && test_shows(i + 1, "x") && test_shows(i + 2, "c"), "middle field updated");
+	CHECK(g_status_changed == 1 && g_status_start_idx == B_TOSTATUS(i + 1), "unchanged fields not marked");
+	test_store(i, "a|x|c");
+	CHECK(g_status_changed == 0, "same output not marked");
+	test_store(i, "a");
+	CHECK(test_shows(i, "a") && test_shows(i + 1, "") && test_shows(i + 2, ""), "missing fields empty");
+	test_store(i, "a|b|c|d");
+	CHECK(test_shows(i, "a") && test_shows(i + 1, "b") && test_shows(i + 2, "c"), "extra fields dropped");
+	test_store(i, "||c");
+	CHECK(test_shows(i, "") && test_shows(i + 1, "") && test_shows(i + 2, "c"), "empty fields");
+	char s[sizeof(g_statusblocks[0]) + 8];
+	memset(s, 'x', sizeof(s) - 1);
+	s[sizeof(s) - 1] = '\0';
+	test_store(i, s);
+	CHECK(B_STATUSBLOCKS_LEN(B_TOSTATUS(i)) == sizeof(g_statusblocks[0]) - 1, "long field cut");
+	CHECK(test_shows(i + 1, "") && test_shows(i + 2, ""), "fields after a long one empty");
+	CHECK(test_shows(i - 1, ""), "block before the group untouched");
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (no popen)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Test 2 — layouts of fields rejected by b_init                      */
+/* ------------------------------------------------------------------ */
+
+static int
+test_fields_init(void)
+{
+	printf("  [test 2] b_init checks the layout of the fields       ... ");
+#if defined HAVE_POPEN && defined HAVE_PCLOSE && defined HAVE_FILENO
+	const int nfail_before = nfail;
+	const g_block_ty fields = { .func = b_write_shell_fields, .arg = "true", .pad_left = "", .pad_right = "", .interval = 5, .signal = 3 };
+	const g_block_ty field = { .func = b_write_shell_field, .pad_left = "", .pad_right = "", .interval = 5, .signal = 3 };
+	const g_block_ty plain = { .func = test_block, .pad_left = "", .pad_right = "", .interval = 5, .signal = 3 };
+	const g_block_ty late = { .func = b_write_shell_field, .pad_left = "", .pad_right = "", .interval = 6, .signal = 3 };
+	const g_block_ty other_sig = { .func = b_write_shell_field, .pad_left = "", .pad_right = "", .interval = 5, .signal = 4 };
+	{
+		const g_block_ty layout[] = { fields, field, field };
+		test_layout(layout, LEN(layout));
+		CHECK(test_init_ok() == 1, "fields after their command");
+	}
+	{
+		const g_block_ty layout[] = { fields };
+		test_layout(layout, LEN(layout));
+		CHECK(test_init_ok() == 1, "command without fields");
+	}
+	{
+		const g_block_ty layout[] = { field };
+		test_layout(layout, LEN(layout));
+		CHECK(test_init_ok() == 0, "field without a command");
+	}
+	{
+		const g_block_ty layout[] = { fields, plain, field };
+		test_layout(layout, LEN(layout));
+		CHECK(test_init_ok() == 0, "field after another block");
+	}
+	{
+		/* Sorted apart from its command. */
+		const g_block_ty layout[] = { fields, late };
+		test_layout(layout, LEN(layout));
+		CHECK(test_init_ok() == 0, "field with another interval");
+	}
+	{
+		const g_block_ty layout[] = { fields, other_sig };
+		test_layout(layout, LEN(layout));
+		CHECK(test_init_ok() == 0, "field with another signal");
+	}
+	{
+		g_block_ty layout[G_FIELDS_MAX + 1];
+		memcpy(&layout[0], &fields, sizeof(layout[0]));
+		for (unsigned int j = 1; j < LEN(layout); ++j)
+			memcpy(&layout[j], &field, sizeof(layout[0]));
+		test_layout(layout, G_FIELDS_MAX);
+		CHECK(test_init_ok() == 1, "G_FIELDS_MAX blocks");
+		test_layout(layout, G_FIELDS_MAX + 1);
+		CHECK(test_init_ok() == 0, "over G_FIELDS_MAX blocks");
+	}
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+#else
+	printf("SKIP (no popen)\n");
+#endif
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Test 3 — watches removed by the callback of another watch          */
+/* ------------------------------------------------------------------ */
+
+/* Read ends of the pipes of the watches, and the calls of each. */
+static int test_fds[3];
+static unsigned int test_calls[3];
+
+/* Remove every other watch, as a removed ALSA card does. */
+static int
+test_watch_cb(int fd, void *data)
+{
+	const unsigned int idx = (unsigned int)(size_t)data;
+	++test_calls[idx];
+	char c;
+	if (read(fd, &c, 1) == -1 && errno != EAGAIN)
+		return -1;
+	if (idx == 1)
+		for (unsigned int i = 0; i < 3; ++i)
+			if (i != idx)
+				g_watch_del(test_fds[i]);
+	return 0;
+}
+
+static int
+test_watches_del(void)
+{
+	printf("  [test 3] a callback removes other watches             ... ");
+	const int nfail_before = nfail;
+	int pipes[3][2];
+	for (unsigned int i = 0; i < 3; ++i) {
+		if (pipe(pipes[i]) == -1) {
+			printf("SKIP (no pipe)\n");
+			return 0;
+		}
+		/* A second dispatch reads nothing instead of blocking. */
+		fcntl(pipes[i][0], F_SETFL, O_NONBLOCK);
+		test_fds[i] = pipes[i][0];
+		CHECK(g_watch_add(test_fds[i], test_watch_cb, (void *)(size_t)i) == 0, "watched");
+		CHECK(write(pipes[i][1], "", 1) == 1, "readable");
+	}
+	/* Dispatched backwards: 2, then 1, whose removals move 1 itself
+	 * into the slot of 0, with its fd still set from pselect. */
+	CHECK(g_sleep(1) == 0, "slept");
+	CHECK(test_calls[2] == 1, "watch dispatched once");
+	CHECK(test_calls[1] == 1, "moved watch dispatched once");
+	CHECK(test_calls[0] == 0, "removed watch not dispatched");
+	CHECK(g_watches_len == 1 && g_watches[0].fd == test_fds[1], "only the removing watch left");
+	g_watch_del(test_fds[1]);
+	for (unsigned int i = 0; i < 3; ++i) {
+		close(pipes[i][0]);
+		close(pipes[i][1]);
+	}
+	if (nfail == nfail_before)
+		printf("PASS\n");
+	else
+		printf("FAIL\n");
+	return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  main                                                              */
+/* ------------------------------------------------------------------ */
+
+int
+main(void)
+{
+	printf("dwmblocks-fast main loop tests\n");
+	printf("==============================\n\n");
+
+	test_fields_split();
+	test_fields_init();
+	test_watches_del();
+
+	printf("\n%s: %s\n",
+	       nfail ? "FAIL" : "PASS",
+	       nfail ? "some main loop tests failed" : "all main loop tests passed");
+	return nfail ? 1 : 0;
+}